@@ -60,6 +60,7 @@ static struct option long_options[] = { { "help", 0, 0, 'h' },
                                         { "iterations", 1, 0, 'i' },
                                         { "checkpoint_infile", 1, 0, 'c' },
                                         { "checkpoint_outfile", 1, 0, 'C' },
+                                        { "geometry_image", 1, 0, 'S' },
                                         { "logfile", 1, 0, 'l' },
                                         { "logfreq", 1, 0, 'f' },
                                         { "errfile", 1, 0, 'e' },
@@ -68,6 +69,13 @@ static struct option long_options[] = { { "help", 0, 0, 'h' },
                                         { "dump", 1, 0, 'd'},
                                         { "quiet", 0, 0, 'q' },
                                         { "with_checks", 1, 0, 'w' },
+                                        { "tune_partitions", 0, 0, 't' },
+                                        { "aggregate_unimolecular", 0, 0, 'u' },
+                                        { "mixed_species", 1, 0, 'm' },
+                                        { "lazy_tracers", 0, 0, 'p' },
+                                        { "auto_time_step", 1, 0, 'A' },
+                                        { "group_diffusion", 0, 0, 'B' },
+                                        { "mesh_cache_mb", 1, 0, 'M' },
                                         { "rules", 1, 0, 'r'},
                                         { NULL, 0, 0, 0 } };
 
@@ -91,11 +99,19 @@ void print_usage(FILE *f, char const *argv0) {
       "     [-errfile err_file_name] send errors log to file (default: stderr)\n"
       "     [-checkpoint_infile checkpoint_file_name]   read checkpoint file\n"
       "     [-checkpoint_outfile checkpoint_file_name]  write checkpoint file\n"
+      "     [-geometry_image image_file_name]  reuse waypoints and wall checks from image file (created if missing)\n"
       "     [-z_options opt_int]     additional visualization options (defaults to 0 which is none)\n"
       "     [-bond_angle angle]      bond angle to use for all bonds (defaults to 0)\n"
       "     [-dump level]            print additional information based on level (0 is none, >0 is more)\n"
       "     [-quiet]                 suppress all unrequested output except for errors\n"
       "     [-with_checks ('yes'/'no', default 'yes')]   performs check of the geometry for coincident walls\n"
+      "     [-tune_partitions]       choose automatic partitions by cost model and suggest spacing after the run\n"
+      "     [-aggregate_unimolecular] advance non-diffusing molecules with only unimolecular reactions per population\n"
+      "     [-mixed_species species,...] hold the listed volume species as counts in subvolumes without walls\n"
+      "     [-lazy_tracers]          move molecules of species nothing reacts with, counts or visualizes only when needed\n"
+      "     [-auto_time_step max_prob[,max_step_fraction]]  pick time steps per species from accuracy targets\n"
+      "     [-group_diffusion]       move volume molecules away from walls in groups per species and subvolume\n"
+      "     [-mesh_cache_mb n]       memory for meshes kept between dynamic geometry events (default: 64, 0 is none)\n"
       "     [-rules rules_file_name] run in MCell-R mode\n"
       "\n");
 }
@@ -165,6 +181,74 @@ int argparse_init(int argc, char *const argv[], struct volume *vol) {
       vol->quiet_flag = 1;
       break;
 
+    case 't': /* -tune_partitions */
+      vol->tune_partitions_flag = 1;
+      break;
+
+    case 'u': /* -aggregate_unimolecular */
+      vol->aggregate_unimol_flag = 1;
+      break;
+
+    case 'A': /* -auto_time_step */
+      vol->auto_max_rxn_prob = strtod(optarg, &endptr);
+      if (endptr == optarg || vol->auto_max_rxn_prob <= 0) {
+        argerror("Maximum reaction probability must be a positive number: %s",
+                 optarg);
+        return 1;
+      }
+      if (*endptr == ',') {
+        char *fraction = endptr + 1;
+        vol->auto_max_step_fraction = strtod(fraction, &endptr);
+        if (endptr == fraction || vol->auto_max_step_fraction <= 0) {
+          argerror("Maximum step fraction must be a positive number: %s",
+                   optarg);
+          return 1;
+        }
+      }
+      if (*endptr != '\0') {
+        argerror("Automatic time step targets must be max_prob or "
+                 "max_prob,max_step_fraction: %s", optarg);
+        return 1;
+      }
+      break;
+
+    case 'p': /* -lazy_tracers */
+      vol->lazy_tracers_flag = 1;
+      break;
+
+    case 'B': /* -group_diffusion */
+      vol->group_diffusion_flag = 1;
+      break;
+
+    case 'M': /* -mesh_cache_mb */
+      vol->mesh_cache_max_bytes = strtoll(optarg, &endptr, 0);
+      if (endptr == optarg || *endptr != '\0') {
+        argerror("Mesh cache size must be an integer: %s", optarg);
+        return 1;
+      }
+      if (vol->mesh_cache_max_bytes < 0) {
+        argerror("Mesh cache size %lld is less than 0",
+                 vol->mesh_cache_max_bytes);
+        return 1;
+      }
+      vol->mesh_cache_max_bytes *= 1024 * 1024;
+      break;
+
+    case 'm': /* -mixed_species */
+      if (vol->well_mixed_names != NULL) {
+        argerror("-mixed_species argument specified more than once: %s",
+                 optarg);
+        return 1;
+      }
+      vol->well_mixed_names = strdup(optarg);
+      if (vol->well_mixed_names == NULL) {
+        argerror("File '%s', Line %u: Out of memory while parsing "
+                 "command-line arguments: %s\n",
+                 __FILE__, __LINE__, optarg);
+        return 1;
+      }
+      break;
+
     case 'd': /* -dump */
       vol->dump_level = strtol(optarg, &endptr, 0);
       if (endptr == optarg || *endptr != '\0') {
@@ -277,6 +361,16 @@ int argparse_init(int argc, char *const argv[], struct volume *vol) {
       vol->chkpt_flag = 1;
       break;
 
+    case 'S': /* -geometry_image */
+      vol->startup_image_file = strdup(optarg);
+      if (vol->startup_image_file == NULL) {
+        argerror("File '%s', Line %u: Out of memory while parsing "
+                 "command-line arguments: %s\n",
+                 __FILE__, __LINE__, optarg);
+        return 1;
+      }
+      break;
+
     case 'r': /* nfsim */
       vol->nfsim_flag = 1;
       rules_xml_file = strdup(optarg);
@@ -33,6 +33,7 @@
 
 #include <assert.h>
 #include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -58,12 +59,6 @@ static int instantiate_count_request(
 static struct counter *create_new_counter(struct region *where, void *who,
   byte what, struct periodic_image *img, struct mem_helper *counter_mem);
 
-/* Pare down the region lists, annihilating any regions which appear in both
- * lists. */
-static void clean_region_lists(struct subvolume *my_sv,
-                               struct region_list **p_all_regs,
-                               struct region_list **p_all_antiregs);
-
 /* Check if the object corresponding to a particular symbol has been referenced
  * directly or indirectly from one of the INSTANTIATE blocks in the model.
  */
@@ -383,6 +378,88 @@ void count_region_border_update(struct volume *world, struct species *sp,
   } /* end for (hd...) */
 }
 
+/*************************************************************************
+trace_enclosing_regions:
+   In: world: simulation state
+       loc: location to find the enclosing regions of
+       my_wall: wall the location lies on (may be NULL)
+       skip_my_wall: nonzero if crossings of my_wall should be ignored
+       all_regs: bits to fill with the counted regions entered from outside
+       all_antiregs: bits to fill with the counted regions exited from inside
+   Out: No return value.  Starting from the nearest waypoint, all_regs and
+        all_antiregs are filled in with the enclosed-counting regions that
+        contain loc (all_regs) or that were left on the way (all_antiregs).
+   Note: Waypoints must have been placed.
+*************************************************************************/
+static void trace_enclosing_regions(struct volume *world, struct vector3 *loc,
+                                    struct wall *my_wall, int skip_my_wall,
+                                    struct bit_array *all_regs,
+                                    struct bit_array *all_antiregs) {
+  double t_hit, t_sv_hit;
+  struct vector3 delta, hit; /* For raytracing */
+
+  const int this_sv = (int)(find_coarse_subvol(world, loc) - world->subvol);
+  struct waypoint *wp = &(world->waypoints[this_sv]);
+
+  struct vector3 here = {.x = wp->loc.x, .y = wp->loc.y, .z = wp->loc.z};
+
+  /* Start from the regions known at the nearest waypoint, and the
+   * antiregions (regions crossed from inside to outside only) */
+  set_all_bits(all_regs, 0);
+  set_all_bits(all_antiregs, 0);
+  if (wp->region_bits != NULL)
+    bit_operation(all_regs, wp->region_bits, '|');
+  if (wp->antiregion_bits != NULL)
+    bit_operation(all_antiregs, wp->antiregion_bits, '|');
+
+  /* No counted walls in this subvolume, so the waypoint already knows */
+  if (wp->boundary_bits == NULL)
+    return;
+
+  /* Raytrace across any walls from waypoint to us and add to region lists */
+  for (struct subvolume *sv = &(world->subvol[this_sv]); sv != NULL;
+       sv = next_subvol(&here, &delta, sv, world->x_fineparts,
+                        world->y_fineparts, world->z_fineparts)) {
+    delta.x = loc->x - here.x;
+    delta.y = loc->y - here.y;
+    delta.z = loc->z - here.z;
+
+    t_sv_hit = collide_sv_time(&here, &delta, sv, world->x_fineparts,
+                               world->y_fineparts, world->z_fineparts);
+    if (t_sv_hit > 1.0)
+      t_sv_hit = 1.0;
+
+    for (struct wall_list *wl = sv->wall_head; wl != NULL; wl = wl->next) {
+      /* Skip wall that we are on unless we're a volume molecule */
+      if (skip_my_wall && my_wall == wl->this_wall) {
+        continue;
+      }
+
+      if (wl->this_wall->flags & (COUNT_CONTENTS | COUNT_ENCLOSED)) {
+        int hit_code = collide_wall(&here, &delta, wl->this_wall, &t_hit,
+                                    &hit, 0, world->rng, world->notify,
+                                    &(world->ray_polygon_tests));
+        if (hit_code == COLLIDE_MISS) {
+          continue;
+        }
+
+        world->ray_polygon_colls++;
+        if ((hit_code == COLLIDE_FRONT || hit_code == COLLIDE_BACK) &&
+            t_hit <= t_sv_hit && (hit.x - loc->x) * delta.x +
+            (hit.y - loc->y) * delta.y + (hit.z - loc->z) * delta.z < 0) {
+          for (struct region_list *rl = wl->this_wall->counting_regions;
+               rl != NULL; rl = rl->next) {
+            if ((rl->reg->flags & (COUNT_CONTENTS | COUNT_ENCLOSED)) != 0) {
+              add_crossed_region(all_regs, all_antiregs,
+                                 rl->reg->counting_index, hit_code);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
 /*************************************************************************
 count_region_from_scratch:
    In: world: simulation state 
@@ -398,8 +475,9 @@ count_region_from_scratch:
    Note: At least one of molecule or rxn pathname must be non-NULL; if other
          inputs are NULL, sensible values will be guessed (which may themselves
          be NULL). This routine is not super-fast for volume counts (enclosed
-         counts) since it has to dynamically create and test lists of enclosing
-         regions.
+         counts) since it has to raytrace from the nearest waypoint; the
+         enclosing regions are tracked as bit arrays indexed by
+         counting_index.
 *************************************************************************/
 void count_region_from_scratch(struct volume *world,
                                struct abstract_molecule *am,
@@ -409,12 +487,10 @@ void count_region_from_scratch(struct volume *world,
                                struct wall *my_wall,
                                double t,
                                struct periodic_image *periodic_box) {
-  struct region_list *rl, *arl, *nrl, *narl; /*a=anti n=new*/
+  struct region_list *rl;
   struct counter *c;
   void *target; /* what we're counting: am->properties or rxpn */
   int hashval;  /* Hash value of what we're counting */
-  double t_hit, t_sv_hit;
-  struct vector3 delta, hit; /* For raytracing */
   struct vector3 xyz_loc;          /* Computed location of mol if loc==NULL */
   byte count_flags;
   int pos_or_neg;        /* Sign of count (neg for antiregions) */
@@ -499,121 +575,27 @@ void count_region_from_scratch(struct volume *world,
    * enclosed--hard!!*/
   if (am == NULL || (am->properties->flags & COUNT_ENCLOSED) != 0 ||
       (am->properties->flags & NOT_FREE) == 0) {
-    const int px = bisect(world->x_partitions, world->nx_parts, loc->x);
-    const int py = bisect(world->y_partitions, world->ny_parts, loc->y);
-    const int pz = bisect(world->z_partitions, world->nz_parts, loc->z);
-    const int this_sv =
-        pz + (world->nz_parts - 1) * (py + (world->ny_parts - 1) * px);
-    struct waypoint *wp = &(world->waypoints[this_sv]);
-    struct subvolume *my_sv = &(world->subvol[this_sv]);
-
-    struct vector3 here = {.x = wp->loc.x, .y = wp->loc.y, .z = wp->loc.z};
-
-    struct region_list *all_regs = NULL;
-    struct region_list *all_antiregs = NULL;
-
-    /* Copy all the potentially relevant regions from the nearest waypoint */
-    for (rl = wp->regions; rl != NULL; rl = rl->next) {
-      if (rl->reg == NULL)
-        continue;
-      int hash_bin = (hashval + rl->reg->hashval) & world->count_hashmask;
-      if (world->count_hash[hash_bin] == NULL)
-        continue; /* Won't count on this region so ignore it */
-
-      nrl = (struct region_list *)CHECKED_MEM_GET(
-          my_sv->local_storage->regl, "list of enclosing regions for count");
-      nrl->reg = rl->reg;
-      nrl->next = all_regs;
-      all_regs = nrl;
-    }
-
-    /* And all the antiregions (regions crossed from inside to outside only) */
-    for (arl = wp->antiregions; arl != NULL; arl = arl->next) {
-      int hash_bin = (hashval + arl->reg->hashval) & world->count_hashmask;
-      if (world->count_hash[hash_bin] == NULL)
-        continue; /* Won't count on this region so ignore it */
-
-      narl = (struct region_list *)CHECKED_MEM_GET(
-          my_sv->local_storage->regl, "list of enclosing regions for count");
-      narl->reg = arl->reg;
-      narl->next = all_antiregs;
-      all_antiregs = narl;
-    }
-
-    /* Raytrace across any walls from waypoint to us and add to region lists */
-    for (struct subvolume *sv = &(world->subvol[this_sv]); sv != NULL;
-         sv = next_subvol(&here, &delta, sv, world->x_fineparts,
-                          world->y_fineparts, world->z_fineparts,
-                          world->ny_parts, world->nz_parts)) {
-      delta.x = loc->x - here.x;
-      delta.y = loc->y - here.y;
-      delta.z = loc->z - here.z;
-
-      t_sv_hit = collide_sv_time(&here, &delta, sv, world->x_fineparts,
-                                 world->y_fineparts, world->z_fineparts);
-      if (t_sv_hit > 1.0)
-        t_sv_hit = 1.0;
-
-      for (struct wall_list *wl = sv->wall_head; wl != NULL; wl = wl->next) {
-        /* Skip wall that we are on unless we're a volume molecule */
-        if (my_wall == wl->this_wall &&
-            (am == NULL || (am->properties->flags & NOT_FREE))) {
-          continue;
-        }
-
-        if (wl->this_wall->flags & (COUNT_CONTENTS | COUNT_ENCLOSED)) {
-          int hit_code = collide_wall(&here, &delta, wl->this_wall, &t_hit,
-                                      &hit, 0, world->rng, world->notify,
-                                      &(world->ray_polygon_tests));
-          if (hit_code == COLLIDE_MISS) {
-            continue;
-          }
-
-          world->ray_polygon_colls++;
-          if (t_hit <= t_sv_hit && (hit.x - loc->x) * delta.x +
-            (hit.y - loc->y) * delta.y + (hit.z - loc->z) * delta.z < 0) {
-            for (rl = wl->this_wall->counting_regions; rl != NULL;
-                 rl = rl->next) {
-              if ((rl->reg->flags & (COUNT_CONTENTS | COUNT_ENCLOSED)) != 0) {
-                int hash_bin =
-                    (hashval + rl->reg->hashval) & world->count_hashmask;
-                if (world->count_hash[hash_bin] == NULL) {
-                  continue; /* Won't count on this region so ignore it */
-                }
-                nrl = (struct region_list *)CHECKED_MEM_GET(
-                    my_sv->local_storage->regl,
-                    "list of enclosing regions for count");
-                nrl->reg = rl->reg;
-                if (hit_code == COLLIDE_FRONT) {
-                  nrl->next = all_regs;
-                  all_regs = nrl;
-                } else if (hit_code == COLLIDE_BACK) {
-                  nrl->next = all_antiregs;
-                  all_antiregs = nrl;
-                }
-              }
-            }
-          }
-        }
-      }
-    }
-
-    /* Clean up region lists */
-    if (all_regs != NULL && all_antiregs != NULL)
-      clean_region_lists(my_sv, &all_regs, &all_antiregs);
+    struct bit_array *all_regs = world->regions_in_scratch;
+    struct bit_array *all_antiregs = world->regions_out_scratch;
+    trace_enclosing_regions(world, loc, my_wall,
+                            (am == NULL || (am->properties->flags & NOT_FREE)),
+                            all_regs, all_antiregs);
 
     /* Actually check the regions here */
     count_flags |= REPORT_ENCLOSED;
 
-    for (nrl = all_regs; nrl != NULL; nrl = (nrl == all_regs) ? all_antiregs : NULL)
+    for (struct bit_array *bits = all_regs; bits != NULL;
+         bits = (bits == all_regs) ? all_antiregs : NULL)
     /* Trick so we don't need to duplicate this code */ {
-      if (nrl == all_regs) {
+      if (bits == all_regs) {
         pos_or_neg = 1;
       } else {
         pos_or_neg = -1;
       }
-      for (rl = nrl; rl != NULL; rl = rl->next) {
-        int hash_bin = (hashval + rl->reg->hashval) & world->count_hashmask;
+      for (int idx = next_set_bit(bits, 0); idx >= 0;
+           idx = next_set_bit(bits, idx + 1)) {
+        struct region *reg = world->counting_region_index[idx];
+        int hash_bin = (hashval + reg->hashval) & world->count_hashmask;
         for (c = world->count_hash[hash_bin]; c != NULL; c = c->next) {
           if (am != NULL
               && !periodic_boxes_are_identical(c->periodic_box, periodic_box)) {
@@ -623,12 +605,12 @@ void count_region_from_scratch(struct volume *world,
               && !periodic_boxes_are_identical(c->periodic_box, periodic_box)) {
             continue;
           }
-          if (c->target == target && c->reg_type == rl->reg &&
+          if (c->target == target && c->reg_type == reg &&
               ((c->counter_type & ENCLOSING_COUNTER) != 0 ||
                (am != NULL && (am->properties->flags & ON_GRID) == 0)) &&
               (my_wall == NULL ||
                (am != NULL && (am->properties->flags & NOT_FREE) == 0) ||
-               !region_listed(my_wall->counting_regions, rl->reg))) {
+               !wall_in_counting_region(my_wall, reg))) {
             if (c->counter_type & TRIG_COUNTER) {
               c->data.trig.t_event = t;
               c->data.trig.orient = orient;
@@ -654,13 +636,182 @@ void count_region_from_scratch(struct volume *world,
         }
       }
     }
+  }
+}
 
-    /* Free region memory */
-    if (all_regs != NULL)
-      mem_put_list(my_sv->local_storage->regl, all_regs);
-    if (all_antiregs != NULL)
-      mem_put_list(my_sv->local_storage->regl, all_antiregs);
+/*************************************************************************
+compare_batched_molecules:
+   In: two pointers to volume molecule pointers
+   Out: Sort order for qsort: molecules are grouped by species, then by
+        periodic image, then by subvolume.
+*************************************************************************/
+static int compare_batched_molecules(void const *a, void const *b) {
+  struct volume_molecule const *vm1 = *(struct volume_molecule *const *)a;
+  struct volume_molecule const *vm2 = *(struct volume_molecule *const *)b;
+
+  if (vm1->properties != vm2->properties)
+    return ((uintptr_t)vm1->properties < (uintptr_t)vm2->properties) ? -1 : 1;
+  if (vm1->periodic_box->x != vm2->periodic_box->x)
+    return (vm1->periodic_box->x < vm2->periodic_box->x) ? -1 : 1;
+  if (vm1->periodic_box->y != vm2->periodic_box->y)
+    return (vm1->periodic_box->y < vm2->periodic_box->y) ? -1 : 1;
+  if (vm1->periodic_box->z != vm2->periodic_box->z)
+    return (vm1->periodic_box->z < vm2->periodic_box->z) ? -1 : 1;
+  if (vm1->subvol != vm2->subvol)
+    return ((uintptr_t)vm1->subvol < (uintptr_t)vm2->subvol) ? -1 : 1;
+  return 0;
+}
+
+/*************************************************************************
+flush_enclosed_counts:
+   In: world: simulation state
+       sp: species being counted
+       periodic_box: periodic image the molecules are in
+       delta: net change in enclosed count, indexed by counting_index
+       touched: bits of the entries of delta that may be nonzero
+   Out: No return value.  Enclosed counters of sp are updated by delta and
+        delta and touched are cleared.
+*************************************************************************/
+static void flush_enclosed_counts(struct volume *world, struct species *sp,
+                                  struct periodic_image *periodic_box,
+                                  int *delta, struct bit_array *touched) {
+  for (int idx = next_set_bit(touched, 0); idx >= 0;
+       idx = next_set_bit(touched, idx + 1)) {
+    if (delta[idx] == 0)
+      continue;
+
+    struct region *reg = world->counting_region_index[idx];
+    int hash_bin = (sp->hashval + reg->hashval) & world->count_hashmask;
+    for (struct counter *c = world->count_hash[hash_bin]; c != NULL;
+         c = c->next) {
+      if (c->target == sp && c->reg_type == reg &&
+          (c->counter_type & TRIG_COUNTER) == 0 &&
+          periodic_boxes_are_identical(c->periodic_box, periodic_box)) {
+        c->data.move.n_enclosed += delta[idx];
+      }
+    }
+    delta[idx] = 0;
+  }
+  set_all_bits(touched, 0);
+}
+
+/*************************************************************************
+count_volume_molecules_from_scratch:
+   In: world: simulation state
+       mols: array of newly placed volume molecules to count
+       n_mols: number of molecules in the array
+   Out: No return value.  Appropriate counters are updated and triggers are
+        fired, exactly as if count_region_from_scratch had been called for
+        each molecule with n=1.  The array is reordered.
+   Note: Molecules are grouped by species, periodic image and subvolume so
+         that neighbouring traces start from the same waypoint, and the
+         enclosed counts of each group are summed per region before being
+         added to the counters.  Species with triggers are counted one
+         molecule at a time, since triggers need each location.
+*************************************************************************/
+void count_volume_molecules_from_scratch(struct volume *world,
+                                         struct volume_molecule **mols,
+                                         int n_mols) {
+  if (n_mols <= 0)
+    return;
+
+  if (!world->place_waypoints_flag || world->n_counting_regions == 0) {
+    for (int i = 0; i < n_mols; i++) {
+      count_region_from_scratch(world, (struct abstract_molecule *)mols[i],
+                                NULL, 1, &(mols[i]->pos), NULL, mols[i]->t,
+                                mols[i]->periodic_box);
+    }
+    return;
+  }
+
+  qsort(mols, n_mols, sizeof(struct volume_molecule *),
+        compare_batched_molecules);
+
+  int *delta = CHECKED_MALLOC_ARRAY(int, world->n_counting_regions,
+                                    "enclosed count deltas");
+  memset(delta, 0, world->n_counting_regions * sizeof(int));
+  struct bit_array *touched = new_bit_array(world->n_counting_regions);
+  if (touched == NULL)
+    mcell_allocfailed("Failed to allocate enclosed count bits.");
+  set_all_bits(touched, 0);
+
+  struct bit_array *all_regs = world->regions_in_scratch;
+  struct bit_array *all_antiregs = world->regions_out_scratch;
+  for (int i = 0; i < n_mols; i++) {
+    struct volume_molecule *vm = mols[i];
+    if (vm->properties->flags & COUNT_TRIGGER) {
+      count_region_from_scratch(world, (struct abstract_molecule *)vm, NULL, 1,
+                                &(vm->pos), NULL, vm->t, vm->periodic_box);
+      continue;
+    }
+
+    trace_enclosing_regions(world, &(vm->pos), NULL, 1, all_regs,
+                            all_antiregs);
+    for (int idx = next_set_bit(all_regs, 0); idx >= 0;
+         idx = next_set_bit(all_regs, idx + 1)) {
+      delta[idx]++;
+    }
+    for (int idx = next_set_bit(all_antiregs, 0); idx >= 0;
+         idx = next_set_bit(all_antiregs, idx + 1)) {
+      delta[idx]--;
+    }
+    bit_operation(touched, all_regs, '|');
+    bit_operation(touched, all_antiregs, '|');
+
+    /* End of a species/periodic image group */
+    if (i + 1 == n_mols || mols[i + 1]->properties != vm->properties ||
+        !periodic_boxes_are_identical(mols[i + 1]->periodic_box,
+                                      vm->periodic_box)) {
+      flush_enclosed_counts(world, vm->properties, vm->periodic_box, delta,
+                            touched);
+    }
   }
+
+  free_bit_array(touched);
+  free(delta);
+}
+
+/*************************************************************************
+count_batch_add:
+   In: cb: batch of molecules waiting to be counted
+       vm: newly placed volume molecule
+   Out: No return value.  The molecule is appended to the batch.
+*************************************************************************/
+void count_batch_add(struct count_batch *cb, struct volume_molecule *vm) {
+  if (cb->n_mols == cb->max_mols) {
+    int new_max = (cb->max_mols > 0) ? 2 * cb->max_mols : 1024;
+    struct volume_molecule **new_mols = (struct volume_molecule **)realloc(
+        cb->mols, new_max * sizeof(struct volume_molecule *));
+    if (new_mols == NULL)
+      mcell_allocfailed("Failed to grow batch of molecules to count.");
+    cb->mols = new_mols;
+    cb->max_mols = new_max;
+  }
+  cb->mols[cb->n_mols++] = vm;
+}
+
+/*************************************************************************
+count_batch_flush:
+   In: world: simulation state
+       cb: batch of molecules waiting to be counted
+   Out: No return value.  All molecules in the batch are counted and the
+        batch is emptied (its storage is kept for reuse).
+*************************************************************************/
+void count_batch_flush(struct volume *world, struct count_batch *cb) {
+  count_volume_molecules_from_scratch(world, cb->mols, cb->n_mols);
+  cb->n_mols = 0;
+}
+
+/*************************************************************************
+count_batch_destroy:
+   In: cb: batch of molecules waiting to be counted
+   Out: No return value.  The storage for the batch is freed.
+*************************************************************************/
+void count_batch_destroy(struct count_batch *cb) {
+  free(cb->mols);
+  cb->mols = NULL;
+  cb->n_mols = 0;
+  cb->max_mols = 0;
 }
 
 /*************************************************************************
@@ -801,7 +952,7 @@ void count_moved_surface_mol(
     /* Collect all the relevant regions we pass through */
     for (struct subvolume *sv = find_subvolume(world, &origin, NULL); sv != NULL;
          sv = next_subvol(&here, &delta, sv, world->x_fineparts, world->y_fineparts,
-          world->z_fineparts, world->ny_parts, world->nz_parts)) {
+          world->z_fineparts)) {
 
       int j = 0;
       for (struct wall_list *wl = sv->wall_head; wl != NULL; wl = wl->next) {
@@ -897,8 +1048,8 @@ void count_moved_surface_mol(
         if (c->target == sm->properties && c->reg_type == rl->reg &&
             (c->counter_type & ENCLOSING_COUNTER) != 0) {
 
-          assert(!region_listed(sm->grid->surface->counting_regions, rl->reg));
-          assert(!region_listed(sg->surface->counting_regions, rl->reg));
+          assert(!wall_in_counting_region(sm->grid->surface, rl->reg));
+          assert(!wall_in_counting_region(sg->surface, rl->reg));
 
           if (c->counter_type & TRIG_COUNTER) {
             c->data.trig.t_event = sm->t;
@@ -1158,8 +1309,7 @@ static int find_enclosing_regions(struct volume *world,
       traveling = 0;
     else {
       sv = next_subvol(&outside, &delta, sv, world->x_fineparts,
-                       world->y_fineparts, world->z_fineparts, world->ny_parts,
-                       world->nz_parts);
+                       world->y_fineparts, world->z_fineparts);
       delta.x = loc->x - outside.x;
       delta.y = loc->y - outside.y;
       delta.z = loc->z - outside.z;
@@ -1183,6 +1333,72 @@ static int find_enclosing_regions(struct volume *world,
   return 0;
 }
 
+/*************************************************************************
+set_waypoint_region_bits:
+   In: world: simulation state
+   Out: Returns 1 if malloc fails, 0 otherwise.
+        Converts the region and antiregion lists of every waypoint into bit
+        arrays indexed by counting_index, and records which counted regions
+        have walls in the waypoint's subvolume.  Neighboring waypoints
+        usually see the same regions, in which case they share the bit
+        array.
+*************************************************************************/
+int set_waypoint_region_bits(struct volume *world) {
+  struct bit_array *scratch = world->regions_in_scratch;
+  struct waypoint *prev = NULL;
+
+  for (int i = 0; i < world->n_waypoints; i++) {
+    struct waypoint *wp = &(world->waypoints[i]);
+    for (int anti = 0; anti < 2; anti++) {
+      struct region_list *rl = anti ? wp->antiregions : wp->regions;
+      struct bit_array **bits = anti ? &(wp->antiregion_bits) : &(wp->region_bits);
+      struct bit_array *prev_bits = NULL;
+      if (prev != NULL)
+        prev_bits = anti ? prev->antiregion_bits : prev->region_bits;
+
+      *bits = NULL;
+      if (rl == NULL)
+        continue;
+
+      set_all_bits(scratch, 0);
+      for (; rl != NULL; rl = rl->next) {
+        set_bit(scratch, rl->reg->counting_index, 1);
+      }
+      if (prev_bits != NULL && bit_array_equal(prev_bits, scratch)) {
+        *bits = prev_bits;
+      } else {
+        *bits = new_region_bits(world, anti ? wp->antiregions : wp->regions);
+        if (*bits == NULL)
+          return 1;
+      }
+    }
+
+    /* Counted regions with walls in this subvolume.  For every other region
+     * the whole subvolume is inside or outside, just like the waypoint. */
+    struct subvolume *sv = &(world->subvol[i]);
+    set_all_bits(scratch, 0);
+    for (struct wall_list *wl = sv->wall_head; wl != NULL; wl = wl->next) {
+      if (wl->this_wall->counting_region_bits != NULL)
+        bit_operation(scratch, wl->this_wall->counting_region_bits, '|');
+    }
+    wp->boundary_bits = NULL;
+    if (next_set_bit(scratch, 0) >= 0) {
+      if (prev != NULL && prev->boundary_bits != NULL &&
+          bit_array_equal(prev->boundary_bits, scratch)) {
+        wp->boundary_bits = prev->boundary_bits;
+      } else {
+        wp->boundary_bits = new_region_bits(world, NULL);
+        if (wp->boundary_bits == NULL)
+          return 1;
+        bit_operation(wp->boundary_bits, scratch, '|');
+      }
+    }
+    prev = wp;
+  }
+
+  return 0;
+}
+
 /*************************************************************************
 place_waypoints:
    In: world: simulation state
@@ -1281,6 +1497,9 @@ int place_waypoints(struct volume *world) {
     }
   }
 
+  if (set_waypoint_region_bits(world))
+    return 1;
+
   return 0;
 #undef W_Zb
 #undef W_Yb
@@ -1924,62 +2143,6 @@ static struct counter *create_new_counter(struct region *where, void *who,
   return c;
 }
 
-/*************************************************************************
-clean_region_lists:
-   Cleans the region and antiregion lists, annihilating any items which appear
-   on both lists.
-
-   In: my_sv: subvolume containing waypoint
-       p_all_regs: pointer to receive list of regions
-       p_all_antiregs: pointer to receive list of antiregions
-   Out: None
-*************************************************************************/
-static void clean_region_lists(struct subvolume *my_sv,
-                               struct region_list **p_all_regs,
-                               struct region_list **p_all_antiregs) {
-  if ((*p_all_regs)->next != NULL || (*p_all_antiregs)->next != NULL) {
-    struct region_list pre_sentry, pre_antisentry;
-    struct region_list *prl, *parl, *rl, *arl;
-
-    /* Sort by memory address to make mutual annihilation faster */
-    if ((*p_all_regs)->next != NULL)
-      *p_all_regs =
-          (struct region_list *)void_list_sort((struct void_list *)*p_all_regs);
-    if ((*p_all_antiregs)->next != NULL)
-      *p_all_antiregs = (struct region_list *)void_list_sort(
-          (struct void_list *)*p_all_antiregs);
-
-    /* Need previous entry to fix up list, so we'll make an imaginary one for
-     * 1st list element */
-    pre_sentry.next = *p_all_regs;
-    pre_antisentry.next = *p_all_antiregs;
-    prl = &pre_sentry;
-    parl = &pre_antisentry;
-
-    /* If we cross a region both ways, throw both out (once) */
-    for (rl = *p_all_regs, arl = *p_all_antiregs; rl != NULL && arl != NULL;
-         prl = rl, rl = rl->next, parl = arl, arl = arl->next) {
-      if (rl->reg == arl->reg) /* Mutual annihilation */
-      {
-        prl->next = rl->next;
-        parl->next = arl->next;
-        mem_put(my_sv->local_storage->regl, rl);
-        mem_put(my_sv->local_storage->regl, arl);
-        rl = prl;
-        arl = parl;
-      }
-    }
-    *p_all_regs = pre_sentry.next;
-    *p_all_antiregs = pre_antisentry.next;
-  } else if ((*p_all_regs)->reg == (*p_all_antiregs)->reg) {
-    /* Crossed one region both ways, toss them */
-    mem_put(my_sv->local_storage->regl, *p_all_regs);
-    mem_put(my_sv->local_storage->regl, *p_all_antiregs);
-    *p_all_regs = NULL;
-    *p_all_antiregs = NULL;
-  }
-}
-
 /*
  * function updating the hit counts during diffusion of a 2d
  * molecule if the latter hits a counted on region border on
@@ -50,6 +50,16 @@ void count_region_from_scratch(struct volume *world,
                                struct vector3 *loc, struct wall *my_wall,
                                double t, struct periodic_image *periodic_box);
 
+void count_volume_molecules_from_scratch(struct volume *world,
+                                         struct volume_molecule **mols,
+                                         int n_mols);
+
+void count_batch_add(struct count_batch *cb, struct volume_molecule *vm);
+
+void count_batch_flush(struct volume *world, struct count_batch *cb);
+
+void count_batch_destroy(struct count_batch *cb);
+
 void count_moved_surface_mol(struct volume *world, struct surface_molecule *sm,
   struct surface_grid *sg, struct vector2 *loc, int count_hashmask,
   struct counter **count_hash, long long *ray_polygon_colls,
@@ -60,6 +70,8 @@ void fire_count_event(struct volume *world, struct counter *event, int n,
 
 int place_waypoints(struct volume *world);
 
+int set_waypoint_region_bits(struct volume *world);
+
 int prepare_counters(struct volume *world);
 
 int check_counter_geometry(int count_hashmask, struct counter **count_hash,
@@ -26,6 +26,7 @@
 #include <assert.h>
 #include <math.h>
 #include <string.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 #include "diffuse.h"
@@ -37,6 +38,7 @@
 #include "wall_util.h"
 #include "react.h"
 #include "react_nfsim.h"
+#include "well_mixed.h"
 #include "nfsim_func.h"
 
 
@@ -381,8 +383,7 @@ struct vector3* reflect_periodic_2D(
   for (struct subvolume *sv = find_subvolume(state, origin_xyz, NULL);
        sv != NULL; sv = next_subvol(
           &updated_xyz, &delta_xyz, sv, state->x_fineparts, state->y_fineparts,
-          state->z_fineparts, state->ny_parts,
-          state->nz_parts)) {
+          state->z_fineparts)) {
 
     // Check all the walls in this subvolume
     for (struct wall_list *wl = sv->wall_head; wl != NULL; wl = wl->next) {
@@ -533,7 +534,7 @@ void reflect_absorb_inside_out(
 
   struct edge *this_edge = this_wall->edges[index_edge_was_hit];
 
-  if (is_wall_edge_region_border(this_wall, this_edge)) {
+  if (is_wall_edge_region_border(world, this_wall, this_edge)) {
     *this_wall_edge_region_border = 1;
   }
 
@@ -547,7 +548,7 @@ void reflect_absorb_inside_out(
 
   int nbr_wall_edge_region_border = 0;
   if (nbr_wall != NULL) {
-    if (is_wall_edge_region_border(nbr_wall, nbr_wall->edges[nbr_edge_ind])) {
+    if (is_wall_edge_region_border(world, nbr_wall, nbr_wall->edges[nbr_edge_ind])) {
       nbr_wall_edge_region_border = 1;
     }
   }
@@ -625,7 +626,7 @@ int reflect_absorb_outside_in(
   int target_edge_ind = find_shared_edge_index_of_neighbor_wall(this_wall, target_wall);
 
   int target_wall_edge_region_border = 0;
-  if (is_wall_edge_region_border(target_wall, target_wall->edges[target_edge_ind])) {
+  if (is_wall_edge_region_border(world, target_wall, target_wall->edges[target_edge_ind])) {
     target_wall_edge_region_border = 1;
   }
 
@@ -2322,6 +2323,92 @@ double safe_diffusion_step(struct volume_molecule *vm, struct collision *shead,
   return steps;
 }
 
+/****************************************************************************
+subvol_holds_partners:
+  In: world: simulation state
+      vm: molecule that is moving
+      sv: a subvolume
+  Out: 1 if sv holds a molecule other than vm which vm may react with, 0
+       otherwise
+****************************************************************************/
+static int subvol_holds_partners(struct volume *world,
+                                 struct volume_molecule *vm,
+                                 struct subvolume *sv) {
+  for (struct per_species_list *psl = sv->species_head; psl != NULL;
+       psl = psl->next) {
+    if (psl->properties == NULL || psl->head == NULL)
+      continue;
+    if (psl->head == vm && vm->next_v == NULL)
+      continue;
+    if (trigger_bimolecular_preliminary(
+            world->reaction_hash, world->rx_hashsize, vm->properties->hashval,
+            psl->properties->hashval, vm->properties, psl->properties))
+      return 1;
+  }
+  return 0;
+}
+
+/****************************************************************************
+empty_block_diffusion_step:
+  In: world: simulation state
+      vm: molecule that is moving
+      steps: number of steps found by safe_diffusion_step
+  Out: The number of diffusion steps this molecule can take, at the same
+       confidence level as safe_diffusion_step, if the 3x3x3 block of
+       subvolumes around its own holds no walls and no reaction partners;
+       otherwise steps. Within such a block the molecule may travel up to
+       the faces of the block, not just those of its own subvolume, so a
+       molecule in empty space fast-forwards over many timesteps with one
+       exact displacement.
+****************************************************************************/
+static double empty_block_diffusion_step(struct volume *world,
+                                         struct volume_molecule *vm,
+                                         double steps) {
+  struct subvolume *sv = vm->subvol;
+  if (sv->world_edge != 0 || (vm->properties->flags & EXTERNAL_SPECIES))
+    return steps;
+
+  int check_partners =
+      ((vm->properties->flags & (CAN_VOLVOL | CANT_INITIATE)) == CAN_VOLVOL);
+  int y_stride = world->nz_parts - 1;
+  int x_stride = y_stride * (world->ny_parts - 1);
+  for (int i = -1; i <= 1; i++) {
+    for (int j = -1; j <= 1; j++) {
+      for (int k = -1; k <= 1; k++) {
+        struct subvolume *nsv = sv + i * x_stride + j * y_stride + k;
+        if (nsv->wall_head != NULL)
+          return steps;
+        if (check_partners && subvol_holds_partners(world, vm, nsv))
+          return steps;
+      }
+    }
+  }
+
+  double d2_nearmax =
+      vm->get_space_step(vm) *
+      world->r_step[(int)(world->radial_subdivisions * MULTISTEP_PERCENTILE)];
+  d2_nearmax *= d2_nearmax;
+
+  double bounds[6] = {
+    vm->pos.x - world->x_fineparts[sv->neighbor[X_NEG]->llf.x],
+    world->x_fineparts[sv->neighbor[X_POS]->urb.x] - vm->pos.x,
+    vm->pos.y - world->y_fineparts[sv->neighbor[Y_NEG]->llf.y],
+    world->y_fineparts[sv->neighbor[Y_POS]->urb.y] - vm->pos.y,
+    vm->pos.z - world->z_fineparts[sv->neighbor[Z_NEG]->llf.z],
+    world->z_fineparts[sv->neighbor[Z_POS]->urb.z] - vm->pos.z
+  };
+  double d2min = GIGANTIC;
+  for (int i = 0; i < 6; i++) {
+    if (bounds[i] * bounds[i] < d2min)
+      d2min = bounds[i] * bounds[i];
+  }
+
+  double block_steps = sqrt(d2min / d2_nearmax);
+  if (block_steps < MULTISTEP_WORTHWHILE || block_steps < steps)
+    return steps;
+  return block_steps;
+}
+
 /****************************************************************************
 expand_collision_list_for_neighbor:
   This is a helper function to reduce duplicated code in expand_collision_list.
@@ -2907,6 +2994,20 @@ struct sp_collision *expand_collision_partner_list_for_neighbor(
   return shead1;
 }
 
+/* A diffusion step as drawn by compute_displacement */
+struct diffusion_step {
+  struct vector3 displacement;
+  struct vector3 displacement2;
+  double rate_factor;
+  double r_rate_factor;
+  double steps;
+  double t_steps;
+};
+
+static struct volume_molecule *diffuse_3D_from_step(
+    struct volume *world, struct volume_molecule *vm, double max_time,
+    struct diffusion_step *given);
+
 /*************************************************************************
 diffuse_3D:
   In: world: simulation state
@@ -2922,6 +3023,24 @@ struct volume_molecule *diffuse_3D(
     struct volume *world,
     struct volume_molecule *vm,
     double max_time) {
+  return diffuse_3D_from_step(world, vm, max_time, NULL);
+}
+
+/*************************************************************************
+diffuse_3D_from_step:
+  In: world: simulation state
+      vm: molecule that is moving
+      max_time: maximum time we can spend diffusing
+      given: step already drawn for this molecule by compute_displacement,
+             or NULL to draw one here
+  Out: As diffuse_3D. A given step must have been drawn for the molecule
+       as it is now, with no reaction partners in its subvolume.
+*************************************************************************/
+static struct volume_molecule *diffuse_3D_from_step(
+    struct volume *world,
+    struct volume_molecule *vm,
+    double max_time,
+    struct diffusion_step *given) {
 
   struct species* spec = vm->properties;
   if (spec == NULL) {
@@ -2956,6 +3075,15 @@ struct volume_molecule *diffuse_3D(
   double r_rate_factor = 1.0;
   struct vector3 displacement;  /* Molecule moves along this vector */
   struct vector3 displacement2; /* Used for 3D mol-mol unbinding */
+  if (given != NULL) {
+    calculate_displacement = 0;
+    steps = given->steps;
+    t_steps = given->t_steps;
+    rate_factor = given->rate_factor;
+    r_rate_factor = given->r_rate_factor;
+    displacement = given->displacement;
+    displacement2 = given->displacement2;
+  }
 
 pretend_to_call_diffuse_3D: ; /* Label to allow fake recursion */
 
@@ -3446,22 +3574,20 @@ react_2D_all_neighbors(struct volume *world, struct surface_molecule *sm,
   int num_matching_rxns = 0;
   struct rxn *matching_rxns[MAX_MATCHING_RXNS];
 
-  /* linked list of the tile neighbors */
-  struct tile_neighbor *tile_nbr_head = NULL, *curr;
-  int list_length = 0; /* length of the linked lists above */
+  /* the tile neighbors */
+  struct tile_ref *nbrs = NULL;
 
   if ((u_int)sm->grid_index >= sm->grid->n_tiles) {
     mcell_internal_error("tile index %u is greater or equal number_of_tiles %u",
                          (u_int)sm->grid_index, sm->grid->n_tiles);
   }
 
-  find_neighbor_tiles(world, sm, sm->grid, sm->grid_index, 0, 1, &tile_nbr_head,
-                      &list_length);
+  const int num_nbrs =
+      find_neighbor_tile_array(world, sm, sm->grid, sm->grid_index, &nbrs);
 
-  if (tile_nbr_head == NULL)
+  if (num_nbrs == 0)
     return sm; /* no reaction may happen */
 
-  const int num_nbrs = list_length;
   int max_size = num_nbrs * MAX_MATCHING_RXNS;
   struct rxn *rxn_array[max_size]; /* array of reaction objects with neighbor
                                      molecules */
@@ -3484,12 +3610,13 @@ react_2D_all_neighbors(struct volume *world, struct surface_molecule *sm,
   }
 
   /* step through the neighbors */
-  for (curr = tile_nbr_head; curr != NULL; curr = curr->next) {
+  for (int kk = 0; kk < num_nbrs; kk++) {
+    struct tile_ref *curr = &nbrs[kk];
     /* Neighboring molecule */
     struct surface_molecule_list *sm_list = curr->grid->sm_list[curr->idx]; 
     if (sm_list == NULL || sm_list->sm == NULL)
       continue;
-    struct surface_molecule *smp = curr->grid->sm_list[curr->idx]->sm;
+    struct surface_molecule *smp = sm_list->sm;
 
     /* check whether the neighbor molecule is behind
        the restrictive region boundary   */
@@ -3526,7 +3653,8 @@ react_2D_all_neighbors(struct volume *world, struct surface_molecule *sm,
 
       for (int jj = 0; jj < num_matching_rxns; jj++) {
         if (matching_rxns[jj] != NULL) {
-          if (matching_rxns[jj]->prob_t != NULL)
+          if (matching_rxns[jj]->prob_t != NULL &&
+              !matching_rxns[jj]->rate_changes_scheduled)
             update_probs(world, matching_rxns[jj], sm->t);
           rxn_array[l] = matching_rxns[jj];
           cf[l] = t / (curr->grid->binding_factor);
@@ -3539,8 +3667,6 @@ react_2D_all_neighbors(struct volume *world, struct surface_molecule *sm,
     }
   }
 
-  delete_tile_neighbor_list(tile_nbr_head);
-
   if (n == 0) {
     return sm; /* Nobody to react with */
   } else if (n == 1) {
@@ -3572,15 +3698,74 @@ react_2D_all_neighbors(struct volume *world, struct surface_molecule *sm,
   return sm;
 }
 
+/*************************************************************************
+reclaim_parked_molecule:
+  In: am: a molecule which was destroyed while parked outside the scheduler,
+          in a unimolecular pool or queue
+  Out: No return value. The molecule's memory is released once nothing else
+       refers to it, as when a defunct molecule leaves the scheduler.
+*************************************************************************/
+static void reclaim_parked_molecule(struct abstract_molecule *am) {
+  if ((am->flags & IN_MASK) == IN_SCHEDULE) {
+    am->next = NULL;
+    mem_put(am->birthplace, am);
+  } else
+    am->flags &= ~IN_SCHEDULE;
+}
+
+/*************************************************************************
+discard_parked_molecule:
+  In: local: local storage area the molecule was parked in
+      am: a molecule which was destroyed while parked in a unimolecular pool
+          or queue
+  Out: No return value. The molecule is reclaimed, and taken off the tally
+       of defunct molecules which its destruction added to.
+*************************************************************************/
+static void discard_parked_molecule(struct storage *local,
+                                    struct abstract_molecule *am) {
+  if (local->timer->defunct_count > 0)
+    local->timer->defunct_count--;
+  reclaim_parked_molecule(am);
+}
+
+static int is_defunct_queued_molecule(void *data) {
+  return ((struct abstract_molecule *)data)->properties == NULL;
+}
+
+static void dispose_queued_molecule(void *data) {
+  reclaim_parked_molecule((struct abstract_molecule *)data);
+}
+
 /*************************************************************************
 clean_up_old_molecules:
 
- This function just removes defunct molecules from the scheduler.
+ This function just removes defunct molecules from the scheduler, from
+ the unimolecular queue and from the unimolecular pools.
 *************************************************************************/
 void clean_up_old_molecules(struct storage *local) {
+  int n_pooled = 0;
+  for (struct unimol_pool *pool = local->unimol_pools; pool != NULL;
+       pool = pool->next)
+    n_pooled += pool->n_mols;
+
   if (local->timer->defunct_count > MIN_DEFUNCT_FOR_GC &&
-      MAX_DEFUNCT_FRAC * (local->timer->count) < local->timer->defunct_count) {
+      MAX_DEFUNCT_FRAC *
+              (local->timer->count + local->unimol_queue.count + n_pooled) <
+          local->timer->defunct_count) {
     struct abstract_molecule *am;
+    heap_cleanup(&local->unimol_queue, is_defunct_queued_molecule,
+                 dispose_queued_molecule);
+    for (struct unimol_pool *pool = local->unimol_pools; pool != NULL;
+         pool = pool->next) {
+      int n = 0;
+      for (int i = 0; i < pool->n_mols; i++) {
+        if (pool->mols[i]->properties == NULL)
+          reclaim_parked_molecule(pool->mols[i]);
+        else
+          pool->mols[n++] = pool->mols[i];
+      }
+      pool->n_mols = n;
+    }
     am = (struct abstract_molecule *)schedule_cleanup(local->timer,
                                                       *is_defunct_molecule);
     while (am != NULL) {
@@ -3637,6 +3822,567 @@ void reschedule_surface_molecules(
   }
 }
 
+/*************************************************************************
+can_aggregate_unimol:
+  In: state: simulation state
+      am: a molecule which was just taken out of the scheduler
+  Out: 1 if the molecule can join its species' unimolecular pool, i.e. it
+       cannot diffuse, is not clamped, takes part in no reaction other than
+       plain unimolecular ones, whose rates only change at iteration
+       boundaries, and will not react before the end of the current
+       iteration; 0 otherwise.
+  Note: A molecule surviving to the next iteration boundary has, from there
+        on, the same exponential lifetime as every other pool member, so
+        handing it to the pool keeps the kinetics exact.
+*************************************************************************/
+static int can_aggregate_unimol(struct volume *state,
+                                struct abstract_molecule *am) {
+  if (!state->aggregate_unimol_flag)
+    return 0;
+  if ((am->flags & (ACT_DIFFUSE | ACT_CLAMPED | ACT_REACT)) != ACT_REACT)
+    return 0;
+  if ((am->flags & ACT_NEWBIE) != 0)
+    return 0;
+  if ((am->get_flags(am) &
+       (CAN_VOLVOLVOL | CAN_VOLVOL | CAN_VOLSURF | CAN_VOLWALL | CAN_SURFSURF |
+        CAN_SURFWALL | CAN_VOLVOLSURF | CAN_VOLSURFSURF | CAN_SURFSURFSURF |
+        CAN_REGION_BORDER | EXTERNAL_SPECIES)) != 0)
+    return 0;
+  if (am->t + am->t2 < floor(am->t) + 1.0)
+    return 0;
+
+  // The pool reacts at a rate fixed for the whole iteration
+  struct rxn *rx = trigger_unimolecular(state->reaction_hash,
+                                        state->rx_hashsize,
+                                        am->properties->hashval, am);
+  return rx == NULL || rx->prob_t == NULL || rx->rate_changes_scheduled;
+}
+
+/*************************************************************************
+is_passive_tracer:
+  In: am: a molecule which was just taken out of the scheduler
+  Out: 1 if the molecule belongs to a passive tracer species and, as far as
+       its flags tell, still just diffuses; 0 otherwise. Reactions added
+       through the API after startup end the laziness of the species.
+*************************************************************************/
+static int is_passive_tracer(struct abstract_molecule *am) {
+  if ((am->properties->flags & PASSIVE_TRACER) == 0)
+    return 0;
+  if ((am->flags & (TYPE_VOL | ACT_DIFFUSE | ACT_REACT | ACT_CLAMPED)) !=
+      (TYPE_VOL | ACT_DIFFUSE))
+    return 0;
+  return (am->properties->flags &
+          (CAN_VOLVOLVOL | CAN_VOLVOL | CAN_VOLSURF | CAN_VOLWALL |
+           CAN_VOLVOLSURF | CAN_VOLSURFSURF)) == 0;
+}
+
+/*************************************************************************
+add_to_unimol_pool:
+  In: local: local storage area the molecule was scheduled in
+      am: molecule for which can_aggregate_unimol holds
+  Out: No return value. The molecule is added to the pool of its species in
+       this storage area, which is created if necessary.
+*************************************************************************/
+static void add_to_unimol_pool(struct storage *local,
+                               struct abstract_molecule *am) {
+  struct unimol_pool *pool;
+  for (pool = local->unimol_pools; pool != NULL; pool = pool->next) {
+    if (pool->properties == am->properties)
+      break;
+  }
+  if (pool == NULL) {
+    pool = CHECKED_MALLOC_STRUCT(struct unimol_pool, "unimolecular pool");
+    pool->properties = am->properties;
+    pool->mols = NULL;
+    pool->n_mols = 0;
+    pool->max_mols = 0;
+    pool->next = local->unimol_pools;
+    local->unimol_pools = pool;
+  }
+
+  if (pool->n_mols == pool->max_mols) {
+    int new_max = (pool->max_mols == 0) ? 16 : 2 * pool->max_mols;
+    struct abstract_molecule **new_mols = CHECKED_MALLOC_ARRAY(
+        struct abstract_molecule *, new_max, "unimolecular pool members");
+    if (pool->n_mols > 0)
+      memcpy(new_mols, pool->mols,
+             pool->n_mols * sizeof(struct abstract_molecule *));
+    free(pool->mols);
+    pool->mols = new_mols;
+    pool->max_mols = new_max;
+  }
+
+  am->t2 = 0;
+  am->flags &= ~ACT_CHANGE;
+  am->flags |= IN_SCHEDULE;
+  pool->mols[pool->n_mols++] = am;
+}
+
+/*************************************************************************
+run_unimol_pools:
+  In: state: simulation state
+      local: local storage area to use
+      t_start: start of the iteration
+      t_end: end of the iteration
+  Out: No return value. Every pool in the storage area is advanced to t_end
+       with Gillespie's direct method: the population reacts with total rate
+       n * k, and a uniformly chosen member undergoes each reaction. Members
+       which were destroyed from outside are weeded out when chosen, which
+       thins the event stream to the rate of the surviving members.
+       Products go to the scheduler as usual.
+  Note: Rates only change at iteration boundaries, so k is constant here.
+*************************************************************************/
+void run_unimol_pools(struct volume *state, struct storage *local,
+                      double t_start, double t_end) {
+  for (struct unimol_pool *pool = local->unimol_pools; pool != NULL;
+       pool = pool->next) {
+    if (pool->n_mols == 0)
+      continue;
+
+    // Look the reaction up by species, since any member may be defunct
+    struct rxn *rx =
+        state->reaction_hash[pool->properties->hashval &
+                             (state->rx_hashsize - 1)];
+    while (rx != NULL &&
+           (rx->n_reactants != 1 || rx->players[0] != pool->properties))
+      rx = rx->next;
+    if (rx == NULL || rx->max_fixed_p <= 0)
+      continue;
+
+    double t = t_start;
+    while (pool->n_mols > 0) {
+      double p = rng_dbl(state->rng);
+      if (!distinguishable(p, 0, EPS_C))
+        break;
+      t += -log(p) / (rx->max_fixed_p * pool->n_mols);
+      if (t >= t_end)
+        break;
+
+      int i = (int)(rng_dbl(state->rng) * pool->n_mols);
+      if (i >= pool->n_mols)
+        i = pool->n_mols - 1;
+      struct abstract_molecule *am = pool->mols[i];
+      pool->mols[i] = pool->mols[--pool->n_mols];
+
+      if (am->properties == NULL) {
+        discard_parked_molecule(local, am);
+        continue;
+      }
+
+      am->flags &= ~IN_SCHEDULE;
+      am->t = t;
+      int path = which_unimolecular(rx, am, state->rng);
+      if (outcome_unimolecular(state, rx, path, am, t) != RX_DESTROY)
+        add_to_unimol_pool(local, am);
+    }
+  }
+}
+
+/*************************************************************************
+wake_queued_molecules:
+  In: state: simulation state
+      local: local storage area to use
+      t_end: end of the iteration about to run
+  Out: No return value. Molecules in the unimolecular queue whose next
+       event falls before t_end are moved into the scheduler, where
+       run_timestep fires their reactions. Defunct molecules are reclaimed.
+*************************************************************************/
+void wake_queued_molecules(struct volume *state, struct storage *local,
+                           double t_end) {
+  struct abstract_molecule *am;
+  while ((am = (struct abstract_molecule *)heap_pop_before(
+              &local->unimol_queue, t_end, NULL)) != NULL) {
+    if (am->properties == NULL) {
+      discard_parked_molecule(local, am);
+      continue;
+    }
+    if (schedule_add(local->timer, am))
+      mcell_allocfailed("Failed to add a '%s' molecule to scheduler after "
+                        "leaving the unimolecular queue.",
+                        am->properties->sym->name);
+  }
+}
+
+/*************************************************************************
+catch_up_passive_tracer:
+  In: state: simulation state
+      vm: a passive tracer molecule, not in any scheduler
+      t_end: time up to which to move it
+  Out: the molecule, which may have been reallocated when crossing into
+       another storage area. The time it skipped while it was parked is
+       covered now, reflecting off walls as usual. Since it cannot react,
+       each step is as long as the distance to the nearest wall allows
+       (see compute_displacement), not bounded by the scheduler horizon.
+*************************************************************************/
+static struct volume_molecule *
+catch_up_passive_tracer(struct volume *state, struct volume_molecule *vm,
+                        double t_end) {
+  while (vm != NULL && vm->t < t_end) {
+    double max_time = t_end - vm->t;
+    if (max_time < EPS_C * (1.0 + t_end))
+      break;
+    vm = diffuse_3D(state, vm, max_time);
+  }
+  return vm;
+}
+
+/*************************************************************************
+tracer_needed:
+  In: spec: a passive tracer species
+      tracers: species whose passive tracers are needed, or NULL for all
+      n_tracers: number of species in tracers
+  Out: 1 if the molecules of spec must be brought up to date, 0 otherwise.
+*************************************************************************/
+static int tracer_needed(struct species *spec, struct species **tracers,
+                         int n_tracers) {
+  if (tracers == NULL)
+    return 1;
+  for (int i = 0; i < n_tracers; i++) {
+    if (tracers[i] == spec)
+      return 1;
+  }
+  return 0;
+}
+
+/*************************************************************************
+flush_parked_molecules:
+  In: state: simulation state
+      tracers: species whose passive tracers are needed too, or NULL to
+               flush the tracers of every species
+      n_tracers: number of species in tracers
+  Out: No return value. Every molecule parked outside the scheduler is put
+       back into it, and molecules held as well-mixed counts are placed
+       again, so code that needs every molecule (checkpoints, dynamic
+       geometry, rate changes through the API, volume output) sees
+       them all. Pooled molecules are flagged to pick a new lifetime at the
+       current iteration; queued molecules keep theirs, and passive tracers
+       first take the diffusion steps they skipped. Passive tracers of
+       species not asked for stay parked. Molecules are parked again the
+       next time they are scheduled.
+*************************************************************************/
+void flush_parked_molecules(struct volume *state, struct species **tracers,
+                            int n_tracers) {
+  release_well_mixed(state);
+
+  for (struct storage_list *sl = state->storage_head; sl != NULL;
+       sl = sl->next) {
+    struct storage *local = sl->store;
+    for (struct unimol_pool *pool = local->unimol_pools; pool != NULL;
+         pool = pool->next) {
+      for (int i = 0; i < pool->n_mols; i++) {
+        struct abstract_molecule *am = pool->mols[i];
+        if (am->properties == NULL) {
+          discard_parked_molecule(local, am);
+          continue;
+        }
+        if (am->t < state->current_iterations)
+          am->t = state->current_iterations;
+        am->t2 = 0;
+        am->flags |= ACT_NEWBIE;
+        if (schedule_add(local->timer, am))
+          mcell_allocfailed("Failed to add a '%s' molecule to scheduler "
+                            "after leaving its unimolecular pool.",
+                            am->properties->sym->name);
+      }
+      pool->n_mols = 0;
+    }
+
+    /* Tracers are queued for good (at FOREVER), so the ones kept still
+     * form a heap */
+    int n_kept = 0;
+    for (int i = 0; i < local->unimol_queue.count; i++) {
+      struct abstract_molecule *am =
+          (struct abstract_molecule *)local->unimol_queue.entries[i].data;
+      if (am->properties == NULL) {
+        discard_parked_molecule(local, am);
+        continue;
+      }
+      struct schedule_helper *timer = local->timer;
+      if (is_passive_tracer(am)) {
+        if (!tracer_needed(am->properties, tracers, n_tracers)) {
+          local->unimol_queue.entries[n_kept++] =
+              local->unimol_queue.entries[i];
+          continue;
+        }
+        am->flags &= ~IN_SCHEDULE;
+        am = (struct abstract_molecule *)catch_up_passive_tracer(
+            state, (struct volume_molecule *)am, state->current_iterations);
+        if (am == NULL)
+          continue;
+        am->flags |= IN_SCHEDULE;
+        timer = ((struct volume_molecule *)am)->subvol->local_storage->timer;
+      }
+      if (am->t < state->current_iterations)
+        am->t = state->current_iterations;
+      if (schedule_add(timer, am))
+        mcell_allocfailed("Failed to add a '%s' molecule to scheduler "
+                          "after leaving the unimolecular queue.",
+                          am->properties->sym->name);
+    }
+    local->unimol_queue.count = n_kept;
+  }
+}
+
+/*************************************************************************
+visit_parked_molecules:
+  In: local: local storage area
+      visit: function to call for each parked molecule
+      data: passed on to visit
+  Out: No return value. visit is called for every live molecule of the
+       storage area which is parked in a unimolecular pool or queue. The
+       molecules stay where they are and no random numbers are drawn, so
+       output can read them without changing the simulation. A passive
+       tracer is seen where it was parked.
+*************************************************************************/
+void visit_parked_molecules(struct storage *local,
+                            void (*visit)(struct abstract_molecule *, void *),
+                            void *data) {
+  for (struct unimol_pool *pool = local->unimol_pools; pool != NULL;
+       pool = pool->next) {
+    for (int i = 0; i < pool->n_mols; i++) {
+      if (pool->mols[i]->properties != NULL)
+        visit(pool->mols[i], data);
+    }
+  }
+
+  for (int i = 0; i < local->unimol_queue.count; i++) {
+    struct abstract_molecule *am =
+        (struct abstract_molecule *)local->unimol_queue.entries[i].data;
+    if (am->properties != NULL)
+      visit(am, data);
+  }
+}
+
+/*************************************************************************
+delete_unimol_pools:
+  In: local: local storage area
+  Out: No return value. The (flushed) pools of the storage area are freed.
+*************************************************************************/
+void delete_unimol_pools(struct storage *local) {
+  struct unimol_pool *next;
+  for (struct unimol_pool *pool = local->unimol_pools; pool != NULL;
+       pool = next) {
+    next = pool->next;
+    free(pool->mols);
+    free(pool);
+  }
+  local->unimol_pools = NULL;
+}
+
+/*************************************************************************
+can_batch_diffusion:
+  In: state: simulation state
+      am: a molecule which was just taken out of the scheduler
+  Out: 1 if the molecule is a plainly diffusing volume molecule in a
+       subvolume without walls, so that it may take its step together with
+       others of its species there; 0 otherwise.
+*************************************************************************/
+static int can_batch_diffusion(struct volume *state,
+                               struct abstract_molecule *am) {
+  if (!state->group_diffusion_flag)
+    return 0;
+  if ((am->flags & (TYPE_VOL | ACT_DIFFUSE | ACT_CLAMPED)) !=
+      (TYPE_VOL | ACT_DIFFUSE))
+    return 0;
+  if (am->properties->flags &
+      (CAN_VOLVOLVOL | CAN_VOLVOLSURF | EXTERNAL_SPECIES))
+    return 0;
+  struct volume_molecule *vm = (struct volume_molecule *)am;
+  return vm->subvol->wall_head == NULL && vm->get_space_step(vm) > 0.0;
+}
+
+/*************************************************************************
+compare_batched_molecules:
+  In: a, b: pointers to two batched volume molecules
+  Out: Ordering by subvolume, then by species, for use with qsort.
+*************************************************************************/
+static int compare_batched_molecules(const void *a, const void *b) {
+  struct volume_molecule *vma = *(struct volume_molecule *const *)a;
+  struct volume_molecule *vmb = *(struct volume_molecule *const *)b;
+  if (vma->subvol != vmb->subvol)
+    return ((uintptr_t)vma->subvol < (uintptr_t)vmb->subvol) ? -1 : 1;
+  if (vma->properties != vmb->properties)
+    return ((uintptr_t)vma->properties < (uintptr_t)vmb->properties) ? -1 : 1;
+  return 0;
+}
+
+/*************************************************************************
+batched_max_time:
+  In: vm: batched molecule
+      release_time: time of the next release event
+      checkpt_time: time of the next checkpoint
+  Out: The longest time the molecule may diffuse for, as in run_timestep.
+*************************************************************************/
+static double batched_max_time(struct volume_molecule *vm,
+                               double release_time, double checkpt_time) {
+  double max_time = checkpt_time - vm->t;
+  if (vm->subvol->local_storage->max_timestep < max_time)
+    max_time = vm->subvol->local_storage->max_timestep;
+  if ((vm->flags & ACT_REACT) != 0 && vm->t2 < max_time)
+    max_time = vm->t2;
+  if (max_time > release_time - vm->t)
+    max_time = release_time - vm->t;
+  return max_time;
+}
+
+/*************************************************************************
+finish_batched_step:
+  In: state: simulation state
+      vm: batched molecule which survived its diffusion step
+      save_sched_time: its scheduled time before the step
+  Out: No return value. The molecule is handed to the well-mixed counts or
+       rescheduled, as run_timestep does after diffuse_3D.
+*************************************************************************/
+static void finish_batched_step(struct volume *state,
+                                struct volume_molecule *vm,
+                                double save_sched_time) {
+  if ((vm->flags & ACT_REACT) != 0) {
+    vm->t2 -= vm->t - save_sched_time;
+    if (vm->t2 < 0)
+      vm->t2 = 0;
+  }
+  if (well_mixed_absorb(state, vm))
+    return;
+
+  vm->flags |= IN_SCHEDULE;
+  double t = ceil(vm->t) * (1.0 + 0.1 * EPS_C);
+  if (!distinguishable(t, vm->t, EPS_C))
+    vm->t = t;
+  if (schedule_add(vm->subvol->local_storage->timer, vm))
+    mcell_allocfailed("Failed to add a '%s' volume molecule to scheduler "
+                      "after taking a diffusion step.",
+                      vm->properties->sym->name);
+}
+
+/*************************************************************************
+run_diffusion_batch:
+  In: state: simulation state
+      local: local storage area the molecules were scheduled in
+      batch: molecules for which can_batch_diffusion held when they were
+             taken out of the scheduler; they kept IN_SCHEDULE since
+      n_batch: number of molecules in the batch
+      release_time: time of the next release event
+      checkpt_time: time of the next checkpoint
+  Out: No return value. Every molecule takes its diffusion step and is
+       rescheduled. Molecules are grouped by subvolume and species. A group
+       whose subvolume holds no reaction partners draws all its steps first
+       and tests them against the faces of the subvolume in one pass;
+       steps which stay inside, and clear of partners in neighbouring
+       subvolumes, hit nothing and are simply applied. The remaining steps,
+       and groups which might react, go through diffuse_3D.
+  Note: The batch moves in subvolume and species order rather than time
+        order. run_timestep flushes it before any molecule due later than
+        the earliest batched one, so nothing else moves in between.
+*************************************************************************/
+static void run_diffusion_batch(struct volume *state, struct storage *local,
+                                struct volume_molecule **batch, int n_batch,
+                                double release_time, double checkpt_time) {
+  struct diffusion_step step[DIFFUSION_BATCH_SIZE];
+  double max_time[DIFFUSION_BATCH_SIZE];
+  double save_sched_time[DIFFUSION_BATCH_SIZE];
+  int inside[DIFFUSION_BATCH_SIZE];
+
+  qsort(batch, n_batch, sizeof(struct volume_molecule *),
+        compare_batched_molecules);
+
+  int end;
+  for (int start = 0; start < n_batch; start = end) {
+    struct subvolume *sv = batch[start]->subvol;
+    struct species *spec = batch[start]->properties;
+    for (end = start + 1; end < n_batch; end++) {
+      if (batch[end]->subvol != sv || batch[end]->properties != spec)
+        break;
+    }
+
+    if (spec == NULL) { /* Defunct!  Remove molecules. */
+      for (int i = start; i < end; i++) {
+        struct volume_molecule *vm = batch[i];
+        if ((vm->flags & IN_MASK) == IN_SCHEDULE) {
+          vm->next = NULL;
+          mem_put(vm->birthplace, vm);
+        } else
+          vm->flags &= ~IN_SCHEDULE;
+        if (local->timer->defunct_count > 0)
+          local->timer->defunct_count--;
+      }
+      continue;
+    }
+
+    int check_partners =
+        ((spec->flags & (CAN_VOLVOL | CANT_INITIATE)) == CAN_VOLVOL);
+    if (check_partners && subvol_holds_partners(state, batch[start], sv)) {
+      for (int i = start; i < end; i++) {
+        struct volume_molecule *vm = batch[i];
+        vm->flags &= ~IN_SCHEDULE;
+        double t_start = vm->t;
+        vm = diffuse_3D(state, vm,
+                        batched_max_time(vm, release_time, checkpt_time));
+        if (vm != NULL)
+          finish_batched_step(state, vm, t_start);
+      }
+      continue;
+    }
+
+    /* Draw the steps of the whole group */
+    for (int i = start; i < end; i++) {
+      struct volume_molecule *vm = batch[i];
+      int inertness = 0;
+      vm->flags &= ~IN_SCHEDULE;
+      save_sched_time[i] = vm->t;
+      max_time[i] = batched_max_time(vm, release_time, checkpt_time);
+      set_inertness_and_maxtime(state, vm, &max_time[i], &inertness);
+      compute_displacement(state, NULL, vm, &step[i].displacement,
+                           &step[i].displacement2, &step[i].rate_factor,
+                           &step[i].r_rate_factor, &step[i].steps,
+                           &step[i].t_steps, max_time[i]);
+    }
+
+    /* Partners in neighbouring subvolumes are only seen within the
+     * interaction radius of the faces */
+    double margin = (check_partners && state->use_expanded_list)
+                        ? state->rx_radius_3d
+                        : 0.0;
+    double lo_x = state->x_fineparts[sv->llf.x] + margin;
+    double hi_x = state->x_fineparts[sv->urb.x] - margin;
+    double lo_y = state->y_fineparts[sv->llf.y] + margin;
+    double hi_y = state->y_fineparts[sv->urb.y] - margin;
+    double lo_z = state->z_fineparts[sv->llf.z] + margin;
+    double hi_z = state->z_fineparts[sv->urb.z] - margin;
+    for (int i = start; i < end; i++) {
+      struct vector3 *pos = &batch[i]->pos;
+      struct vector3 *d = &step[i].displacement;
+      double x = pos->x + d->x;
+      double y = pos->y + d->y;
+      double z = pos->z + d->z;
+      inside[i] = (pos->x > lo_x) & (pos->x < hi_x) & (x > lo_x) & (x < hi_x) &
+                  (pos->y > lo_y) & (pos->y < hi_y) & (y > lo_y) & (y < hi_y) &
+                  (pos->z > lo_z) & (pos->z < hi_z) & (z > lo_z) & (z < hi_z);
+    }
+
+    for (int i = start; i < end; i++) {
+      if (!inside[i])
+        continue;
+      struct volume_molecule *vm = batch[i];
+      vm->pos.x += step[i].displacement.x;
+      vm->pos.y += step[i].displacement.y;
+      vm->pos.z += step[i].displacement.z;
+      vm->t += step[i].t_steps;
+      vm->index = -1;
+      vm->previous_wall = NULL;
+      finish_batched_step(state, vm, save_sched_time[i]);
+    }
+
+    for (int i = start; i < end; i++) {
+      if (inside[i])
+        continue;
+      struct volume_molecule *vm =
+          diffuse_3D_from_step(state, batch[i], max_time[i], &step[i]);
+      if (vm != NULL)
+        finish_batched_step(state, vm, save_sched_time[i]);
+    }
+  }
+}
+
 /*************************************************************************
 run_timestep:
   In: state: simulation state
@@ -3651,6 +4397,8 @@ run_timestep:
 void run_timestep(struct volume *state, struct storage *local,
                   double release_time, double checkpt_time) {
   struct abstract_molecule *am;
+  struct volume_molecule *batch[DIFFUSION_BATCH_SIZE];
+  int n_batch = 0;
 
   // Check for garbage collection first
   clean_up_old_molecules(local);
@@ -3659,7 +4407,21 @@ void run_timestep(struct volume *state, struct storage *local,
 
   /* Do not trigger the scheduler to advance!  This will be done
    * by the main loop. */
-  while (local->timer->current != NULL) {
+  double batch_t = 0; /* earliest scheduled time of a batched molecule */
+  while (local->timer->current != NULL || n_batch > 0) {
+    // Batched molecules move once the batch is full, nothing else is due, or
+    // the next molecule is due later than one of them, so that nobody meets
+    // a batched molecule at a stale position; they may be due again within
+    // this timestep afterwards
+    if (n_batch > 0 &&
+        (local->timer->current == NULL || n_batch == DIFFUSION_BATCH_SIZE ||
+         local->timer->current->t > batch_t)) {
+      run_diffusion_batch(state, local, batch, n_batch, release_time,
+                          checkpt_time);
+      n_batch = 0;
+      continue;
+    }
+
     am = (struct abstract_molecule *)schedule_next(local->timer);
     if (am->properties == NULL) /* Defunct!  Remove molecule. */
     {
@@ -3684,9 +4446,38 @@ void run_timestep(struct volume *state, struct storage *local,
       }
     }
 
+    // Stationary molecules which outlive this iteration are advanced with
+    // the rest of their population from now on
+    if (can_aggregate_unimol(state, am)) {
+      add_to_unimol_pool(local, am);
+      continue;
+    }
+
+    // Passive tracers stay where they are until something needs to know
+    if (is_passive_tracer(am)) {
+      am->flags |= IN_SCHEDULE;
+      if (heap_insert(&local->unimol_queue, am, FOREVER))
+        mcell_allocfailed("Failed to add a '%s' molecule to the unimolecular "
+                          "queue.", am->properties->sym->name);
+      continue;
+    }
+
+    // Volume molecules in wall-free subvolumes move in groups
+    if (can_batch_diffusion(state, am)) {
+      am->flags |= IN_SCHEDULE;
+      if (n_batch == 0 || am->t < batch_t)
+        batch_t = am->t;
+      batch[n_batch++] = (struct volume_molecule *)am;
+      continue;
+    }
+
     // How to advance surface molecule scheduling time
     double surface_mol_advance_time = 0;
 
+    // Wait in the unimolecular queue rather than the scheduler?
+    int park = 0;
+    int inert = 0;
+
     struct wall *current_wall = NULL;
     // The maximum time we can spend diffusing or looking for reactions
     double max_time;
@@ -3716,6 +4507,9 @@ void run_timestep(struct volume *state, struct storage *local,
             if (am->t2 < 0)
               am->t2 = 0;
           }
+          // Held as a count from here on if it ended up in the bulk
+          if (well_mixed_absorb(state, (struct volume_molecule *)am))
+            continue;
         } else
           continue;
       } else {
@@ -3811,14 +4605,18 @@ void run_timestep(struct volume *state, struct storage *local,
         }
       }
     } else if (!can_diffuse) {
-      // NOTE: t2 should only be 0 at this point if "am" is inert. This is
-      // basically just a clunky way to ignore it, although it's not clear why
-      // we can't just set t to the total number of iterations.
-      if (am->t2 == 0)
-        am->t += MAX_UNI_TIMESKIP;
-      else {
+      // Stationary molecules whose next unimolecular event lies beyond this
+      // iteration wait for it in the unimolecular queue. NOTE: t2 should only
+      // be 0 at this point if "am" is inert; it then stays in the queue until
+      // something flushes it.
+      if (am->t2 == 0) {
+        park = 1;
+        inert = 1;
+      } else {
+        double next_iteration = floor(am->t) + 1.0;
         am->t += am->t2;
         am->t2 = 0;
+        park = (am->t >= next_iteration);
       }
     }
 
@@ -3829,7 +4627,15 @@ void run_timestep(struct volume *state, struct storage *local,
     if (!distinguishable(t, am->t, EPS_C))
       am->t = t;
 
-    if (am->flags & TYPE_SURF) {
+    if (park) {
+      struct storage *store =
+          (am->flags & TYPE_SURF)
+              ? ((struct surface_molecule *)am)->grid->subvol->local_storage
+              : ((struct volume_molecule *)am)->subvol->local_storage;
+      if (heap_insert(&store->unimol_queue, am, inert ? FOREVER : am->t))
+        mcell_allocfailed("Failed to add a '%s' molecule to the unimolecular "
+                          "queue.", am->properties->sym->name);
+    } else if (am->flags & TYPE_SURF) {
       reschedule_surface_molecules(state, local, am);
     } else {
       if (schedule_add(
@@ -4042,7 +4848,7 @@ static int collide_and_react_with_vol_mol(struct volume* world,
 
   double scaling = factor * r_rate_factor;
   struct rxn* rx = smash->intermediate;
-  if ((rx != NULL) && (rx->prob_t != NULL)) {
+  if ((rx != NULL) && (rx->prob_t != NULL) && !rx->rate_changes_scheduled) {
     update_probs(world, rx, m->t);
   }
 
@@ -4158,7 +4964,8 @@ int collide_and_react_with_surf_mol(struct volume* world, struct collision* smas
       }
 
       for (int l = 0; l < num_matching_rxns; l++) {
-        if (matching_rxns[l]->prob_t != NULL)
+        if (matching_rxns[l]->prob_t != NULL &&
+            !matching_rxns[l]->rate_changes_scheduled)
           update_probs(world, matching_rxns[l], m->t);
         scaling_coef[l] = r_rate_factor / w->grid->binding_factor;
       }
@@ -4208,16 +5015,14 @@ int collide_and_react_with_surf_mol(struct volume* world, struct collision* smas
   /* test for the trimolecular reactions of the type MOL_GRID_GRID */
   if (mol_grid_grid_flag) {
     struct surface_molecule *smp; /* Neighboring molecules */
-    struct tile_neighbor *tile_nbr_head = NULL, *curr;
-    int list_length = 0;
+    struct tile_ref *nbrs = NULL;
     int n = 0; /* total number of possible reactions for a given
                    molecule with all its neighbors */
 
     /* find neighbor molecules to react with */
-    find_neighbor_tiles(world, sm, sm->grid, sm->grid_index, 0, 1,
-      &tile_nbr_head, &list_length);
-    if (tile_nbr_head != NULL) {
-      const int num_nbrs = (const int)list_length;
+    const int num_nbrs =
+        find_neighbor_tile_array(world, sm, sm->grid, sm->grid_index, &nbrs);
+    if (num_nbrs > 0) {
       double local_prob_factor; /*local probability factor for the
                                    reaction */
       int max_size = num_nbrs * MAX_MATCHING_RXNS;
@@ -4238,11 +5043,12 @@ int collide_and_react_with_surf_mol(struct volume* world, struct collision* smas
 
       /* step through the neighbors */
       int ll = 0;
-      for (curr = tile_nbr_head; curr != NULL; curr = curr->next) {
+      for (int kk = 0; kk < num_nbrs; kk++) {
+        struct tile_ref *curr = &nbrs[kk];
         sm_list = curr->grid->sm_list[curr->idx];
         if (sm_list == NULL || sm_list->sm == NULL)
           continue;
-        smp = curr->grid->sm_list[curr->idx]->sm;
+        smp = sm_list->sm;
 
         /* check whether any of potential partners
         are behind restrictive (REFLECTIVE/ABSORPTIVE) boundary */
@@ -4275,7 +5081,8 @@ int collide_and_react_with_surf_mol(struct volume* world, struct collision* smas
               world->vol_surf_surf_colls++;
           }
           for (j = 0; j < num_matching_rxns; j++) {
-            if (matching_rxns[j]->prob_t != NULL) {
+            if (matching_rxns[j]->prob_t != NULL &&
+                !matching_rxns[j]->rate_changes_scheduled) {
               update_probs(world, matching_rxns[j], m->t);
             }
             rxn_array[ll] = matching_rxns[j];
@@ -4287,7 +5094,6 @@ int collide_and_react_with_surf_mol(struct volume* world, struct collision* smas
           n += num_matching_rxns;
         }
       }
-      delete_tile_neighbor_list(tile_nbr_head);
 
       if (n == 1) {
         ii = test_bimolecular(rxn_array[0], cf[0], local_prob_factor,
@@ -4426,7 +5232,8 @@ int collide_and_react_with_walls(struct volume* world, struct collision* smash,
     /* Collisions with the surfaces declared REFLECTIVE are treated similar to
      * the default surfaces after this loop. */
     for (int l = 0; l < num_matching_rxns; l++) {
-      if (matching_rxns[l]->prob_t != NULL) {
+      if (matching_rxns[l]->prob_t != NULL &&
+          !matching_rxns[l]->rate_changes_scheduled) {
         update_probs(world, matching_rxns[l], m->t);
       }
     }
@@ -4807,8 +5614,7 @@ void collide_and_react_with_subvol(struct volume* world, struct collision *smash
   }
 
   struct subvolume *nsv = traverse_subvol(
-    m->subvol, smash->what - COLLIDE_SV_NX - COLLIDE_SUBVOL, world->ny_parts,
-    world->nz_parts);
+    m->subvol, smash->what - COLLIDE_SV_NX - COLLIDE_SUBVOL);
   if (nsv == NULL) {
     mcell_internal_error(
         "A %s molecule escaped the world at [%.2f, %.2f, %.2f]",
@@ -4861,6 +5667,9 @@ void compute_displacement(struct volume* world, struct collision* shead,
     if (max_time > MULTISTEP_WORTHWHILE) {
       *steps = safe_diffusion_step(m, shead, world->radial_subdivisions,
         world->r_step, world->x_fineparts, world->y_fineparts, world->z_fineparts);
+      if (m->subvol->wall_head == NULL && shead == NULL &&
+          *steps * m->get_time_step(m) < max_time)
+        *steps = empty_block_diffusion_step(world, m, *steps);
     } else {
       *steps = 1.0;
     }
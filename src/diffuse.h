@@ -28,7 +28,10 @@
 #define MULTISTEP_WORTHWHILE 2
 #define MULTISTEP_PERCENTILE 0.99
 #define MULTISTEP_FRACTION 0.9
-#define MAX_UNI_TIMESKIP 100000
+
+/* Volume molecules gathered before moving them in groups with
+ * -group_diffusion */
+#define DIFFUSION_BATCH_SIZE 256
 
 struct vector3* reflect_periodic_2D(
     struct volume *state,
@@ -106,6 +109,21 @@ void reschedule_surface_molecules(
 void run_timestep(struct volume *world, struct storage *local,
                   double release_time, double checkpt_time);
 
+void run_unimol_pools(struct volume *world, struct storage *local,
+                      double t_start, double t_end);
+
+void wake_queued_molecules(struct volume *world, struct storage *local,
+                           double t_end);
+
+void flush_parked_molecules(struct volume *world, struct species **tracers,
+                            int n_tracers);
+
+void visit_parked_molecules(struct storage *local,
+                            void (*visit)(struct abstract_molecule *, void *),
+                            void *data);
+
+void delete_unimol_pools(struct storage *local);
+
 void run_concentration_clamp(struct volume *world, double t_now);
 
 struct sp_collision *expand_collision_partner_list_for_neighbor(
@@ -1008,8 +1008,7 @@ pretend_to_call_diffuse_3D_big_list: /* Label to allow fake recursion */
         if (t_steps < EPS_C)
           t_steps = EPS_C;
 
-        nsv = traverse_subvol(sv, smash->what - COLLIDE_SV_NX - COLLIDE_SUBVOL,
-                              world->ny_parts, world->nz_parts);
+        nsv = traverse_subvol(sv, smash->what - COLLIDE_SV_NX - COLLIDE_SUBVOL);
         if (nsv == NULL) {
           mcell_internal_error(
               "A %s molecule escaped the world at [%.2f, %.2f, %.2f]",
@@ -1501,7 +1500,7 @@ pretend_to_call_diffuse_3D_big_list: /* Label to allow fake recursion */
 
       k = tri_smash->orient;
 
-      if ((rx != NULL) && (rx->prob_t != NULL))
+      if ((rx != NULL) && (rx->prob_t != NULL) && !rx->rate_changes_scheduled)
         update_probs(world, rx, m->t);
 
       /* XXX: Change required here to support macromol+trimol */
@@ -1617,7 +1616,7 @@ pretend_to_call_diffuse_3D_big_list: /* Label to allow fake recursion */
 
             continue; /* Ignore this wall and keep going */
           } else if (rx->n_pathways != RX_REFLEC) {
-            if (rx->prob_t != NULL)
+            if (rx->prob_t != NULL && !rx->rate_changes_scheduled)
               update_probs(world, rx, m->t);
             i = test_intersect(rx, r_rate_factor, world->rng);
             if (i > RX_NO_RX) {
@@ -44,22 +44,367 @@
 
 #define NO_MESH "\0"
 
+/***************************************************************************
+ hash_names:
+ In:  names: an array of names
+      n_names: number of names
+ Out: A hash of the names, in order.
+***************************************************************************/
+static unsigned long hash_names(char *const *names, int n_names) {
+  unsigned long hash = 5381;
+  for (int i = 0; i < n_names; i++) {
+    for (const char *c = names[i]; *c != '\0'; c++)
+      hash = hash * 33 + (unsigned char)*c;
+    hash = hash * 33 + 1;
+  }
+  return hash;
+}
+
+/***************************************************************************
+ stored_list_equals:
+ In:  table: a name list table
+      id: id of a list in the table
+      names: an array of names
+      n_names: number of names
+ Out: 1 if the stored list holds the same names in the same order, 0
+      otherwise.
+***************************************************************************/
+static int stored_list_equals(struct name_list_table *table, int id,
+                              char *const *names, int n_names) {
+  int first = table->first_name[id];
+  if (table->first_name[id + 1] - first != n_names)
+    return 0;
+  for (int i = 0; i < n_names; i++) {
+    if (strcmp(table->chars + table->name_offsets[first + i], names[i]) != 0)
+      return 0;
+  }
+  return 1;
+}
+
+/***************************************************************************
+ rehash_name_lists:
+ In:  table: a name list table
+      n_buckets: new number of hash buckets (power of 2)
+ Out: Zero on success. One on memory allocation failure, in which case the
+      table is left as it was.
+***************************************************************************/
+static int rehash_name_lists(struct name_list_table *table, int n_buckets) {
+  int *buckets = (int *)malloc(n_buckets * sizeof(int));
+  if (buckets == NULL)
+    return 1;
+  for (int i = 0; i < n_buckets; i++)
+    buckets[i] = -1;
+  for (int id = 0; id < table->n_lists; id++) {
+    int bucket = (int)(table->hashes[id] & (unsigned long)(n_buckets - 1));
+    table->next_in_bucket[id] = buckets[bucket];
+    buckets[bucket] = id;
+  }
+  free(table->buckets);
+  table->buckets = buckets;
+  table->n_buckets = n_buckets;
+  return 0;
+}
+
+/***************************************************************************
+ grow_name_lists:
+ In:  table: a name list table
+ Out: Zero on success. One on memory allocation failure. Room is made for
+      at least one more list.
+***************************************************************************/
+static int grow_name_lists(struct name_list_table *table) {
+  int new_max = (table->max_lists > 0) ? 2 * table->max_lists : 64;
+  int *new_first =
+      (int *)realloc(table->first_name, (new_max + 1) * sizeof(int));
+  if (new_first == NULL)
+    return 1;
+  table->first_name = new_first;
+  unsigned long *new_hashes =
+      (unsigned long *)realloc(table->hashes, new_max * sizeof(unsigned long));
+  if (new_hashes == NULL)
+    return 1;
+  table->hashes = new_hashes;
+  int *new_next = (int *)realloc(table->next_in_bucket, new_max * sizeof(int));
+  if (new_next == NULL)
+    return 1;
+  table->next_in_bucket = new_next;
+  struct string_buffer **new_views = (struct string_buffer **)realloc(
+      table->views, new_max * sizeof(struct string_buffer *));
+  if (new_views == NULL)
+    return 1;
+  table->views = new_views;
+  struct string_buffer **new_filtered = (struct string_buffer **)realloc(
+      table->filtered, new_max * sizeof(struct string_buffer *));
+  if (new_filtered == NULL)
+    return 1;
+  table->filtered = new_filtered;
+  table->max_lists = new_max;
+  return 0;
+}
+
+/***************************************************************************
+ init_name_list_table:
+ In:  table: an uninitialized name list table
+      n_walls: number of walls surface molecules may be saved on
+ Out: Zero on success. One otherwise. The table holds only the empty list,
+      which always has id EMPTY_NAME_LIST, and has room for the name lists
+      of n_walls walls.
+***************************************************************************/
+int init_name_list_table(struct name_list_table *table, int n_walls) {
+  memset(table, 0, sizeof(struct name_list_table));
+  if (grow_name_lists(table) || rehash_name_lists(table, 64))
+    return 1;
+  table->max_chars = 4096;
+  table->chars = CHECKED_MALLOC_ARRAY(char, table->max_chars, "names");
+  table->max_names = 256;
+  table->name_offsets =
+      CHECKED_MALLOC_ARRAY(size_t, table->max_names, "name offsets");
+  table->first_name[0] = 0;
+
+  table->max_wall_ids = (n_walls > 0) ? n_walls : 1;
+  table->wall_ids = CHECKED_MALLOC_ARRAY(struct wall_name_ids,
+                                         table->max_wall_ids, "wall names");
+  if (pointer_hash_init(&table->wall_index, 64))
+    return 1;
+
+  if (intern_name_list(table, NULL, 0) != EMPTY_NAME_LIST)
+    return 1;
+  return 0;
+}
+
+/***************************************************************************
+ intern_name_list:
+ In:  table: a name list table
+      names: an array of names, which is only read
+      n_names: number of names
+ Out: The id of the list in the table, or -1 on memory allocation failure.
+      If an equal list is already stored, its id is returned; otherwise
+      the names are copied into the table.
+***************************************************************************/
+int intern_name_list(struct name_list_table *table, char *const *names,
+                     int n_names) {
+  unsigned long hash = hash_names(names, n_names);
+  int bucket = (int)(hash & (unsigned long)(table->n_buckets - 1));
+  for (int id = table->buckets[bucket]; id >= 0;
+       id = table->next_in_bucket[id]) {
+    if (table->hashes[id] == hash &&
+        stored_list_equals(table, id, names, n_names))
+      return id;
+  }
+
+  if (table->n_lists == table->max_lists && grow_name_lists(table))
+    return -1;
+
+  size_t n_chars = 0;
+  for (int i = 0; i < n_names; i++)
+    n_chars += strlen(names[i]) + 1;
+  if (table->n_chars + n_chars > table->max_chars) {
+    size_t new_max = 2 * table->max_chars;
+    while (new_max < table->n_chars + n_chars)
+      new_max *= 2;
+    char *new_chars = (char *)realloc(table->chars, new_max);
+    if (new_chars == NULL)
+      return -1;
+    table->chars = new_chars;
+    table->max_chars = new_max;
+  }
+  if (table->n_names + n_names > table->max_names) {
+    int new_max = 2 * table->max_names;
+    while (new_max < table->n_names + n_names)
+      new_max *= 2;
+    size_t *new_offsets =
+        (size_t *)realloc(table->name_offsets, new_max * sizeof(size_t));
+    if (new_offsets == NULL)
+      return -1;
+    table->name_offsets = new_offsets;
+    table->max_names = new_max;
+  }
+
+  for (int i = 0; i < n_names; i++) {
+    size_t len = strlen(names[i]) + 1;
+    memcpy(table->chars + table->n_chars, names[i], len);
+    table->name_offsets[table->n_names++] = table->n_chars;
+    table->n_chars += len;
+  }
+
+  int id = table->n_lists++;
+  table->first_name[id + 1] = table->n_names;
+  table->hashes[id] = hash;
+  table->views[id] = NULL;
+  table->filtered[id] = NULL;
+  table->next_in_bucket[id] = table->buckets[bucket];
+  table->buckets[bucket] = id;
+
+  // Keep chains short as the table fills up
+  if (table->n_lists > table->n_buckets)
+    rehash_name_lists(table, 2 * table->n_buckets);
+  return id;
+}
+
+/***************************************************************************
+ intern_name_buffer:
+ In:  table: a name list table
+      names: a list of names, which is freed (NULL is the empty list)
+ Out: The id of the list in the table, or -1 on memory allocation failure.
+***************************************************************************/
+static int intern_name_buffer(struct name_list_table *table,
+                              struct string_buffer *names) {
+  if (names == NULL)
+    return EMPTY_NAME_LIST;
+  int id = intern_name_list(table, names->strings, names->n_strings);
+  destroy_string_buffer(names);
+  free(names);
+  return id;
+}
+
+/***************************************************************************
+ name_list_strings:
+ In:  table: a name list table
+      id: id of a list in the table
+ Out: The list as a string buffer owned by the table. Its strings point into
+      the table and are only valid until the next list is interned.
+***************************************************************************/
+struct string_buffer *name_list_strings(struct name_list_table *table,
+                                        int id) {
+  int first = table->first_name[id];
+  int n_names = table->first_name[id + 1] - first;
+  struct string_buffer *view = table->views[id];
+  if (view == NULL) {
+    view = CHECKED_MALLOC_STRUCT(struct string_buffer, "string buffer");
+    view->strings = (n_names > 0) ? CHECKED_MALLOC_ARRAY(char *, n_names,
+                                                         "name list")
+                                  : NULL;
+    view->max_strings = n_names;
+    view->n_strings = n_names;
+    table->views[id] = view;
+  }
+  for (int i = 0; i < n_names; i++)
+    view->strings[i] = table->chars + table->name_offsets[first + i];
+  return view;
+}
+
+/***************************************************************************
+ filtered_name_list:
+ In:  table: a name list table
+      id: id of a list in the table
+      names_to_ignore: names to leave out of the list
+ Out: The list with names_to_ignore removed.  The result is computed once
+      per list and owned by the table, so names_to_ignore must be the same
+      for every call on one table.
+***************************************************************************/
+struct string_buffer *filtered_name_list(struct name_list_table *table,
+                                         int id,
+                                         struct string_buffer *names_to_ignore) {
+  if (table->filtered[id] == NULL) {
+    struct string_buffer *filtered =
+        CHECKED_MALLOC_STRUCT(struct string_buffer, "string buffer");
+    initialize_string_buffer(filtered, MAX_NUM_OBJECTS);
+    diff_string_buffers(filtered, name_list_strings(table, id),
+                        names_to_ignore);
+    table->filtered[id] = filtered;
+  }
+  return table->filtered[id];
+}
+
+/***************************************************************************
+ intern_wall_names:
+ In:  table: a name list table
+      w: a wall
+ Out: The mesh and region name lists of the wall, or NULL on memory
+      allocation failure. They are looked up once per wall.
+***************************************************************************/
+static struct wall_name_ids *intern_wall_names(struct name_list_table *table,
+                                               struct wall *w) {
+  unsigned int keyhash = (unsigned int)(intptr_t)w;
+  struct wall_name_ids *ids = (struct wall_name_ids *)pointer_hash_lookup(
+      &table->wall_index, w, keyhash);
+  if (ids != NULL)
+    return ids;
+  if (table->n_wall_ids == table->max_wall_ids)
+    mcell_internal_error("More walls hold surface molecules than exist.");
+
+  ids = &table->wall_ids[table->n_wall_ids];
+  char *mesh_name = w->parent_object->sym->name;
+  ids->mesh_names_id = intern_name_list(table, &mesh_name, 1);
+  if (ids->mesh_names_id < 0)
+    return NULL;
+
+  struct string_buffer *reg_names =
+      CHECKED_MALLOC_STRUCT(struct string_buffer, "string buffer");
+  if (initialize_string_buffer(reg_names, MAX_NUM_REGIONS)) {
+    free(reg_names);
+    return NULL;
+  }
+  struct name_list *reg_name_list_head = find_regions_names_by_wall(w, NULL);
+  for (struct name_list *nl = reg_name_list_head; nl != NULL; nl = nl->next) {
+    add_string_to_buffer(reg_names, nl->name);
+    nl->name = NULL;
+  }
+  if (reg_name_list_head != NULL)
+    remove_molecules_name_list(&reg_name_list_head);
+  ids->reg_names_id = intern_name_buffer(table, reg_names);
+  if (ids->reg_names_id < 0)
+    return NULL;
+
+  if (pointer_hash_add(&table->wall_index, w, keyhash, ids))
+    return NULL;
+  table->n_wall_ids++;
+  return ids;
+}
+
+/***************************************************************************
+ destroy_name_list_table:
+ In:  table: a name list table
+ Out: None. All lists and the table's arrays are freed.
+***************************************************************************/
+void destroy_name_list_table(struct name_list_table *table) {
+  for (int id = 0; id < table->n_lists; id++) {
+    if (table->views[id] != NULL) {
+      free(table->views[id]->strings);
+      free(table->views[id]);
+    }
+    if (table->filtered[id] != NULL) {
+      destroy_string_buffer(table->filtered[id]);
+      free(table->filtered[id]);
+    }
+  }
+  free(table->chars);
+  free(table->name_offsets);
+  free(table->first_name);
+  free(table->hashes);
+  free(table->next_in_bucket);
+  free(table->views);
+  free(table->filtered);
+  free(table->buckets);
+  free(table->wall_ids);
+  pointer_hash_destroy(&table->wall_index);
+  memset(table, 0, sizeof(struct name_list_table));
+}
+
 /***************************************************************************
  save_all_molecules: Save all the molecules currently in the scheduler.
 
  In:  state: MCell state
       storage_head: we will pull all the molecules out of the scheduler from
         this
- Out: An array of all the molecules to be saved
+ Out: An array of all the molecules to be saved, or NULL on failure.  The
+      molecules themselves are stored in state->all_molecule_data and their
+      mesh and region names in state->all_molecule_names, where each
+      distinct list of names is only stored once.
 ***************************************************************************/
-struct molecule_info **save_all_molecules(struct volume *state,
-                                          struct storage_list *storage_head) {
+struct molecule_info *save_all_molecules(struct volume *state,
+                                         struct storage_list *storage_head) {
 
   // Find total number of molecules in the scheduler.
   unsigned long long num_all_molecules = count_items_in_scheduler(storage_head);
   int ctr = 0;
-  struct molecule_info **all_molecules = CHECKED_MALLOC_ARRAY(
-      struct molecule_info *, num_all_molecules, "all molecules");
+  struct molecule_info *all_molecules = CHECKED_MALLOC_ARRAY(
+      struct molecule_info, num_all_molecules + 1, "all molecules");
+  state->all_molecule_data = CHECKED_MALLOC_ARRAY(
+      struct abstract_molecule, num_all_molecules + 1, "abstract molecules");
+  state->all_molecule_names =
+      CHECKED_MALLOC_STRUCT(struct name_list_table, "name list table");
+  if (init_name_list_table(state->all_molecule_names, state->n_walls))
+    return NULL;
 
   // Iterate over all the molecules in every scheduler of every storage.
   for (struct storage_list *sl_ptr = storage_head; sl_ptr != NULL;
@@ -74,35 +419,21 @@ struct molecule_info **save_all_molecules(struct volume *state,
           if (am_ptr->properties == NULL)
             continue;
 
-          struct molecule_info *mol_info =
-              CHECKED_MALLOC_STRUCT(struct molecule_info, "molecule info");
-          all_molecules[ctr] = mol_info;
-          mol_info->molecule = CHECKED_MALLOC_STRUCT(struct abstract_molecule,
-                                                     "abstract molecule");
-
-          // Mesh names needed for VOLUME molecules
-          struct string_buffer *nested_mesh_names = NULL;
-
-          // Region names and mesh name needed for SURFACE molecules
-          struct string_buffer *reg_names =
-              CHECKED_MALLOC_STRUCT(struct string_buffer, "string buffer");
-          if (initialize_string_buffer(reg_names, MAX_NUM_REGIONS)) {
-            return NULL;
-          }
-          char *mesh_name = NULL;
+          struct molecule_info *mol_info = &all_molecules[ctr];
+          mol_info->molecule = &state->all_molecule_data[ctr];
+          mol_info->reg_names_id = EMPTY_NAME_LIST;
+          mol_info->mesh_names_id = EMPTY_NAME_LIST;
 
           if ((am_ptr->properties->flags & NOT_FREE) == 0) {
-            save_volume_molecule(state, mol_info, am_ptr, &nested_mesh_names);
+            save_volume_molecule(state, mol_info, am_ptr);
           } else if ((am_ptr->properties->flags & ON_GRID) != 0) {
-            if (save_surface_molecule(mol_info, am_ptr, &reg_names, &mesh_name))
+            if (save_surface_molecule(state, mol_info, am_ptr))
               return NULL;
           } else {
-            destroy_string_buffer(reg_names);
             continue;
           }
 
-          save_common_molecule_properties(
-              mol_info, am_ptr, reg_names, nested_mesh_names, mesh_name);
+          save_common_molecule_properties(mol_info, am_ptr);
           ctr += 1;
         }
       }
@@ -119,17 +450,11 @@ struct molecule_info **save_all_molecules(struct volume *state,
 
  In:  mol_info: holds all the information for recreating and placing a molecule
       am_ptr: abstract molecule pointer
-      reg_names: the region names the molecule is on (surface molecules)
-      nested_mesh_names: the meshes the molecule is nested inside of (volume molecs)
-      mesh_name: mesh name that molecule is in (surface molecs)
  Out: Nothing. The common properties of surface and volume molecules are saved
-      in mol_info.
+      in mol_info. The mesh of a surface molecule is kept by id in mol_info.
 ***************************************************************************/
 void save_common_molecule_properties(struct molecule_info *mol_info,
-                                     struct abstract_molecule *am_ptr,
-                                     struct string_buffer *reg_names,
-                                     struct string_buffer *nested_mesh_names,
-                                     char *mesh_name) {
+                                     struct abstract_molecule *am_ptr) {
   mol_info->molecule->t = am_ptr->t;
   mol_info->molecule->t2 = am_ptr->t2;
   mol_info->molecule->flags = am_ptr->flags;
@@ -137,15 +462,7 @@ void save_common_molecule_properties(struct molecule_info *mol_info,
   mol_info->molecule->birthday = am_ptr->birthday;
   mol_info->molecule->id = am_ptr->id;
   mol_info->molecule->periodic_box = am_ptr->periodic_box;
-  mol_info->molecule->mesh_name = CHECKED_STRDUP(mesh_name, "mesh name");
-  // Only free temporary object names we just allocated above.
-  // Don't want to accidentally free symbol names of objects.
-  if (mesh_name && (strcmp(mesh_name, NO_MESH) != 0) &&
-      ((am_ptr->properties->flags & NOT_FREE) == 0)) {
-    free(mesh_name);
-  }
-  mol_info->reg_names = reg_names;
-  mol_info->mesh_names = nested_mesh_names;
+  mol_info->molecule->mesh_name = NULL;
 }
 
 /***************************************************************************
@@ -154,16 +471,19 @@ void save_common_molecule_properties(struct molecule_info *mol_info,
  In:  state: MCell state
       mol_info: holds all the information for recreating and placing a molecule
       am_ptr: abstract molecule pointer
-      nested_mesh_names: mesh names that molecule is inside of
- Out: Nothing. Molecule info and mesh name are updated
+ Out: Nothing. Molecule info and the id of the meshes it is nested in are
+      updated.
 ***************************************************************************/
 void save_volume_molecule(struct volume *state,
                           struct molecule_info *mol_info,
-                          struct abstract_molecule *am_ptr,
-                          struct string_buffer **nested_mesh_names) {
+                          struct abstract_molecule *am_ptr) {
   struct volume_molecule *vm_ptr = (struct volume_molecule *)am_ptr;
 
-  *nested_mesh_names = find_enclosing_meshes(state, vm_ptr, NULL);
+  mol_info->mesh_names_id =
+      intern_name_buffer(state->all_molecule_names,
+                         find_enclosing_meshes(state, vm_ptr, NULL));
+  if (mol_info->mesh_names_id < 0)
+    mcell_allocfailed("Failed to store enclosing mesh names.");
   mol_info->pos.x = vm_ptr->pos.x;
   mol_info->pos.y = vm_ptr->pos.y;
   mol_info->pos.z = vm_ptr->pos.z;
@@ -173,18 +493,17 @@ void save_volume_molecule(struct volume *state,
 /***************************************************************************
  save_surface_molecule:
 
- In:  mol_info: holds all the information for recreating and placing a molecule
+ In:  state: MCell state
+      mol_info: holds all the information for recreating and placing a molecule
       am_ptr: abstract molecule pointer
-      reg_names: surface region names that the molecule is on get stored here
-      mesh_name: mesh name that molecule is on gets stored here
  Out: Zero on success. One otherwise. Save relevant surface molecule data in
-      mol_info. Set the mesh_name. Populate reg_names with the region names the
-      sm is on.
+      mol_info. The mesh the sm is on and the regions of its wall are kept in
+      the snapshot's name lists, looked up once per wall, and mol_info
+      refers to them by id.
 ***************************************************************************/
-int save_surface_molecule(struct molecule_info *mol_info,
-                          struct abstract_molecule *am_ptr,
-                          struct string_buffer **reg_names,
-                          char **mesh_name) {
+int save_surface_molecule(struct volume *state,
+                          struct molecule_info *mol_info,
+                          struct abstract_molecule *am_ptr) {
   struct vector3 where;
   struct surface_molecule *sm_ptr = (struct surface_molecule *)am_ptr;
   uv2xyz(&sm_ptr->s_pos, sm_ptr->grid->surface, &where);
@@ -192,22 +511,13 @@ int save_surface_molecule(struct molecule_info *mol_info,
   mol_info->pos.y = where.y;
   mol_info->pos.z = where.z;
   mol_info->orient = sm_ptr->orient;
-  *mesh_name = sm_ptr->grid->surface->parent_object->sym->name;
-  struct name_list *reg_name_list_head, *reg_name_list;
-  reg_name_list_head = find_regions_names_by_wall(sm_ptr->grid->surface, NULL);
-  // Add the names from reg_name_list_head to reg_names
-  for (reg_name_list = reg_name_list_head; reg_name_list != NULL;
-       reg_name_list = reg_name_list->next) {
-    char *str = CHECKED_STRDUP(reg_name_list->name, "region name");
-    if (add_string_to_buffer(*reg_names, str)) {
-      free(str);
-      destroy_string_buffer(*reg_names);
-      return 1;
-    }
-  }
-  if (reg_name_list_head != NULL) {
-    remove_molecules_name_list(&reg_name_list_head);
-  }
+
+  struct wall_name_ids *ids =
+      intern_wall_names(state->all_molecule_names, sm_ptr->grid->surface);
+  if (ids == NULL)
+    return 1;
+  mol_info->mesh_names_id = ids->mesh_names_id;
+  mol_info->reg_names_id = ids->reg_names_id;
   remove_surfmol_from_list(&sm_ptr->grid->sm_list[sm_ptr->grid_index], sm_ptr);
   return 0;
 }
@@ -216,31 +526,20 @@ int save_surface_molecule(struct molecule_info *mol_info,
  cleanup_names_molecs: Cleanup molecule data and string buffers for mesh and
                        region names
 
- In:  num_all_molecules: the number of all the molecules we just placed
-      all_molecules: array of info about all the molecules we just placed
- Out: Nothing
+ In:  state: MCell state
+ Out: Nothing. The molecule snapshot and its name lists are freed.
 ***************************************************************************/
-void cleanup_names_molecs(
-    int num_all_molecules,
-    struct molecule_info **all_molecules) {
-  for (int i = 0; i < num_all_molecules; i++) {
-    char *mesh_name = (char *)all_molecules[i]->molecule->mesh_name;
-    if (mesh_name && (strcmp(mesh_name, NO_MESH) != 0)) {
-      free(mesh_name);
-    }
-    free(all_molecules[i]->molecule);
-    // XXX: Could consolidate "reg_names" and "mesh_names", but we might want
-    // both for surface molecules eventually.
-    destroy_string_buffer(all_molecules[i]->reg_names);
-    free(all_molecules[i]->reg_names);
-    // This is currently unused for surface molecules.
-    if (all_molecules[i]->mesh_names != NULL) {
-      destroy_string_buffer(all_molecules[i]->mesh_names);
-      free(all_molecules[i]->mesh_names);
-    }
-    free(all_molecules[i]);
-  }
-  free(all_molecules);
+void cleanup_names_molecs(struct volume *state) {
+  if (state->all_molecule_names != NULL) {
+    destroy_name_list_table(state->all_molecule_names);
+    free(state->all_molecule_names);
+    state->all_molecule_names = NULL;
+  }
+  free(state->all_molecule_data);
+  state->all_molecule_data = NULL;
+  free(state->all_molecules);
+  state->all_molecules = NULL;
+  state->num_all_molecules = 0;
 }
 
 /***************************************************************************
@@ -264,9 +563,13 @@ int place_all_molecules(
 
   int num_all_molecules = state->num_all_molecules;
 
+  /* Count the re-placed volume molecules together once they are all in */
+  struct count_batch batch = { NULL, 0, 0 };
+  state->deferred_counts = &batch;
+
   for (int n_mol = 0; n_mol < num_all_molecules; n_mol++) {
 
-    struct molecule_info *mol_info = state->all_molecules[n_mol];
+    struct molecule_info *mol_info = &state->all_molecules[n_mol];
     struct abstract_molecule *am_ptr = mol_info->molecule;
     initialize_diffusion_function(am_ptr);
     // Insert volume molecule into world.
@@ -284,7 +587,7 @@ int place_all_molecules(
       initialize_diffusion_function((struct abstract_molecule*)vm_ptr);
 
       vm_guess = insert_volume_molecule_encl_mesh(
-          state, vm_ptr, vm_guess, mol_info->mesh_names, meshes_to_ignore);
+          state, vm_ptr, vm_guess, mol_info->mesh_names_id, meshes_to_ignore);
 
       if (vm_guess == NULL) {
         mcell_error("Cannot insert copy of molecule of species '%s' into "
@@ -294,11 +597,14 @@ int place_all_molecules(
     }
     // Insert surface molecule into world.
     else if ((am_ptr->properties->flags & ON_GRID) != 0) {
-      const char *mesh_name = am_ptr->mesh_name;
+      struct name_list_table *names = state->all_molecule_names;
+      const char *mesh_name =
+          name_list_strings(names, mol_info->mesh_names_id)->strings[0];
       struct surface_molecule *sm = insert_surface_molecule(
           state, am_ptr->properties, &mol_info->pos, mol_info->orient,
           state->vacancy_search_dist2, am_ptr->t, mesh_name,
-          mol_info->reg_names, regions_to_ignore, am_ptr->periodic_box);
+          name_list_strings(names, mol_info->reg_names_id),
+          regions_to_ignore, am_ptr->periodic_box);
       free(am_ptr->periodic_box);
       if (sm == NULL) {
         mcell_warn("Unable to find surface upon which to place molecule %s.",
@@ -307,7 +613,11 @@ int place_all_molecules(
     }
   }
 
-  cleanup_names_molecs(state->num_all_molecules, state->all_molecules);
+  state->deferred_counts = NULL;
+  count_batch_flush(state, &batch);
+  count_batch_destroy(&batch);
+
+  cleanup_names_molecs(state);
 
   return 0;
 }
@@ -574,7 +884,8 @@ insert_volume_molecule_encl_mesh:
   In: state: MCell state
       vm: pointer to volume_molecule that we're going to place in local storage
       vm_guess: pointer to a volume_molecule that may be nearby
-      nested_mesh_names_old: the meshes this molecule was inside of previously
+      nested_mesh_names_old: id in state->all_molecule_names of the meshes
+        this molecule was inside of previously
       meshes_to_ignore: the meshes we should ignore when placing this molecule
   Out: pointer to the new volume_molecule (copies data from volume molecule
        passed in), or NULL if out of memory.  Molecule is placed in scheduler
@@ -584,7 +895,7 @@ struct volume_molecule *insert_volume_molecule_encl_mesh(
     struct volume *state,
     struct volume_molecule *vm,
     struct volume_molecule *vm_guess,
-    struct string_buffer *nested_mesh_names_old,
+    int nested_mesh_names_old,
     struct string_buffer *meshes_to_ignore) {
   struct subvolume *sv;
 
@@ -608,54 +919,53 @@ struct volume_molecule *insert_volume_molecule_encl_mesh(
   new_vm->subvol = sv;
   new_vm->periodic_box = vm->periodic_box;
 
-  struct string_buffer *nested_mesh_names_new = find_enclosing_meshes(
-      state, new_vm, meshes_to_ignore);
-
-  // Make a new string buffer without all the meshes we don't care about (i.e.
-  // the ones we *removed* in this dyn_geom_event). We are already ingoring the
-  // ones just *added* in this dyn_geom_event (in find_enclosing_meshes). Maybe
-  // we should do that here to be consistent and keep the logic decoupled.
-  struct string_buffer *nested_mesh_names_old_filtered =
-      CHECKED_MALLOC_STRUCT(struct string_buffer, "string buffer");
-  initialize_string_buffer(nested_mesh_names_old_filtered, MAX_NUM_OBJECTS);
-  diff_string_buffers(
-    nested_mesh_names_old_filtered, nested_mesh_names_old, meshes_to_ignore);
-
-  const char *species_name = new_vm->properties->sym->name;
-  unsigned int keyhash = (unsigned int)(intptr_t)(species_name);
-  void *key = (void *)(species_name);
-  struct mesh_transparency *mesh_transp = (
-      struct mesh_transparency *)pointer_hash_lookup(state->species_mesh_transp,
-                                                     key, keyhash);
-
-  int move_molecule = 0;
-  int out_to_in = 0;
-  const char *mesh_name = compare_molecule_nesting(
-    &move_molecule,
-    &out_to_in,
-    nested_mesh_names_old_filtered,
-    nested_mesh_names_new,
-    mesh_transp);
-
-  struct vector3 new_pos;
-  if (move_molecule) {
-    /* move molecule to another location so that it is directly inside or
-     * outside of "mesh_name" */
-    place_mol_relative_to_mesh(
-        state, &(vm->pos), sv, mesh_name, &new_pos, out_to_in);
-    check_for_large_molecular_displacement(
-        &(vm->pos), &new_pos, vm, &(state->time_unit),
-        state->notify->large_molecular_displacement);
-    new_vm->pos = new_pos;
-    struct subvolume *new_sv = find_subvolume(state, &(new_vm->pos), NULL);
-    new_vm->subvol = new_sv;
-    state->dyngeom_molec_displacements++;
-  }
-
-  destroy_string_buffer(nested_mesh_names_old_filtered);
-  free(nested_mesh_names_old_filtered);
-  destroy_string_buffer(nested_mesh_names_new);
-  free(nested_mesh_names_new);
+  struct name_list_table *names = state->all_molecule_names;
+  int nested_mesh_names_new = intern_name_buffer(
+      names, find_enclosing_meshes(state, new_vm, meshes_to_ignore));
+  if (nested_mesh_names_new < 0)
+    mcell_allocfailed("Failed to store enclosing mesh names.");
+
+  // Use the old names without all the meshes we don't care about (i.e.
+  // the ones we *removed* in this dyn_geom_event). We are already ingoring
+  // the ones just *added* in this dyn_geom_event (in find_enclosing_meshes).
+  // Maybe we should do that here to be consistent and keep the logic
+  // decoupled.  Identical lists mean the nesting did not change.
+  if (nested_mesh_names_new != nested_mesh_names_old ||
+      meshes_to_ignore->n_strings != 0) {
+    struct string_buffer *nested_mesh_names_old_filtered =
+        filtered_name_list(names, nested_mesh_names_old, meshes_to_ignore);
+
+    const char *species_name = new_vm->properties->sym->name;
+    unsigned int keyhash = (unsigned int)(intptr_t)(species_name);
+    void *key = (void *)(species_name);
+    struct mesh_transparency *mesh_transp =
+        (struct mesh_transparency *)pointer_hash_lookup(
+            state->species_mesh_transp, key, keyhash);
+
+    int move_molecule = 0;
+    int out_to_in = 0;
+    const char *mesh_name = compare_molecule_nesting(
+      &move_molecule,
+      &out_to_in,
+      nested_mesh_names_old_filtered,
+      name_list_strings(names, nested_mesh_names_new),
+      mesh_transp);
+
+    struct vector3 new_pos;
+    if (move_molecule) {
+      /* move molecule to another location so that it is directly inside or
+       * outside of "mesh_name" */
+      place_mol_relative_to_mesh(
+          state, &(vm->pos), sv, mesh_name, &new_pos, out_to_in);
+      check_for_large_molecular_displacement(
+          &(vm->pos), &new_pos, vm, &(state->time_unit),
+          state->notify->large_molecular_displacement);
+      new_vm->pos = new_pos;
+      struct subvolume *new_sv = find_subvolume(state, &(new_vm->pos), NULL);
+      new_vm->subvol = new_sv;
+      state->dyngeom_molec_displacements++;
+    }
+  }
 
   new_vm->birthplace = new_vm->subvol->local_storage->mol;
   ht_add_molecule_to_list(&(new_vm->subvol->mol_by_species), new_vm);
@@ -667,9 +977,12 @@ struct volume_molecule *insert_volume_molecule_encl_mesh(
   }
   // XXX: need to set periodic box properly
   if (new_vm->properties->flags & (COUNT_CONTENTS | COUNT_ENCLOSED)) {
-    count_region_from_scratch(state, (struct abstract_molecule *)new_vm, NULL,
-                              1, &(new_vm->pos), NULL, new_vm->t,
-                              new_vm->periodic_box);
+    if (state->deferred_counts != NULL)
+      count_batch_add(state->deferred_counts, new_vm);
+    else
+      count_region_from_scratch(state, (struct abstract_molecule *)new_vm,
+                                NULL, 1, &(new_vm->pos), NULL, new_vm->t,
+                                new_vm->periodic_box);
   }
 
   if (schedule_add(new_vm->subvol->local_storage->timer, new_vm))
@@ -798,7 +1111,6 @@ hit_subvol:
        update next subvolume
 ************************************************************************/
 void hit_subvol(
-    struct n_parts *np,
     struct string_buffer *mesh_names,
     struct collision *smash,
     struct collision *shead,
@@ -811,9 +1123,8 @@ void hit_subvol(
   virt_mol->pos.z = smash->loc.z;
   virt_mol->subvol = NULL;
 
-  struct subvolume *new_sv = traverse_subvol(
-      sv, smash->what - COLLIDE_SV_NX - COLLIDE_SUBVOL,
-      np->ny_parts, np->nz_parts);
+  struct subvolume *new_sv =
+      traverse_subvol(sv, smash->what - COLLIDE_SV_NX - COLLIDE_SUBVOL);
   // Hit the edge of the world
   if (new_sv == NULL) {
     if (shead != NULL)
@@ -924,10 +1235,7 @@ struct string_buffer *find_enclosing_meshes(
       // We hit a subvolume
       } else if ((smash->what & COLLIDE_SUBVOL) != 0) {
 
-        // Numbers of coarse partitions
-        struct n_parts np = {
-          state->nx_parts, state->ny_parts, state->nz_parts};
-        hit_subvol(&np, mesh_names, smash, shead, nh_head, sv, &virt_mol);
+        hit_subvol(mesh_names, smash, shead, nh_head, sv, &virt_mol);
         // We hit the edge of the world
         if (virt_mol.subvol == NULL) {
           return mesh_names; 
@@ -1237,6 +1545,8 @@ int destroy_everything(struct volume *state) {
 
   for (mem = state->storage_head; mem != NULL; mem = mem->next) {
     delete_scheduler(mem->store->timer);
+    delete_unimol_pools(mem->store);
+    delete_heap(&mem->store->unimol_queue);
     free(mem->store);
   }
   state->storage_head->store = NULL;
@@ -1249,6 +1559,8 @@ int destroy_everything(struct volume *state) {
   destroy_partitions(state);
 
   free(state->waypoints);
+  state->waypoints = NULL;
+  destroy_counting_region_index(state);
 
   // Destroy mesh-species transparency data structure
   destroy_mesh_transp_data(state->mol_sym_table, state->species_mesh_transp);
@@ -1353,6 +1665,9 @@ int destroy_poly_object(struct object *obj_ptr, int free_poly_flag) {
       if (w->grid) {
         /*free(w->grid->mol);*/
         delete_void_list((struct void_list *)w->grid->sm_list);
+        destroy_tile_neighbor_cache(w->grid);
+        free(w->grid->vacancy_bits);
+        free(w->grid->vacancy_summary);
       } 
       delete_void_list((struct void_list *)w->surf_class_head);
     }
@@ -1361,6 +1676,8 @@ int destroy_poly_object(struct object *obj_ptr, int free_poly_flag) {
     poly_obj_ptr->side_removed = NULL;
     free(poly_obj_ptr->element);
     poly_obj_ptr->element = NULL;
+    free(poly_obj_ptr->vertex_array);
+    poly_obj_ptr->vertex_array = NULL;
     poly_obj_ptr->references--;
     // Clean up when there are no other instances of this object
     if (poly_obj_ptr->references == 0) {
@@ -1842,6 +2159,207 @@ int find_all_obj_region_transp(struct object *obj_ptr,
   return 0;
 }
 
+/************************************************************************
+ hash_file_contents:
+ In:  path: path of a file
+      hash: the hash of the file contents is stored here
+      size: the size of the file in bytes is stored here
+ Out: 0 on success, 1 if the file cannot be read.
+ ***********************************************************************/
+static int hash_file_contents(const char *path, unsigned long long *hash,
+                              long *size) {
+  FILE *f = fopen(path, "rb");
+  if (f == NULL)
+    return 1;
+
+  // 64-bit FNV-1a
+  unsigned long long h = 14695981039346656037ULL;
+  long n_bytes = 0;
+  unsigned char buf[4096];
+  size_t n_read;
+  while ((n_read = fread(buf, 1, sizeof(buf), f)) > 0) {
+    for (size_t i = 0; i < n_read; i++) {
+      h ^= buf[i];
+      h *= 1099511628211ULL;
+    }
+    n_bytes += (long)n_read;
+  }
+  int error = ferror(f);
+  fclose(f);
+  if (error)
+    return 1;
+
+  *hash = h;
+  *size = n_bytes;
+  return 0;
+}
+
+/************************************************************************
+ dg_file_cache_lookup:
+ In:  cache: the geometry files parsed so far
+      path: path of a geometry file about to be parsed
+      file_index: set to the index of the file in the cache, or to -1 if the
+                  file cannot be read
+      seen: set to 1 if a file with the same path and contents was already
+            parsed, 0 otherwise
+ Out: 0 on success, 1 on memory allocation failure. A file that was not seen
+      before is added to the cache. Files which cannot be read are never
+      reported as seen.
+ ***********************************************************************/
+int dg_file_cache_lookup(struct dg_file_cache *cache, const char *path,
+                         int *file_index, int *seen) {
+  *file_index = -1;
+  *seen = 0;
+  unsigned long long hash;
+  long size;
+  if (hash_file_contents(path, &hash, &size))
+    return 0;
+
+  for (int i = 0; i < cache->n_files; i++) {
+    struct dg_cached_file *file = &cache->files[i];
+    if (file->hash == hash && file->size == size &&
+        strcmp(file->path, path) == 0) {
+      *file_index = i;
+      *seen = 1;
+      return 0;
+    }
+  }
+
+  if (cache->n_files == cache->max_files) {
+    int new_max = (cache->max_files > 0) ? 2 * cache->max_files : 16;
+    struct dg_cached_file *new_files = (struct dg_cached_file *)realloc(
+        cache->files, new_max * sizeof(struct dg_cached_file));
+    if (new_files == NULL)
+      return 1;
+    cache->files = new_files;
+    cache->max_files = new_max;
+  }
+
+  struct dg_cached_file *file = &cache->files[cache->n_files];
+  memset(file, 0, sizeof(struct dg_cached_file));
+  file->path = strdup(path);
+  if (file->path == NULL)
+    return 1;
+  file->hash = hash;
+  file->size = size;
+  *file_index = cache->n_files++;
+  return 0;
+}
+
+/************************************************************************
+ dg_file_cache_find_mesh:
+ In:  cache: the geometry files parsed so far
+      file_index: index of a file in the cache
+      ordinal: index of a VERTEX_LIST among those in the file
+ Out: index of the cached mesh of that VERTEX_LIST in the file's meshes, or
+      -1 if it is not cached
+ ***********************************************************************/
+int dg_file_cache_find_mesh(struct dg_file_cache *cache, int file_index,
+                            int ordinal) {
+  struct dg_cached_file *file = &cache->files[file_index];
+  int lo = 0, hi = file->n_meshes;
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (file->meshes[mid].ordinal < ordinal)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if (lo < file->n_meshes && file->meshes[lo].ordinal == ordinal)
+    return lo;
+  return -1;
+}
+
+/************************************************************************
+ dg_file_cache_add_mesh:
+ In:  cache: the geometry files parsed so far
+      file_index: index of the file being parsed in the cache
+      ordinal: index of the VERTEX_LIST just parsed among those in the file
+      n_verts: count of vertices
+      vertices: parsed vertices (not yet scaled)
+      n_walls: count of walls
+      connections: parsed walls
+ Out: 0 on success, 1 on memory allocation failure. A copy of the vertices
+      and walls is kept unless it would take the arrays held by the cache
+      above its cap, the walls are not all triangles, or the VERTEX_LIST
+      was not parsed in file order.
+ ***********************************************************************/
+int dg_file_cache_add_mesh(struct dg_file_cache *cache, int file_index,
+                           int ordinal, int n_verts,
+                           struct vertex_list *vertices, int n_walls,
+                           struct element_connection_list *connections) {
+  struct dg_cached_file *file = &cache->files[file_index];
+  if (file->n_meshes > 0 &&
+      file->meshes[file->n_meshes - 1].ordinal >= ordinal)
+    return 0;
+
+  long long bytes = (long long)n_verts * sizeof(struct vector3) +
+                    (long long)n_walls * sizeof(struct element_data);
+  if (cache->mesh_bytes + bytes > cache->max_mesh_bytes)
+    return 0;
+
+  for (struct element_connection_list *ecl = connections; ecl != NULL;
+       ecl = ecl->next) {
+    if (ecl->n_verts != 3)
+      return 0;
+  }
+
+  if (file->n_meshes == file->max_meshes) {
+    int new_max = (file->max_meshes > 0) ? 2 * file->max_meshes : 8;
+    struct dg_cached_mesh *new_meshes = (struct dg_cached_mesh *)realloc(
+        file->meshes, new_max * sizeof(struct dg_cached_mesh));
+    if (new_meshes == NULL)
+      return 1;
+    file->meshes = new_meshes;
+    file->max_meshes = new_max;
+  }
+
+  struct vector3 *vertex_array = CHECKED_MALLOC_ARRAY(
+      struct vector3, n_verts, "cached dynamic geometry vertices");
+  struct element_data *elements = CHECKED_MALLOC_ARRAY(
+      struct element_data, n_walls, "cached dynamic geometry walls");
+  if (vertex_array == NULL || elements == NULL) {
+    free(vertex_array);
+    free(elements);
+    return 1;
+  }
+
+  struct vertex_list *vl = vertices;
+  for (int i = 0; i < n_verts; i++, vl = vl->next)
+    vertex_array[i] = *vl->vertex;
+  struct element_connection_list *ecl = connections;
+  for (int i = 0; i < n_walls; i++, ecl = ecl->next)
+    memcpy(elements[i].vertex_index, ecl->indices, 3 * sizeof(int));
+
+  struct dg_cached_mesh *mesh = &file->meshes[file->n_meshes++];
+  mesh->ordinal = ordinal;
+  mesh->n_verts = n_verts;
+  mesh->vertices = vertex_array;
+  mesh->n_walls = n_walls;
+  mesh->elements = elements;
+  cache->mesh_bytes += bytes;
+  return 0;
+}
+
+/************************************************************************
+ destroy_dg_file_cache:
+ In:  cache: the geometry files parsed so far
+ Out: None. The cache and the memory held by it are freed.
+ ***********************************************************************/
+void destroy_dg_file_cache(struct dg_file_cache *cache) {
+  for (int i = 0; i < cache->n_files; i++) {
+    struct dg_cached_file *file = &cache->files[i];
+    for (int j = 0; j < file->n_meshes; j++) {
+      free(file->meshes[j].vertices);
+      free(file->meshes[j].elements);
+    }
+    free(file->meshes);
+    free(file->path);
+  }
+  free(cache->files);
+  free(cache);
+}
+
 /************************************************************************
  add_dynamic_geometry_events:
  In:  dynamic_geometry_filename: filename and path for dyngeom file
@@ -1852,7 +2370,10 @@ int find_all_obj_region_transp(struct object *obj_ptr,
       dg_time_fname_head: the head of the dynamic geometry event list
  Out: 0 on success, 1 on failure. dynamic geometry events are added to
       dg_time_fname_head from which they will eventually be added to a
-      scheduler.
+      scheduler. A geometry file that recurs with the same contents (e.g. in
+      a periodic motion cycle) is only parsed the first time it occurs. The
+      files seen are kept in state->dg_file_cache, where the geometry events
+      also keep the meshes they parse (see mdl_cached_mesh_ahead).
  ***********************************************************************/
 int add_dynamic_geometry_events(
     struct mdlparse_vars *parse_state,
@@ -1877,6 +2398,17 @@ int add_dynamic_geometry_events(
     char *zero_file_name = NULL;
     int linecount = 0;
     int i;
+    // Kept for the rest of the run, so that the geometry events can reuse
+    // the meshes of files they parse again
+    struct dg_file_cache *parsed_files = CHECKED_MALLOC_STRUCT(
+        struct dg_file_cache, "dynamic geometry file cache");
+    if (parsed_files == NULL) {
+      fclose(f);
+      return 1;
+    }
+    memset(parsed_files, 0, sizeof(struct dg_file_cache));
+    parsed_files->max_mesh_bytes = state->mesh_cache_max_bytes;
+    state->dg_file_cache = parsed_files;
 
     while (fgets(buf, 2048, f)) {
       linecount++;
@@ -1924,14 +2456,29 @@ int add_dynamic_geometry_events(
         }
         // Do the normal DG parsing on every other time
         else {
-          parse_dg_init(dg_parse, full_file_name, state);
-          destroy_objects(state->root_instance, 0);
-          destroy_objects(state->root_object, 0);
+          // The objects and regions of a file that was already parsed are
+          // in the symbol tables already
+          int file_index, seen;
+          if (dg_file_cache_lookup(parsed_files, full_file_name, &file_index,
+                                   &seen)) {
+            destroy_dg_file_cache(parsed_files);
+            state->dg_file_cache = NULL;
+            free(zero_file_name);
+            fclose(f);
+            return 1;
+          }
+          if (!seen) {
+            parse_dg_init(dg_parse, full_file_name, state);
+            destroy_objects(state->root_instance, 0);
+            destroy_objects(state->root_object, 0);
+          }
 
           struct dg_time_filename *dyn_geom;
           dyn_geom = (struct dg_time_filename *)CHECKED_MEM_GET(dynamic_geometry_events_mem,
                                      "time-varying dynamic geometry");
           if (dyn_geom == NULL) {
+            destroy_dg_file_cache(parsed_files);
+            state->dg_file_cache = NULL;
             free(zero_file_name);
             fclose(f);
             return 1;
@@ -2175,6 +2722,7 @@ update_geometry:
 ***************************************************************************/
 void update_geometry(struct volume *state,
                      struct dg_time_filename *dyn_geom) {
+  flush_parked_molecules(state, NULL, 0);
   state->all_molecules = save_all_molecules(state, state->storage_head);
 
   // Turn off progress reports to avoid spamming mostly useless info to stdout
@@ -2199,6 +2747,8 @@ void update_geometry(struct volume *state,
   if (mcell_redo_geom(state)) {
     mcell_error("An error occurred while processing geometry changes.");
   }
+  // Cached tile neighbors may refer to walls that changed
+  state->grid_epoch++;
 
   // Make NEW list of fully qualified region names.
   struct string_buffer *new_region_names =
@@ -29,6 +29,13 @@
 #define MAX_NUM_REGIONS 100
 #define MAX_NUM_OBJECTS 100
 
+/* Default cap, in megabytes, on the vertex and wall arrays kept by the
+ * dynamic geometry file cache (see -mesh_cache_mb) */
+#define DG_MESH_CACHE_DEFAULT_MB 64
+
+/* Id of the empty list in a name_list_table */
+#define EMPTY_NAME_LIST 0
+
 struct mesh_transparency {
   struct mesh_transparency *next;
   char *name;
@@ -44,32 +51,76 @@ struct name_hits {
   int hits; /* molecule orientation */
 };
 
-struct n_parts {
-  int nx_parts;
-  int ny_parts;
-  int nz_parts;
+/* Vertices (unscaled, as written in the file) and walls of the polygon
+ * object defined by one VERTEX_LIST of a geometry file */
+struct dg_cached_mesh {
+  int ordinal;  /* index of the VERTEX_LIST among those in the file */
+  int n_verts;
+  struct vector3 *vertices;
+  int n_walls;
+  struct element_data *elements;
+};
+
+/* A geometry file that has already been parsed, identified by its path and
+ * the hash of its contents, with the meshes parsed from it */
+struct dg_cached_file {
+  char *path;
+  unsigned long long hash;
+  long size;
+  struct dg_cached_mesh *meshes;  /* sorted by ordinal */
+  int n_meshes;
+  int max_meshes;
 };
 
-struct molecule_info ** save_all_molecules(
+struct dg_file_cache {
+  struct dg_cached_file *files;
+  int n_files;
+  int max_files;
+  long long mesh_bytes;      /* bytes held by the cached meshes' arrays */
+  long long max_mesh_bytes;  /* cap on mesh_bytes */
+};
+
+int dg_file_cache_lookup(struct dg_file_cache *cache, const char *path,
+                         int *file_index, int *seen);
+
+int dg_file_cache_find_mesh(struct dg_file_cache *cache, int file_index,
+                            int ordinal);
+
+int dg_file_cache_add_mesh(struct dg_file_cache *cache, int file_index,
+                           int ordinal, int n_verts,
+                           struct vertex_list *vertices, int n_walls,
+                           struct element_connection_list *connections);
+
+void destroy_dg_file_cache(struct dg_file_cache *cache);
+
+int init_name_list_table(struct name_list_table *table, int n_walls);
+
+int intern_name_list(struct name_list_table *table, char *const *names,
+                     int n_names);
+
+struct string_buffer *name_list_strings(struct name_list_table *table,
+                                        int id);
+
+struct string_buffer *filtered_name_list(struct name_list_table *table,
+                                         int id,
+                                         struct string_buffer *names_to_ignore);
+
+void destroy_name_list_table(struct name_list_table *table);
+
+struct molecule_info *save_all_molecules(
     struct volume *state, struct storage_list *storage_head);
 
 void save_common_molecule_properties(struct molecule_info *mol_info,
-                                     struct abstract_molecule *am_ptr,
-                                     struct string_buffer *reg_names,
-                                     struct string_buffer *mesh_names,
-                                     char *mesh_name);
+                                     struct abstract_molecule *am_ptr);
 
 void save_volume_molecule(struct volume *state, struct molecule_info *mol_info,
-                          struct abstract_molecule *am_ptr,
-                          struct string_buffer **mesh_names);
+                          struct abstract_molecule *am_ptr);
 
-int save_surface_molecule(struct molecule_info *mol_info,
-                          struct abstract_molecule *am_ptr,
-                          struct string_buffer **reg_names,
-                          char **mesh_name);
+int save_surface_molecule(struct volume *state,
+                          struct molecule_info *mol_info,
+                          struct abstract_molecule *am_ptr);
 
-void cleanup_names_molecs(
-    int num_all_molecules, struct molecule_info **all_molecules);
+void cleanup_names_molecs(struct volume *state);
 
 int place_all_molecules(
     struct volume *state,
@@ -110,7 +161,7 @@ struct volume_molecule *insert_volume_molecule_encl_mesh(
     struct volume *state,
     struct volume_molecule *vm,
     struct volume_molecule *vm_guess,
-    struct string_buffer *mesh_names_old,
+    int mesh_names_old,
     struct string_buffer *names_to_ignore);
 
 int hit_wall(
@@ -118,8 +169,7 @@ int hit_wall(
     struct name_hits **name_tail, struct vector3 *rand_vector);
 
 void hit_subvol(
-    struct n_parts *np, struct string_buffer *mesh_names,
-    struct collision *smash, struct collision *shead,
+    struct string_buffer *mesh_names, struct collision *smash, struct collision *shead,
     struct name_hits *name_head, struct subvolume *sv,
     struct volume_molecule *virt_mol);
 
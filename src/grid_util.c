@@ -43,6 +43,20 @@
 #include "react.h"
 #include "init.h"
 
+/* Trailing-zero count for the vacancy bitmaps */
+#if defined(__GNUC__) || defined(__clang__)
+#define CTZLL(x) __builtin_ctzll(x)
+#else
+static int CTZLL(unsigned long long x) {
+  int n = 0;
+  while ((x & 1ULL) == 0) {
+    x >>= 1;
+    n++;
+  }
+  return n;
+}
+#endif
+
 /*************************************************************************
 xyz2uv and uv2xyz:
   In: 2D and 3D vectors and a wall
@@ -302,6 +316,33 @@ void init_grid_geometry(struct surface_grid *g) {
   g->n_tiles = g->n * g->n;
 }
 
+/*************************************************************************
+invalidate_adjacent_tile_neighbor_caches:
+  In: world: simulation state
+      w: a wall that just got a grid
+  Out: No return value. The cached neighbor tiles of the grids on the walls
+       sharing an edge or a vertex with w are freed, since their tiles may
+       now have neighbors on w.
+*************************************************************************/
+static void invalidate_adjacent_tile_neighbor_caches(struct volume *world,
+                                                     struct wall *w) {
+  for (int kk = 0; kk < 3; kk++) {
+    if (w->nb_walls[kk] != NULL && w->nb_walls[kk]->grid != NULL)
+      destroy_tile_neighbor_cache(w->nb_walls[kk]->grid);
+  }
+
+  if (!world->create_shared_walls_info_flag)
+    return;
+  for (int kk = 0; kk < 3; kk++) {
+    long long vert_idx = (long long)(w->vert[kk] - world->all_vertices);
+    for (struct wall_list *wl = world->walls_using_vertex[vert_idx];
+         wl != NULL; wl = wl->next) {
+      if (wl->this_wall != w && wl->this_wall->grid != NULL)
+        destroy_tile_neighbor_cache(wl->this_wall->grid);
+    }
+  }
+}
+
 /*************************************************************************
 create_grid:
   In: a wall pointer that needs to have its grid created
@@ -344,9 +385,25 @@ int create_grid(struct volume *world, struct wall *w, struct subvolume *guess) {
   for (unsigned int i = 0; i < sg->n_tiles; i++) {
     sg->sm_list[i] = NULL;
   }
+  sg->nbr_cache = NULL;
+
+  /* Every tile starts out vacant */
+  u_int n_words = (sg->n_tiles + 63) / 64;
+  u_int n_summary = (n_words + 63) / 64;
+  sg->vacancy_bits = CHECKED_MALLOC_ARRAY(unsigned long long, n_words,
+                                          "surface grid vacancy bits");
+  sg->vacancy_summary = CHECKED_MALLOC_ARRAY(unsigned long long, n_summary,
+                                             "surface grid vacancy summary");
+  memset(sg->vacancy_bits, 0, n_words * sizeof(unsigned long long));
+  memset(sg->vacancy_summary, 0, n_summary * sizeof(unsigned long long));
+  for (unsigned int i = 0; i < sg->n_tiles; i++)
+    mark_tile_vacant(sg, i);
 
   w->grid = sg;
 
+  /* Tiles next to this wall have new neighbors now */
+  invalidate_adjacent_tile_neighbor_caches(world, w);
+
   return 0;
 }
 
@@ -489,6 +546,69 @@ void grid_neighbors(struct volume *world, struct surface_grid *grid, int idx,
   }
 }
 
+/*************************************************************************
+mark_tile_vacant:
+  In: a surface grid
+      index of a tile on that grid that may have become vacant
+  Out: none.  The tile will be looked at by the next vacancy search.
+  Note: This must be called whenever a tile is vacated.  It is harmless to
+        call it for a tile that is still occupied.
+*************************************************************************/
+void mark_tile_vacant(struct surface_grid *g, u_int idx) {
+  u_int word = idx >> 6;
+  g->vacancy_bits[word] |= 1ULL << (idx & 63);
+  g->vacancy_summary[word >> 6] |= 1ULL << (word & 63);
+}
+
+/*************************************************************************
+next_vacant_tile:
+  In: a surface grid
+      first and last index of a range of tiles on that grid
+  Out: the lowest index in the range of a vacant tile, or -1 if all of them
+       are occupied.
+  Note: Tiles found to be occupied along the way are marked as such, so the
+        next search skips them along with every block of 64 or 4096 tiles
+        that is known to be full.
+*************************************************************************/
+int next_vacant_tile(struct surface_grid *g, u_int first, u_int last) {
+  u_int idx = first;
+  while (idx <= last) {
+    u_int word = idx >> 6;
+
+    /* Skip blocks of words that are all occupied */
+    unsigned long long summary =
+        g->vacancy_summary[word >> 6] & (~0ULL << (word & 63));
+    if (summary == 0) {
+      idx = ((word >> 6) + 1) << 12;
+      continue;
+    }
+    u_int next_word = ((word >> 6) << 6) + CTZLL(summary);
+    if (next_word != word) {
+      idx = next_word << 6;
+      continue;
+    }
+
+    unsigned long long bits = g->vacancy_bits[word] & (~0ULL << (idx & 63));
+    if (bits == 0) {
+      idx = (word + 1) << 6;
+      continue;
+    }
+
+    idx = (word << 6) + CTZLL(bits);
+    if (idx > last)
+      break;
+    if (!g->sm_list[idx] || !g->sm_list[idx]->sm)
+      return (int)idx;
+
+    /* Occupied after all; remember that */
+    g->vacancy_bits[word] &= ~(1ULL << (idx & 63));
+    if (g->vacancy_bits[word] == 0)
+      g->vacancy_summary[word >> 6] &= ~(1ULL << (word & 63));
+    idx++;
+  }
+  return -1;
+}
+
 /*************************************************************************
 nearest_free:
   In: a surface grid
@@ -498,15 +618,14 @@ nearest_free:
        to the vector, or -1 if no unoccupied points are found in range
   Note: we assume you've already checked the grid element that contains
         the point, so we don't bother looking there first.
-  Note: if no unoccupied tile is found, found_dist2 contains distance to
-        closest occupied tile.
+  Note: found_dist2 contains the distance to the tile found.  Only vacant
+        tiles in the part of each strip that is within range are looked at.
 *************************************************************************/
 
 int nearest_free(struct surface_grid *g, struct vector2 *v, double max_d2,
                  double *found_dist2) {
-  int h, i, j, k;
+  int i, j, k;
   int span;
-  int can_flip;
   int idx;
   double d2;
   double f, ff, fff;
@@ -521,6 +640,9 @@ int nearest_free(struct surface_grid *g, struct vector2 *v, double max_d2,
   idx = -1;
   d2 = 2 * max_d2 + 1.0;
 
+  /* Tile centers move along u by uv_vert1_u / n per step in j */
+  double du_j = 3.0 * over3n * g->surface->uv_vert1_u;
+
   for (k = 0; k < g->n; k++) {
     f = v->v - ((double)(3 * k + 1)) * over3n * g->surface->uv_vert2.v;
     ff = f - over3n * g->surface->uv_vert2.v;
@@ -530,30 +652,45 @@ int nearest_free(struct surface_grid *g, struct vector2 *v, double max_d2,
       continue; /* Entire strip is too far away */
 
     span = (g->n - k);
-    for (j = 0; j < span; j++) {
-      can_flip = (j != span - 1);
-      for (i = 0; i <= can_flip; i++) {
-        fff =
-            v->u - over3n * ((double)(3 * j + i + 1) * g->surface->uv_vert1_u +
-                             (double)(3 * k + i + 1) * g->surface->uv_vert2.u);
-        fff *= fff;
-        if (i)
-          fff += ff;
-        else
-          fff += f;
-
-        if (fff < max_d2 && (idx == -1 || fff < d2)) {
-          h = (g->n - k) - 1;
-          h = h * h + 2 * j + i;
-
-          if (!g->sm_list[h] || !g->sm_list[h]->sm) {
-            idx = h;
-            d2 = fff;
-          } else if (idx == -1) {
-            if (fff < d2)
-              d2 = fff;
-          }
-        }
+    int base = (span - 1) * (span - 1);
+    int j_lo = 0, j_hi = span - 1;
+
+    /* Narrow down the tiles of this strip whose centers can be in range */
+    if (du_j > 0) {
+      double du = sqrt(max_d2 - ((f < ff) ? f : ff));
+      double u0 = over3n * ((double)(3 * k + 1) * g->surface->uv_vert2.u +
+                            g->surface->uv_vert1_u);
+      double u1 = over3n * (2.0 * g->surface->uv_vert1_u +
+                            (double)(3 * k + 2) * g->surface->uv_vert2.u);
+      double u_min = (u0 < u1) ? u0 : u1;
+      double u_max = (u0 < u1) ? u1 : u0;
+      double lo = floor((v->u - du - u_max) / du_j) - 1;
+      double hi = ceil((v->u + du - u_min) / du_j) + 1;
+      if (lo > j_lo)
+        j_lo = (lo < j_hi) ? (int)lo : j_hi;
+      if (hi < j_hi)
+        j_hi = (hi > j_lo) ? (int)hi : j_lo;
+    }
+
+    int h_last = base + 2 * j_hi + 1;
+    if (h_last > base + 2 * span - 2)
+      h_last = base + 2 * span - 2;
+    for (int h = next_vacant_tile(g, base + 2 * j_lo, h_last); h != -1;
+         h = (h < h_last) ? next_vacant_tile(g, h + 1, h_last) : -1) {
+      j = (h - base) >> 1;
+      i = (h - base) & 1;
+      fff =
+          v->u - over3n * ((double)(3 * j + i + 1) * g->surface->uv_vert1_u +
+                           (double)(3 * k + i + 1) * g->surface->uv_vert2.u);
+      fff *= fff;
+      if (i)
+        fff += ff;
+      else
+        fff += f;
+
+      if (fff < max_d2 && (idx == -1 || fff < d2)) {
+        idx = h;
+        d2 = fff;
       }
     }
   }
@@ -795,6 +932,127 @@ void delete_tile_neighbor_list(struct tile_neighbor *head) {
   }
 }
 
+/***************************************************************************
+tile_neighbor_list_to_array:
+   In: head: linked list of neighbor tiles
+       array: growable array to append the tiles to
+       n: number of tiles already in the array
+       max: allocated size of the array
+   Out: The number of tiles appended.  The tiles keep the order of the list.
+****************************************************************************/
+static int tile_neighbor_list_to_array(struct tile_neighbor *head,
+                                       struct tile_ref **array, int n,
+                                       int *max) {
+  int count = 0;
+  for (struct tile_neighbor *tn = head; tn != NULL; tn = tn->next)
+    count++;
+
+  if (n + count > *max) {
+    int new_max = (*max > 0) ? 2 * *max : 64;
+    while (new_max < n + count)
+      new_max *= 2;
+    struct tile_ref *new_array =
+        (struct tile_ref *)realloc(*array, new_max * sizeof(struct tile_ref));
+    if (new_array == NULL)
+      mcell_allocfailed("Failed to grow array of neighbor tiles.");
+    *array = new_array;
+    *max = new_max;
+  }
+
+  for (struct tile_neighbor *tn = head; tn != NULL; tn = tn->next) {
+    (*array)[n].grid = tn->grid;
+    (*array)[n].idx = tn->idx;
+    n++;
+  }
+  return count;
+}
+
+/***************************************************************************
+destroy_tile_neighbor_cache:
+   In: grid: a surface grid
+   Out: none.  The cached neighbor tiles of the grid are freed.
+****************************************************************************/
+void destroy_tile_neighbor_cache(struct surface_grid *grid) {
+  struct tile_neighbor_cache *cache = grid->nbr_cache;
+  if (cache == NULL)
+    return;
+  free(cache->first);
+  free(cache->count);
+  free(cache->nbrs);
+  free(cache);
+  grid->nbr_cache = NULL;
+}
+
+/***************************************************************************
+find_neighbor_tile_array:
+   In: world: simulation state
+       sm: the surface molecule looking for reaction partners
+       grid: the grid the molecule is on
+       idx: the molecule's tile on that grid
+       nbrs: set to the neighbor tiles
+   Out: The number of neighbor tiles, which are the tiles find_neighbor_tiles
+        returns when searching for reactants, in the same order.  The array
+        stays valid until the next call.
+   Note: Unless the molecule interacts with region borders, its neighbors only
+         depend on the tile and on which walls have grids, so they are cached
+         on the grid until an adjacent wall gets a grid or the geometry
+         changes.
+****************************************************************************/
+int find_neighbor_tile_array(struct volume *world,
+                             struct surface_molecule *sm,
+                             struct surface_grid *grid, int idx,
+                             struct tile_ref **nbrs) {
+  struct tile_neighbor *tile_nbr_head = NULL;
+  int list_length = 0;
+
+  if (sm != NULL && (sm->properties->flags & CAN_REGION_BORDER)) {
+    find_neighbor_tiles(world, sm, grid, idx, 0, 1, &tile_nbr_head,
+                        &list_length);
+    int count = tile_neighbor_list_to_array(tile_nbr_head,
+                                            &world->tile_nbr_scratch, 0,
+                                            &world->max_tile_nbr_scratch);
+    delete_tile_neighbor_list(tile_nbr_head);
+    *nbrs = world->tile_nbr_scratch;
+    return count;
+  }
+
+  if (grid->nbr_cache != NULL &&
+      grid->nbr_cache->grid_epoch != world->grid_epoch)
+    destroy_tile_neighbor_cache(grid);
+
+  struct tile_neighbor_cache *cache = grid->nbr_cache;
+  if (cache == NULL) {
+    cache = CHECKED_MALLOC_STRUCT(struct tile_neighbor_cache,
+                                  "tile neighbor cache");
+    cache->grid_epoch = world->grid_epoch;
+    cache->first = CHECKED_MALLOC_ARRAY(int, grid->n_tiles,
+                                        "tile neighbor offsets");
+    cache->count = CHECKED_MALLOC_ARRAY(int, grid->n_tiles,
+                                        "tile neighbor counts");
+    for (u_int i = 0; i < grid->n_tiles; i++)
+      cache->first[i] = -1;
+    cache->nbrs = NULL;
+    cache->n_nbrs = 0;
+    cache->max_nbrs = 0;
+    grid->nbr_cache = cache;
+  }
+
+  if (cache->first[idx] < 0) {
+    /* The neighbors found without a molecule are the same for every molecule
+     * that ignores region borders */
+    find_neighbor_tiles(world, NULL, grid, idx, 0, 1, &tile_nbr_head,
+                        &list_length);
+    cache->first[idx] = cache->n_nbrs;
+    cache->count[idx] = tile_neighbor_list_to_array(
+        tile_nbr_head, &cache->nbrs, cache->n_nbrs, &cache->max_nbrs);
+    cache->n_nbrs += cache->count[idx];
+    delete_tile_neighbor_list(tile_nbr_head);
+  }
+
+  *nbrs = (cache->count[idx] > 0) ? cache->nbrs + cache->first[idx] : NULL;
+  return cache->count[idx];
+}
+
 /***************************************************************************
 delete_region_list:
    In: linked list of regions
@@ -1238,16 +1496,17 @@ void grid_all_neighbors_across_walls_through_vertices(
   long long origin_vert_indices[3], nbr_vert_indices[3];
   int i, k;
   int tiles_count = 0; /* number of tiles added */
-  /* list of restricted regions */
-  struct region_list *rlp_head_own_wall = NULL;
-  struct region_list *rlp_head_nbr_wall;
+  /* restricted regions */
+  struct bit_array *rlp_head_own_wall = NULL;
+  struct bit_array *rlp_head_nbr_wall = world->restricted_scratch_2;
 
   /* check for possible reflection (absorption) from the wall edges
      that may be region borders.  This is INSIDE_OUT check against
      molecule's own wall */
-  if ((sm != NULL) && (sm->properties->flags & CAN_REGION_BORDER)) {
-    rlp_head_own_wall =
-        find_restricted_regions_by_wall(world, sm->grid->surface, sm);
+  if ((sm != NULL) && (sm->properties->flags & CAN_REGION_BORDER) &&
+      fill_restricted_regions_by_wall(world, sm->grid->surface, sm,
+                                      world->restricted_scratch_1) > 0) {
+    rlp_head_own_wall = world->restricted_scratch_1;
   }
 
   /* only one corner tile from each neighbor wall
@@ -1259,7 +1518,6 @@ void grid_all_neighbors_across_walls_through_vertices(
      only one corner tile that shares a vertex with the origin wall */
   for (wl = wall_nbr_head; wl != NULL; wl = wl->next) {
     w = wl->this_wall;
-    rlp_head_nbr_wall = NULL;
 
     if (w->grid == NULL) {
       if (create_grid_flag) {
@@ -1276,7 +1534,7 @@ void grid_all_neighbors_across_walls_through_vertices(
        restricted region boundary and we DO NOT add
        tile on such wall to the list of neighbor tiles  */
     if (search_for_reactant && (rlp_head_own_wall != NULL)) {
-      if (!wall_belongs_to_all_regions_in_region_list(w, rlp_head_own_wall))
+      if (!wall_belongs_to_all_regions(w, rlp_head_own_wall))
         continue;
     }
 
@@ -1284,18 +1542,11 @@ void grid_all_neighbors_across_walls_through_vertices(
 
     if (sm != NULL) {
       if (search_for_reactant && (sm->properties->flags & CAN_REGION_BORDER)) {
-        rlp_head_nbr_wall = find_restricted_regions_by_wall(world, w, sm);
-
-        if (rlp_head_nbr_wall != NULL) {
-          if (!wall_belongs_to_all_regions_in_region_list(sm->grid->surface,
-                                                          rlp_head_nbr_wall)) {
-            delete_void_list((struct void_list *)rlp_head_nbr_wall);
-            continue;
-          } else {
-            /* we will add the tile on this wall to the list */
-            delete_void_list((struct void_list *)rlp_head_nbr_wall);
-          }
-        }
+        if (fill_restricted_regions_by_wall(world, w, sm,
+                                            rlp_head_nbr_wall) > 0 &&
+            !wall_belongs_to_all_regions(sm->grid->surface,
+                                         rlp_head_nbr_wall))
+          continue;
       }
     }
 
@@ -1345,9 +1596,6 @@ void grid_all_neighbors_across_walls_through_vertices(
 
   *list_length = tiles_count;
   *tile_neighbor_head = tile_nbr_head;
-
-  if (rlp_head_own_wall != NULL)
-    delete_void_list((struct void_list *)rlp_head_own_wall);
 }
 
 /**************************************************************************
@@ -1378,86 +1626,34 @@ void grid_all_neighbors_across_walls_through_edges(
   int root, rootrem, strip, stripe, flip;
   int temp_idx;
 
-  /* list of restricted regions */
-  struct region_list *rlp_head_own_wall = NULL;
-  struct region_list *rlp_head_nbr_wall_0 = NULL;
-  struct region_list *rlp_head_nbr_wall_1 = NULL;
-  struct region_list *rlp_head_nbr_wall_2 = NULL;
   /* flags */
-  int move_thru_border_0 = 1;
-  int move_thru_border_1 = 1;
-  int move_thru_border_2 = 1;
+  int move_thru_border[3] = { 1, 1, 1 };
 
   /* check for possible reflection (absorption) from the wall edges
      that may be region borders.  These are INSIDE_OUT and OUTSIDE-IN
      checks against molecule's own wall and neighbor wall */
   if ((sm != NULL) && search_for_reactant &&
       (sm->properties->flags & CAN_REGION_BORDER)) {
-    rlp_head_own_wall =
-        find_restricted_regions_by_wall(world, sm->grid->surface, sm);
-
-    if (sm->grid->surface->nb_walls[0] != NULL) {
-      rlp_head_nbr_wall_0 = find_restricted_regions_by_wall(
-          world, sm->grid->surface->nb_walls[0], sm);
-      if (rlp_head_own_wall != NULL) {
-        if (!wall_belongs_to_all_regions_in_region_list(
-                 sm->grid->surface->nb_walls[0], rlp_head_own_wall))
-          move_thru_border_0 = 0;
-      }
-      if (rlp_head_nbr_wall_0 != NULL) {
-        if (!wall_belongs_to_all_regions_in_region_list(sm->grid->surface,
-                                                        rlp_head_nbr_wall_0))
-          move_thru_border_0 = 0;
-      }
-      if (rlp_head_nbr_wall_0 != NULL)
-        delete_void_list((struct void_list *)rlp_head_nbr_wall_0);
-
-    } else {
-      move_thru_border_0 = 0;
-    }
-
-    if (sm->grid->surface->nb_walls[1] != NULL) {
-      rlp_head_nbr_wall_1 = find_restricted_regions_by_wall(
-          world, sm->grid->surface->nb_walls[1], sm);
-      if (rlp_head_own_wall != NULL) {
-        if (!wall_belongs_to_all_regions_in_region_list(
-                 sm->grid->surface->nb_walls[1], rlp_head_own_wall))
-          move_thru_border_1 = 0;
-      }
-      if (rlp_head_nbr_wall_1 != NULL) {
-        if (!wall_belongs_to_all_regions_in_region_list(sm->grid->surface,
-                                                        rlp_head_nbr_wall_1))
-          move_thru_border_1 = 0;
-      }
+    /* restricted regions */
+    struct bit_array *rlp_head_own_wall = world->restricted_scratch_1;
+    struct bit_array *rlp_head_nbr_wall = world->restricted_scratch_2;
+    int own_restricted = fill_restricted_regions_by_wall(
+        world, sm->grid->surface, sm, rlp_head_own_wall);
 
-      if (rlp_head_nbr_wall_1 != NULL)
-        delete_void_list((struct void_list *)rlp_head_nbr_wall_1);
-    } else {
-      move_thru_border_1 = 0;
-    }
-
-    if (sm->grid->surface->nb_walls[2] != NULL) {
-      rlp_head_nbr_wall_2 = find_restricted_regions_by_wall(
-          world, sm->grid->surface->nb_walls[2], sm);
-      if (rlp_head_own_wall != NULL) {
-        if (!wall_belongs_to_all_regions_in_region_list(
-                 sm->grid->surface->nb_walls[2], rlp_head_own_wall))
-          move_thru_border_2 = 0;
-      }
-      if (rlp_head_nbr_wall_2 != NULL) {
-        if (!wall_belongs_to_all_regions_in_region_list(sm->grid->surface,
-                                                        rlp_head_nbr_wall_2))
-          move_thru_border_2 = 0;
+    for (kk = 0; kk < 3; kk++) {
+      struct wall *nbr_wall = sm->grid->surface->nb_walls[kk];
+      if (nbr_wall == NULL) {
+        move_thru_border[kk] = 0;
+        continue;
       }
-
-      if (rlp_head_nbr_wall_2 != NULL)
-        delete_void_list((struct void_list *)rlp_head_nbr_wall_2);
-    } else {
-      move_thru_border_2 = 0;
+      if (own_restricted > 0 &&
+          !wall_belongs_to_all_regions(nbr_wall, rlp_head_own_wall))
+        move_thru_border[kk] = 0;
+      if (fill_restricted_regions_by_wall(world, nbr_wall, sm,
+                                          rlp_head_nbr_wall) > 0 &&
+          !wall_belongs_to_all_regions(sm->grid->surface, rlp_head_nbr_wall))
+        move_thru_border[kk] = 0;
     }
-
-    if (rlp_head_own_wall != NULL)
-      delete_void_list((struct void_list *)rlp_head_own_wall);
   }
 
   if ((u_int)idx >= grid->n_tiles) {
@@ -1529,7 +1725,7 @@ void grid_all_neighbors_across_walls_through_edges(
       /* get the neighbors from the neighbor walls */
       if ((grid->surface->nb_walls[2] != NULL) &&
           (grid->surface->nb_walls[2]->grid != NULL)) {
-        if (move_thru_border_2) {
+        if (move_thru_border[2]) {
           tiles_added = add_more_tile_neighbors_to_list_fast(
               &tile_nbr_head, grid, strip, stripe, flip, grid->surface->vert[0],
               grid->surface->vert[2], 2, grid->surface->nb_walls[2]->grid);
@@ -1539,7 +1735,7 @@ void grid_all_neighbors_across_walls_through_edges(
       if (strip == 0) {
         if ((grid->surface->nb_walls[0] != NULL) &&
             (grid->surface->nb_walls[0]->grid != NULL)) {
-          if (move_thru_border_0) {
+          if (move_thru_border[0]) {
             tiles_added = add_more_tile_neighbors_to_list_fast(
                 &tile_nbr_head, grid, strip, stripe, flip,
                 grid->surface->vert[0], grid->surface->vert[1], 0,
@@ -1551,7 +1747,7 @@ void grid_all_neighbors_across_walls_through_edges(
       if (strip == (grid->n - 2)) {
         if ((grid->surface->nb_walls[1] != NULL) &&
             (grid->surface->nb_walls[1]->grid != NULL)) {
-          if (move_thru_border_1) {
+          if (move_thru_border[1]) {
             tiles_added = add_more_tile_neighbors_to_list_fast(
                 &tile_nbr_head, grid, strip, stripe, flip,
                 grid->surface->vert[1], grid->surface->vert[2], 1,
@@ -1578,7 +1774,7 @@ void grid_all_neighbors_across_walls_through_edges(
         } else {
           if ((grid->surface->nb_walls[0] != NULL) &&
               (grid->surface->nb_walls[0]->grid != NULL)) {
-            if (move_thru_border_0) {
+            if (move_thru_border[0]) {
               /* get the neighbors from the neighbor walls */
               tiles_added = add_more_tile_neighbors_to_list_fast(
                   &tile_nbr_head, grid, strip, stripe, flip,
@@ -1590,7 +1786,7 @@ void grid_all_neighbors_across_walls_through_edges(
         }
         if ((grid->surface->nb_walls[1] != NULL) &&
             (grid->surface->nb_walls[1]->grid != NULL)) {
-          if (move_thru_border_1) {
+          if (move_thru_border[1]) {
             /* get the neighbors from the neighbor walls */
             tiles_added = add_more_tile_neighbors_to_list_fast(
                 &tile_nbr_head, grid, strip, stripe, flip,
@@ -1601,7 +1797,7 @@ void grid_all_neighbors_across_walls_through_edges(
         }
         if ((grid->surface->nb_walls[2] != NULL) &&
             (grid->surface->nb_walls[2]->grid != NULL)) {
-          if (move_thru_border_2) {
+          if (move_thru_border[2]) {
             /* get the neighbors from the neighbor walls */
             tiles_added = add_more_tile_neighbors_to_list_fast(
                 &tile_nbr_head, grid, strip, stripe, flip,
@@ -1647,7 +1843,7 @@ void grid_all_neighbors_across_walls_through_edges(
           /* it is the top left corner - special case */
           if ((grid->surface->nb_walls[0] != NULL) &&
               (grid->surface->nb_walls[0]->grid != NULL)) {
-            if (move_thru_border_0) {
+            if (move_thru_border[0]) {
               /* get the neighbors from the neighbor walls */
               tiles_added = add_more_tile_neighbors_to_list_fast(
                   &tile_nbr_head, grid, strip, stripe, flip,
@@ -1658,7 +1854,7 @@ void grid_all_neighbors_across_walls_through_edges(
           }
           if ((grid->surface->nb_walls[2] != NULL) &&
               (grid->surface->nb_walls[2]->grid != NULL)) {
-            if (move_thru_border_2) {
+            if (move_thru_border[2]) {
               /* get the neighbors from the neighbor walls */
               tiles_added = add_more_tile_neighbors_to_list_fast(
                   &tile_nbr_head, grid, strip, stripe, flip,
@@ -1736,7 +1932,7 @@ void grid_all_neighbors_across_walls_through_edges(
     /* put in the list tiles that are on the row above */
     if ((grid->surface->nb_walls[0] != NULL) &&
         (grid->surface->nb_walls[0]->grid != NULL)) {
-      if (move_thru_border_0) {
+      if (move_thru_border[0]) {
         /* get the neighbors from the neighbor walls */
         tiles_added = add_more_tile_neighbors_to_list_fast(
             &tile_nbr_head, grid, strip, stripe, flip, grid->surface->vert[0],
@@ -1749,7 +1945,7 @@ void grid_all_neighbors_across_walls_through_edges(
         ((u_int)idx == (grid->n_tiles - 2))) {
       if ((grid->surface->nb_walls[1] != NULL) &&
           (grid->surface->nb_walls[1]->grid != NULL)) {
-        if (move_thru_border_1) {
+        if (move_thru_border[1]) {
           /* get the neighbors from the neighbor walls */
           tiles_added = add_more_tile_neighbors_to_list_fast(
               &tile_nbr_head, grid, strip, stripe, flip, grid->surface->vert[1],
@@ -1830,7 +2026,7 @@ void grid_all_neighbors_across_walls_through_edges(
     /* put in the list tiles that are on the side */
     if ((grid->surface->nb_walls[1] != NULL) &&
         (grid->surface->nb_walls[1]->grid != NULL)) {
-      if (move_thru_border_1) {
+      if (move_thru_border[1]) {
         /* get the neighbors from the neighbor walls */
         tiles_added = add_more_tile_neighbors_to_list_fast(
             &tile_nbr_head, grid, strip, stripe, flip, grid->surface->vert[1],
@@ -59,6 +59,10 @@ void grid_neighbors(struct volume *world, struct surface_grid *grid, int idx,
                     int create_grid_flag, struct surface_grid **nb_grid,
                     int *nb_idx);
 
+void mark_tile_vacant(struct surface_grid *g, u_int idx);
+
+int next_vacant_tile(struct surface_grid *g, u_int first, u_int last);
+
 int nearest_free(struct surface_grid *sm, struct vector2 *v, double max_d2,
                  double *found_dist2);
 
@@ -76,6 +80,13 @@ struct wall *search_nbhd_for_free(struct volume *world, struct wall *origin,
 
 void delete_tile_neighbor_list(struct tile_neighbor *head);
 
+void destroy_tile_neighbor_cache(struct surface_grid *grid);
+
+int find_neighbor_tile_array(struct volume *world,
+                             struct surface_molecule *sm,
+                             struct surface_grid *grid, int idx,
+                             struct tile_ref **nbrs);
+
 void delete_region_list(struct region_list *head);
 
 void push_tile_neighbor_to_list(struct tile_neighbor **head,
@@ -31,6 +31,7 @@
 #include <unistd.h>
 #include <math.h>
 #include <float.h>
+#include <stdint.h>
 #include <time.h>
 #include <sys/types.h>
 #ifndef _WIN32
@@ -49,6 +50,7 @@
 #include "viz_output.h"
 #include "react.h"
 #include "react_output.h"
+#include "react_util.h"
 #include "chkpt.h"
 #include "init.h"
 #include "mdlparse_aux.h"
@@ -73,6 +75,8 @@ static int compute_bb_release_site(struct volume *world, struct object *objp,
                                    double (*im)[4]);
 static int compute_bb_polygon_object(struct volume *world, struct object *objp,
                                      double (*im)[4]);
+static struct vector3 *next_parsed_vertex(struct polygon_object *pop, int i,
+                                          struct vertex_list **vl);
 
 static int init_species_defaults(struct volume *world);
 static int init_regions_helper(struct volume *world);
@@ -533,6 +537,12 @@ int init_data_structures(struct volume *world) {
     return 1;
   }
 
+  world->rate_change_scheduler = create_scheduler(1.0, 100.0, 100, 0.0);
+  if (world->rate_change_scheduler == NULL) {
+    mcell_allocfailed_nodie("Failed to create rate change scheduler.");
+    return 1;
+  }
+
   init_dynamic_geometry(world);
 
   return 0;
@@ -612,6 +622,310 @@ int init_species(struct volume *world) {
   return 0;
 }
 
+/***********************************************************************
+compare_doubles:
+  In: a, b: pointers to the doubles to compare
+  Out: -1, 0 or 1 as *a is less than, equal to or greater than *b (for
+       qsort)
+***********************************************************************/
+static int compare_doubles(const void *a, const void *b) {
+  double da = *(const double *)a;
+  double db = *(const double *)b;
+  return (da > db) - (da < db);
+}
+
+/***********************************************************************
+collect_wall_sizes:
+  In: objp: an object that has been parsed but not instantiated yet
+      im: transformation matrix of the parent object
+      sizes: array receiving the square roots of the wall areas
+      n_sizes: number of entries of sizes filled so far, updated
+      max_sizes: length of sizes
+  Out: No return value. The sizes of the walls of objp and its children
+       are appended to sizes, after applying the object transformations.
+       Walls removed with REMOVE_ELEMENTS are skipped.
+***********************************************************************/
+static void collect_wall_sizes(struct object *objp, double (*im)[4],
+                               double *sizes, int *n_sizes, int max_sizes) {
+  double tm[4][4];
+  mult_matrix(objp->t_matrix, im, tm, 4, 4, 4);
+
+  switch (objp->object_type) {
+  case META_OBJ:
+    for (struct object *child_objp = objp->first_child; child_objp != NULL;
+         child_objp = child_objp->next)
+      collect_wall_sizes(child_objp, tm, sizes, n_sizes, max_sizes);
+    break;
+
+  case BOX_OBJ:
+  case POLY_OBJ: {
+    struct polygon_object *pop = (struct polygon_object *)objp->contents;
+    if (pop->n_verts <= 0 || pop->n_walls <= 0)
+      break;
+
+    struct vector3 *verts =
+        CHECKED_MALLOC_ARRAY(struct vector3, pop->n_verts, "wall vertices");
+    struct vertex_list *vl = pop->parsed_vertices;
+    for (int i = 0; i < pop->n_verts; i++) {
+      struct vector3 *vertex = next_parsed_vertex(pop, i, &vl);
+      double p[1][4];
+      p[0][0] = vertex->x;
+      p[0][1] = vertex->y;
+      p[0][2] = vertex->z;
+      p[0][3] = 1.0;
+      mult_matrix(p, tm, p, 1, 4, 4);
+      verts[i].x = p[0][0];
+      verts[i].y = p[0][1];
+      verts[i].z = p[0][2];
+    }
+
+    for (int n_wall = 0; n_wall < pop->n_walls && *n_sizes < max_sizes;
+         n_wall++) {
+      if (get_bit(pop->side_removed, n_wall))
+        continue;
+      int *index = pop->element[n_wall].vertex_index;
+      if (index[0] >= pop->n_verts || index[1] >= pop->n_verts ||
+          index[2] >= pop->n_verts)
+        continue;
+      struct vector3 e0, e1, normal;
+      vectorize(&verts[index[0]], &verts[index[1]], &e0);
+      vectorize(&verts[index[0]], &verts[index[2]], &e1);
+      cross_prod(&e0, &e1, &normal);
+      sizes[(*n_sizes)++] = sqrt(0.5 * vect_length(&normal));
+    }
+    free(verts);
+  } break;
+
+  case REL_SITE_OBJ:
+  case VOXEL_OBJ:
+  default:
+    break;
+  }
+}
+
+/***********************************************************************
+typical_wall_size:
+  In: world: simulation state, with the bounding box initialized
+  Out: the median of the square roots of the wall areas, in internal units,
+       or 0 if there are no walls
+  Note: The walls are measured on the parsed polygon objects, so this can
+        be used before the partitions and walls are created.
+***********************************************************************/
+static double typical_wall_size(struct volume *world) {
+  if (world->n_walls <= 0)
+    return 0;
+
+  double *sizes =
+      CHECKED_MALLOC_ARRAY(double, world->n_walls, "wall sizes");
+  int n_sizes = 0;
+  double tm[4][4];
+  init_matrix(tm);
+  collect_wall_sizes(world->root_instance, tm, sizes, &n_sizes,
+                     world->n_walls);
+  if (n_sizes == 0) {
+    free(sizes);
+    return 0;
+  }
+  qsort(sizes, n_sizes, sizeof(double), compare_doubles);
+  double size = sizes[n_sizes / 2];
+  free(sizes);
+  return size;
+}
+
+/***********************************************************************
+auto_step_pb_factor:
+  In: world: simulation state, with reactions initialized
+      rx: a reaction
+  Out: the pb_factor of the reaction for the current species time steps
+***********************************************************************/
+static double auto_step_pb_factor(struct volume *world, struct rxn *rx) {
+  struct reaction_flags rxn_flags = world->rxn_flags;
+  int create_shared_walls_info_flag = 0;
+  /* rx_radius_3d was converted to internal units by init_reactions */
+  return compute_pb_factor(world->time_unit, world->length_unit,
+                           world->grid_density,
+                           world->rx_radius_3d * world->length_unit,
+                           &rxn_flags, &create_shared_walls_info_flag, rx, 0);
+}
+
+/***********************************************************************
+is_surf_surf_rxn:
+  In: rx: a reaction
+  Out: 1 if every reactant of rx is a surface molecule, 0 otherwise. The
+       per-step probability of such a reaction grows linearly with the time
+       step of the surface molecule that initiates it.
+***********************************************************************/
+static int is_surf_surf_rxn(struct rxn *rx) {
+  for (unsigned int j = 0; j < rx->n_reactants; j++) {
+    if ((rx->players[j]->flags & NOT_FREE) != ON_GRID)
+      return 0;
+  }
+  return 1;
+}
+
+/***********************************************************************
+set_species_time_step:
+  In: world: simulation state
+      spec: a volume or surface species
+      time_step: new time step, in internal units
+  Out: No return value. The time step and the matching space step of the
+       species are set as for a CUSTOM_TIME_STEP.
+***********************************************************************/
+static void set_species_time_step(struct volume *world, struct species *spec,
+                                  double time_step) {
+  spec->time_step = time_step;
+  spec->space_step = sqrt(4.0 * 1.0e8 * spec->D * time_step *
+                          world->time_unit) * world->r_length_unit;
+}
+
+/***********************************************************************
+init_auto_time_steps:
+  In: world: simulation state, with reactions and the bounding box
+             initialized. Must run before init_partitions, which sizes the
+             subvolumes from the resulting speed_limit.
+  Out: 0 on success. With -auto_time_step, every diffusing volume and
+       surface species still on the global time step gets the longest time
+       step for which
+       - no bimolecular reaction of the species exceeds the requested
+         probability per step, and
+       - the space step stays within the requested fraction of the
+         typical wall size (if given), and
+       - TIME_STEP_MAX (if set) is not exceeded.
+       Reaction probabilities are rescaled to the new time steps, and the
+       expected speedup is reported.
+  Note: The per-step probability of reactions initiated by a volume
+        molecule grows with the square root of its time step, so those
+        steps are shrunk by the square of the excess. Surface-surface
+        reactions grow linearly with the surface molecule's step, so those
+        steps are shrunk by the excess itself. Surface molecules in
+        volume-surface reactions are hit by the volume molecule and keep
+        their step.
+***********************************************************************/
+int init_auto_time_steps(struct volume *world) {
+  if (world->auto_max_rxn_prob <= 0)
+    return 0;
+
+  double *old_steps =
+      CHECKED_MALLOC_ARRAY(double, world->n_species, "old time steps");
+  char *is_auto = CHECKED_MALLOC_ARRAY(char, world->n_species,
+                                       "automatic time step flags");
+
+  double wall_size = typical_wall_size(world);
+  double max_space_step = world->auto_max_step_fraction * wall_size *
+                          world->length_unit;
+  for (int i = 0; i < world->n_species; i++) {
+    struct species *spec = world->species_list[i];
+    old_steps[i] = spec->time_step;
+    is_auto[i] = ((spec->flags & (IS_SURFACE | EXTERNAL_SPECIES)) == 0 &&
+                  spec != world->all_mols && spec != world->all_volume_mols &&
+                  spec != world->all_surface_mols && spec->D > 0 &&
+                  spec->time_step == 1.0);
+    if (!is_auto[i])
+      continue;
+
+    /* Longest step allowed by the geometry and TIME_STEP_MAX; without
+     * either, steps may only get shorter */
+    double time_step = 1.0;
+    if (max_space_step > 0)
+      time_step = max_space_step * max_space_step /
+                  (4.0 * 1.0e8 * spec->D * world->time_unit);
+    if (world->time_step_max > 0 &&
+        time_step > world->time_step_max / world->time_unit)
+      time_step = world->time_step_max / world->time_unit;
+    set_species_time_step(world, spec, time_step);
+  }
+
+  /* Shrink steps until every reaction is likely enough to be resolved */
+  for (int pass = 0, changed = 1; changed && pass < 100; pass++) {
+    changed = 0;
+    for (int i = 0; i < world->rx_hashsize; i++) {
+      for (struct rxn *rx = world->reaction_hash[i]; rx != NULL;
+           rx = rx->next) {
+        if (rx->n_reactants < 2 || rx->n_pathways <= RX_SPECIAL ||
+            rx->pb_factor <= 0)
+          continue;
+        if (is_surf_surf_rxn(rx)) {
+          /* pb_factor does not depend on the steps here; the step of the
+           * surface molecule that initiates the reaction scales it */
+          for (unsigned int j = 0; j < rx->n_reactants; j++) {
+            struct species *spec = rx->players[j];
+            double p = rx->max_fixed_p * spec->time_step;
+            if (!is_auto[spec->species_id] || p <= world->auto_max_rxn_prob)
+              continue;
+            double shrink = 0.999 * world->auto_max_rxn_prob / p;
+            set_species_time_step(world, spec, spec->time_step * shrink);
+            changed = 1;
+          }
+          continue;
+        }
+        double p = rx->max_fixed_p / rx->pb_factor *
+                   auto_step_pb_factor(world, rx);
+        if (p <= world->auto_max_rxn_prob)
+          continue;
+        double shrink = world->auto_max_rxn_prob / p;
+        shrink *= 0.999 * shrink;
+        for (unsigned int j = 0; j < rx->n_reactants; j++) {
+          struct species *spec = rx->players[j];
+          if (!is_auto[spec->species_id] || (spec->flags & ON_GRID) != 0)
+            continue;
+          set_species_time_step(world, spec, spec->time_step * shrink);
+          changed = 1;
+        }
+      }
+    }
+  }
+
+  /* Rescale the reaction probabilities to the new steps */
+  world->reaction_prob_limit_flag = 0;
+  for (int i = 0; i < world->rx_hashsize; i++) {
+    for (struct rxn *rx = world->reaction_hash[i]; rx != NULL; rx = rx->next) {
+      if (rx->n_reactants < 2 || rx->n_pathways <= RX_SPECIAL ||
+          rx->pb_factor <= 0)
+        continue;
+      double pb_factor = auto_step_pb_factor(world, rx);
+      double ratio = pb_factor / rx->pb_factor;
+      for (int n = 0; n < rx->n_pathways; n++)
+        rx->cum_probs[n] *= ratio;
+      rx->max_fixed_p *= ratio;
+      rx->min_noreaction_p *= ratio;
+      for (struct t_func *tp = rx->prob_t; tp != NULL; tp = tp->next)
+        tp->value *= ratio;
+      rx->pb_factor = pb_factor;
+      if (rx->max_fixed_p > 1.0)
+        world->reaction_prob_limit_flag = 1;
+    }
+  }
+
+  /* Steps needed per unit of simulated time, before and after, weighting
+   * every species equally */
+  double old_rate = 0;
+  double new_rate = 0;
+  world->speed_limit = 0;
+  for (int i = 0; i < world->n_species; i++) {
+    struct species *spec = world->species_list[i];
+    if ((spec->flags & NOT_FREE) == 0 && spec->space_step > 0) {
+      double speed = 6.0 * spec->space_step / sqrt(MY_PI);
+      if (speed > world->speed_limit)
+        world->speed_limit = speed;
+    }
+    if (!is_auto[i])
+      continue;
+    old_rate += 1.0 / old_steps[i];
+    new_rate += 1.0 / spec->time_step;
+    if (world->notify->progress_report != NOTIFY_NONE)
+      mcell_log("Automatic time step for '%s': %.15g s (%.3g x global).",
+                spec->sym->name, spec->time_step * world->time_unit,
+                spec->time_step);
+  }
+  if (new_rate > 0 && world->notify->progress_report != NOTIFY_NONE)
+    mcell_log("Automatic time steps: expected diffusion speedup %.3g.",
+              old_rate / new_rate);
+
+  free(old_steps);
+  free(is_auto);
+  return 0;
+}
+
 /***********************************************************************
  *
  * initialize the models' vertices and walls
@@ -696,10 +1010,17 @@ int init_vertices_walls(struct volume *world) {
 
   if (world->notify->progress_report != NOTIFY_NONE)
     mcell_log("Creating edges...");
+  struct rusage edge_start, edge_end;
+  getrusage(RUSAGE_SELF, &edge_start);
   if (sharpen_world(world)) {
     mcell_error_nodie("Unknown error while adding edges to geometry.");
     return 1;
   }
+  getrusage(RUSAGE_SELF, &edge_end);
+  world->edge_init_time +=
+      (edge_end.ru_utime.tv_sec - edge_start.ru_utime.tv_sec) +
+      (edge_end.ru_utime.tv_usec - edge_start.ru_utime.tv_usec) /
+          MAX_TARGET_TIMESTEP;
 
   return 0;
 }
@@ -728,6 +1049,11 @@ int init_regions(struct volume *world) {
     return 1;
   }
 
+  if (init_counting_region_index(world)) {
+    mcell_error_nodie("Out of memory while indexing counted regions.");
+    return 1;
+  }
+
   /* flags that tell whether there are regions set with surface classes
      that contain ALL_MOLECULES or ALL_SURFACE_MOLECULES keywords.*/
   int all_mols_region_present = 0, all_surf_mols_region_present = 0;
@@ -1519,6 +1845,16 @@ int init_partitions(struct volume *world) {
         if (k == world->nz_parts - 2)
           sv->world_edge |= Z_POS_BIT;
 
+        /* Remember the adjacent subvolumes so traversal is a lookup */
+        int x_stride = (world->nz_parts - 1) * (world->ny_parts - 1);
+        int y_stride = world->nz_parts - 1;
+        sv->neighbor[X_NEG] = (i == 0) ? NULL : sv - x_stride;
+        sv->neighbor[X_POS] = (i == world->nx_parts - 2) ? NULL : sv + x_stride;
+        sv->neighbor[Y_NEG] = (j == 0) ? NULL : sv - y_stride;
+        sv->neighbor[Y_POS] = (j == world->ny_parts - 2) ? NULL : sv + y_stride;
+        sv->neighbor[Z_NEG] = (k == 0) ? NULL : sv - 1;
+        sv->neighbor[Z_POS] = (k == world->nz_parts - 2) ? NULL : sv + 1;
+
         /* Bind this subvolume to the appropriate storage */
         int shidx =
             (i / (world->mem_part_x)) +
@@ -1669,6 +2005,23 @@ int accumulate_vertex_counts_per_storage(struct volume *world,
   return 0;
 }
 
+/*************************************************************************
+next_parsed_vertex:
+    In: pop: a polygon object that has not been instantiated yet
+        i: index of the vertex
+        vl: position in pop->parsed_vertices, advanced past vertex i
+    Out: Vertex i of the polygon object, taken from the flat vertex array
+         of meshes read from binary files or else from the parsed list.
+**************************************************************************/
+static struct vector3 *next_parsed_vertex(struct polygon_object *pop, int i,
+                                          struct vertex_list **vl) {
+  if (pop->vertex_array != NULL)
+    return &pop->vertex_array[i];
+  struct vector3 *vertex = (*vl)->vertex;
+  *vl = (*vl)->next;
+  return vertex;
+}
+
 /*************************************************************************
 accumulate_vertex_counts_per_storage_polygon_object:
         Array of vertex counts per storage is updated for each
@@ -1684,7 +2037,6 @@ accumulate_vertex_counts_per_storage_polygon_object:
 int accumulate_vertex_counts_per_storage_polygon_object(
     struct volume *world, struct object *objp, int *num_vertices_this_storage,
     double (*im)[4]) {
-  struct vertex_list *vl;
   struct vector3 v;
   struct polygon_object *pop;
   /* index in the "simulated" array of storages that follows
@@ -1693,11 +2045,13 @@ int accumulate_vertex_counts_per_storage_polygon_object(
 
   pop = (struct polygon_object *)objp->contents;
 
-  for (vl = pop->parsed_vertices; vl != NULL; vl = vl->next) {
+  struct vertex_list *vl = pop->parsed_vertices;
+  for (int i = 0; i < pop->n_verts; i++) {
+    struct vector3 *vertex = next_parsed_vertex(pop, i, &vl);
     double p[4][4];
-    p[0][0] = vl->vertex->x;
-    p[0][1] = vl->vertex->y;
-    p[0][2] = vl->vertex->z;
+    p[0][0] = vertex->x;
+    p[0][1] = vertex->y;
+    p[0][2] = vertex->z;
     p[0][3] = 1.0;
     mult_matrix(p, im, p, 1, 4, 4);
 
@@ -1802,7 +2156,6 @@ int fill_world_vertices_array_polygon_object(struct volume *world,
                                              double (*im)[4]) {
 
   struct polygon_object *pop;
-  struct vertex_list *vl;
   int cur_vtx = 0; /* index */
   int which_storage, where_in_array;
   struct vector3 *v, vv;
@@ -1812,11 +2165,13 @@ int fill_world_vertices_array_polygon_object(struct volume *world,
   objp->vertices =
       CHECKED_MALLOC_ARRAY(struct vector3 *, objp->n_verts, "polygon vertices");
 
-  for (vl = pop->parsed_vertices; vl != NULL; vl = vl->next) {
+  struct vertex_list *vl = pop->parsed_vertices;
+  for (int i = 0; i < pop->n_verts; i++) {
+    struct vector3 *vertex = next_parsed_vertex(pop, i, &vl);
     double p[4][4];
-    p[0][0] = vl->vertex->x;
-    p[0][1] = vl->vertex->y;
-    p[0][2] = vl->vertex->z;
+    p[0][0] = vertex->x;
+    p[0][1] = vertex->y;
+    p[0][2] = vertex->z;
     p[0][3] = 1.0;
     mult_matrix(p, im, p, 1, 4, 4);
 
@@ -2000,13 +2355,13 @@ static int compute_bb_polygon_object(struct volume *world, struct object *objp,
 
   struct polygon_object *pop = (struct polygon_object *)objp->contents;
 
-  for (struct vertex_list *vl = pop->parsed_vertices;
-       vl != NULL;
-       vl = vl->next) {
+  struct vertex_list *vl = pop->parsed_vertices;
+  for (int i = 0; i < pop->n_verts; i++) {
+    struct vector3 *vertex = next_parsed_vertex(pop, i, &vl);
     double p[1][4];
-    p[0][0] = vl->vertex->x;
-    p[0][1] = vl->vertex->y;
-    p[0][2] = vl->vertex->z;
+    p[0][0] = vertex->x;
+    p[0][1] = vertex->y;
+    p[0][2] = vertex->z;
     p[0][3] = 1.0;
     mult_matrix(p, im, p, 1, 4, 4);
     if (p[0][0] < world->bb_llf.x)
@@ -2055,6 +2410,8 @@ int instance_polygon_object(enum warn_level_t degenerate_polys,
     free_vertex_list(pop->parsed_vertices);
     pop->parsed_vertices = NULL;
   }
+  free(pop->vertex_array);
+  pop->vertex_array = NULL;
 
   degenerate_count = 0;
   for (int n_wall = 0; n_wall < n_walls; ++n_wall) {
@@ -2545,52 +2902,51 @@ int instance_obj_surf_mols(struct volume *world, struct object *objp) {
 
     In:  struct object *objp - the object upon which to instantiate molecules
     Out: 0 on success, 1 on failure
+    Note: The densities to place on each wall are collected in one array,
+          grouped by wall, which points at the sm_dat of the regions and
+          surface classes instead of copying them for every wall.  The
+          entries of a wall are in the order in which they used to be
+          prepended to a per-wall list, so the random numbers are used in
+          the same way.
  *******************************************************************/
 int init_wall_surf_mols(struct volume *world, struct object *objp) {
-  struct sm_dat *smdp, *dup_smdp, **sm_prop;
+  struct sm_dat *smdp;
   struct region_list *rlp, *rlp2, *reg_sm_num_head;
-  /* byte all_region; */ /* flag that points to the region called ALL */
   struct surf_class_list *scl;
 
   const struct polygon_object *pop = (struct polygon_object *)objp->contents;
   int n_walls = pop->n_walls;
 
-  /* allocate scratch storage to hold surface molecule info for each wall */
-  sm_prop = CHECKED_MALLOC_ARRAY(struct sm_dat *, n_walls,
-                                 "surface molecule data scratch space");
+  /* count the densities to place on each wall; wall_start[n_wall + 1] ends
+     up holding the count for wall n_wall */
+  int *wall_start = CHECKED_MALLOC_ARRAY(int, n_walls + 2,
+                                         "surface molecule data offsets");
+  memset(wall_start, 0, (n_walls + 2) * sizeof(int));
 
-  for (int n_wall = 0; n_wall < n_walls; ++n_wall)
-    sm_prop[n_wall] = NULL;
-
-  /* prepend a copy of sm_dat for each element referenced in each region
-     of this object to the sm_prop list for the referenced element */
   reg_sm_num_head = NULL;
 
   for (rlp = objp->regions; rlp != NULL; rlp = rlp->next) {
     struct region *rp = rlp->reg;
     byte reg_sm_num = 0;
 
-    /* all_region = (strcmp(rp->region_last_name, "ALL") == 0); */
+    int n_dens = 0, n_num = 0;
+    for (smdp = rp->sm_dat_head; smdp != NULL; smdp = smdp->next) {
+      if (smdp->quantity_type == SURFMOLDENS)
+        n_dens++;
+      else
+        n_num++;
+    }
 
     /* Place molecules defined through DEFINE_SURFACE_REGIONS */
-    for (int n_wall = 0; n_wall < rp->membership->nbits; n_wall++) {
-      if (get_bit(rp->membership, n_wall)) {
-        /* prepend region sm data for this region to sm_prop for i_th wall */
-        for (smdp = rp->sm_dat_head; smdp != NULL; smdp = smdp->next) {
-          if (smdp->quantity_type == SURFMOLDENS) {
-            dup_smdp =
-                CHECKED_MALLOC_STRUCT(struct sm_dat, "surface molecule data");
-            dup_smdp->sm = smdp->sm;
-            dup_smdp->quantity_type = smdp->quantity_type;
-            dup_smdp->quantity = smdp->quantity;
-            dup_smdp->orientation = smdp->orientation;
-            dup_smdp->next = sm_prop[n_wall];
-            sm_prop[n_wall] = dup_smdp;
-          } else
+    if (n_dens > 0 || n_num > 0) {
+      for (int n_wall = 0; n_wall < rp->membership->nbits; n_wall++) {
+        if (get_bit(rp->membership, n_wall)) {
+          wall_start[n_wall + 2] += n_dens;
+          if (n_num > 0)
             reg_sm_num = 1;
         }
       }
-    } /* done checking each wall */
+    }
 
     if (rp->surf_class != NULL) {
       for (smdp = rp->surf_class->sm_dat_head; smdp != NULL;
@@ -2610,7 +2966,7 @@ int init_wall_surf_mols(struct volume *world, struct object *objp) {
       rlp2->next = reg_sm_num_head;
       reg_sm_num_head = rlp2;
     }
-  } /*end for (... ; rlp != NULL ; ...) */
+  }
 
   /* Place molecules defined through DEFINE_SURFACE_CLASSES */
   for (int n_wall = 0; n_wall < n_walls; n_wall++) {
@@ -2621,28 +2977,71 @@ int init_wall_surf_mols(struct volume *world, struct object *objp) {
     for (scl = w->surf_class_head; scl != NULL; scl = scl->next) {
       for (smdp = scl->surf_class->sm_dat_head; smdp != NULL;
            smdp = smdp->next) {
-        if (smdp->quantity_type == SURFMOLDENS) {
-          dup_smdp =
-              CHECKED_MALLOC_STRUCT(struct sm_dat, "surface molecule data");
-          dup_smdp->sm = smdp->sm;
-          dup_smdp->quantity_type = smdp->quantity_type;
-          dup_smdp->quantity = smdp->quantity;
-          dup_smdp->orientation = smdp->orientation;
-          dup_smdp->next = sm_prop[n_wall];
-          sm_prop[n_wall] = dup_smdp;
+        if (smdp->quantity_type == SURFMOLDENS)
+          wall_start[n_wall + 2]++;
+      }
+    }
+  }
+
+  /* turn the counts into offsets so that wall_start[n_wall + 1] is the end
+     of wall n_wall's entries; each wall is then filled from the back, so
+     that the last entry found comes first */
+  for (int n_wall = 0; n_wall < n_walls; n_wall++)
+    wall_start[n_wall + 2] += wall_start[n_wall + 1];
+  int n_entries = wall_start[n_walls + 1];
+  for (int n_wall = 0; n_wall <= n_walls; n_wall++)
+    wall_start[n_wall] = wall_start[n_wall + 1];
+
+  struct sm_dat **sm_prop = NULL;
+  if (n_entries > 0) {
+    sm_prop = CHECKED_MALLOC_ARRAY(struct sm_dat *, n_entries,
+                                   "surface molecule data scratch space");
+
+    for (rlp = objp->regions; rlp != NULL; rlp = rlp->next) {
+      struct region *rp = rlp->reg;
+      int n_dens = 0;
+      for (smdp = rp->sm_dat_head; smdp != NULL; smdp = smdp->next) {
+        if (smdp->quantity_type == SURFMOLDENS)
+          n_dens++;
+      }
+      if (n_dens == 0)
+        continue;
+
+      for (int n_wall = 0; n_wall < rp->membership->nbits; n_wall++) {
+        if (get_bit(rp->membership, n_wall)) {
+          for (smdp = rp->sm_dat_head; smdp != NULL; smdp = smdp->next) {
+            if (smdp->quantity_type == SURFMOLDENS)
+              sm_prop[--wall_start[n_wall + 1]] = smdp;
+          }
+        }
+      }
+    }
+
+    for (int n_wall = 0; n_wall < n_walls; n_wall++) {
+      struct wall *w = objp->wall_p[n_wall];
+      if (w == NULL)
+        continue;
+
+      for (scl = w->surf_class_head; scl != NULL; scl = scl->next) {
+        for (smdp = scl->surf_class->sm_dat_head; smdp != NULL;
+             smdp = smdp->next) {
+          if (smdp->quantity_type == SURFMOLDENS)
+            sm_prop[--wall_start[n_wall + 1]] = smdp;
         }
       }
     }
   }
+  /* wall_start[n_wall + 1] is back at the start of wall n_wall's entries,
+     and wall_start[n_wall + 2] at their end */
 
   /* Place regular (non-macro) molecules by density */
   for (int n_wall = 0; n_wall < n_walls; n_wall++) {
-    if (!get_bit(pop->side_removed, n_wall)) {
-      if (sm_prop[n_wall] != NULL) {
-        if (init_surf_mols_by_density(world, objp->wall_p[n_wall],
-                                      sm_prop[n_wall]))
-          return 1;
-      }
+    int first = wall_start[n_wall + 1];
+    int n_sm_dat = wall_start[n_wall + 2] - first;
+    if (!get_bit(pop->side_removed, n_wall) && n_sm_dat > 0) {
+      if (init_surf_mols_by_density(world, objp->wall_p[n_wall],
+                                    sm_prop + first, n_sm_dat))
+        return 1;
     }
   }
 
@@ -2660,18 +3059,8 @@ int init_wall_surf_mols(struct volume *world, struct object *objp) {
     }
   }
 
-  /* free sm_prop array and contents */
-  for (int n_wall = 0; n_wall < n_walls; n_wall++) {
-    if (sm_prop[n_wall] != NULL) {
-      smdp = sm_prop[n_wall];
-      while (smdp != NULL) {
-        dup_smdp = smdp;
-        smdp = smdp->next;
-        free(dup_smdp);
-      }
-    }
-  }
   free(sm_prop);
+  free(wall_start);
 
   return 0;
 }
@@ -2686,11 +3075,12 @@ int init_wall_surf_mols(struct volume *world, struct object *objp) {
     probability.
 
     In:  struct wall *w - wall upon which to place
-         struct sm_dat *smdp - description of what to release
+         struct sm_dat **sm_dat - descriptions of what to release
+         int num_sm_dat - number of descriptions
     Out: 0 on success, 1 on failure
  *******************************************************************/
 int init_surf_mols_by_density(struct volume *world, struct wall *w,
-                              struct sm_dat *smdp_head) {
+                              struct sm_dat **sm_dat, int num_sm_dat) {
 
   no_printf("Initializing surface molecules by density...\n");
 
@@ -2698,23 +3088,6 @@ int init_surf_mols_by_density(struct volume *world, struct wall *w,
     mcell_allocfailed("Failed to create grid for wall.");
   struct object *objp = w->parent_object;
 
-  int num_sm_dat = 0;
-  for (struct sm_dat *smdp = smdp_head; smdp != NULL; smdp = smdp->next)
-    ++num_sm_dat;
-
-  struct species **sm =
-      CHECKED_MALLOC_ARRAY(struct species *, num_sm_dat,
-                           "surface-molecule-by-density placement array");
-  memset(sm, 0, num_sm_dat * sizeof(struct species *));
-
-  double *prob = CHECKED_MALLOC_ARRAY(
-      double, num_sm_dat, "surface-molecule-by-density placement array");
-  memset(prob, 0, num_sm_dat * sizeof(double));
-
-  short *orientation = CHECKED_MALLOC_ARRAY(
-      short, num_sm_dat, "surface-molecule-by-density placement array");
-  memset(orientation, 0, num_sm_dat * sizeof(short));
-
   struct surface_grid *sg = w->grid;
   unsigned int n_tiles = sg->n_tiles;
   double area = w->area;
@@ -2724,22 +3097,16 @@ int init_surf_mols_by_density(struct volume *world, struct wall *w,
   no_printf("  Grid_size = %d\n", sg->n);
   no_printf("  Number of surface molecule types in wall = %d\n", num_sm_dat);
 
-  unsigned int n_sm_entry = 0;
+  /* The cumulative probabilities are summed in the same order on every
+   * tile, so they need not be stored */
   double tot_prob = 0;
   double tot_density = 0;
-  for (struct sm_dat *smdp = smdp_head; smdp != NULL; smdp = smdp->next) {
+  for (int n_sm = 0; n_sm < num_sm_dat; ++n_sm) {
     no_printf("  Adding surface molecule %s to wall at density %.9g\n",
-              smdp->sm->sym->name, smdp->quantity);
-    tot_prob += (area * smdp->quantity) / (n_tiles * world->grid_density);
-    prob[n_sm_entry] = tot_prob;
-    if (smdp->orientation > 0)
-      orientation[n_sm_entry] = 1;
-    else if (smdp->orientation < 0)
-      orientation[n_sm_entry] = -1;
-    else
-      orientation[n_sm_entry] = 0;
-    sm[n_sm_entry++] = smdp->sm;
-    tot_density += smdp->quantity;
+              sm_dat[n_sm]->sm->sym->name, sm_dat[n_sm]->quantity);
+    tot_prob +=
+        (area * sm_dat[n_sm]->quantity) / (n_tiles * world->grid_density);
+    tot_density += sm_dat[n_sm]->quantity;
   }
 
   if (tot_density > world->grid_density)
@@ -2753,10 +3120,16 @@ int init_surf_mols_by_density(struct volume *world, struct wall *w,
       if (sg->sm_list[n_tile] && sg->sm_list[n_tile]->sm)
         continue;
 
-      int p_index = -1;
       double rnd = rng_dbl(world->rng);
+      if (rnd > tot_prob)
+        continue;
+
+      int p_index = -1;
+      double prob = 0;
       for (int n_sm = 0; n_sm < num_sm_dat; ++n_sm) {
-        if (rnd <= prob[n_sm]) {
+        prob +=
+            (area * sm_dat[n_sm]->quantity) / (n_tiles * world->grid_density);
+        if (rnd <= prob) {
           p_index = n_sm;
           break;
         }
@@ -2765,16 +3138,23 @@ int init_surf_mols_by_density(struct volume *world, struct wall *w,
       if (p_index == -1)
         continue;
 
+      struct species *sm = sm_dat[p_index]->sm;
+      short orientation = 0;
+      if (sm_dat[p_index]->orientation > 0)
+        orientation = 1;
+      else if (sm_dat[p_index]->orientation < 0)
+        orientation = -1;
+
       struct periodic_image periodic_box = {.x = 0, .y = 0, .z = 0};
       struct vector3 pos3d = {.x = 0, .y = 0, .z = 0};
       short flags = TYPE_SURF | ACT_NEWBIE | IN_SCHEDULE | IN_SURFACE;
       struct surface_molecule *new_sm = place_single_molecule(
-          world, w, n_tile, sm[p_index], 0, flags, orientation[p_index], 0, 0, 0,
+          world, w, n_tile, sm, 0, flags, orientation, 0, 0, 0,
           &periodic_box, &pos3d);
       if (trigger_unimolecular(world->reaction_hash, world->rx_hashsize,
-                               sm[p_index]->hashval,
+                               sm->hashval,
                                (struct abstract_molecule *)new_sm) != NULL ||
-          (sm[p_index]->flags & CAN_SURFWALL) != 0) {
+          (sm->flags & CAN_SURFWALL) != 0) {
         new_sm->flags |= ACT_REACT;
       }
     }
@@ -2787,13 +3167,9 @@ int init_surf_mols_by_density(struct volume *world, struct wall *w,
 #ifdef DEBUG
   for (int n_sm = 0; n_sm < num_sm_dat; ++n_sm)
     no_printf("Total number of surface molecules %s = %d\n",
-              sm[n_sm]->sym->name, sm[n_sm]->population);
+              sm_dat[n_sm]->sm->sym->name, sm_dat[n_sm]->sm->population);
 #endif
 
-  free(sm);
-  free(prob);
-  free(orientation);
-
   no_printf("Done initializing %u surface molecules by density\n", n_occupied);
 
   return 0;
@@ -3771,6 +4147,96 @@ int schedule_dynamic_geometry(struct mdlparse_vars *parse_state) {
   return 0;
 }
 
+/***************************************************************************
+rate_changes_on_boundaries:
+  In: rx: a reaction with time-varying rates
+  Out: 1 if every change of rx falls on an iteration boundary (within
+       round-off), 0 if any falls inside an iteration.
+***************************************************************************/
+static int rate_changes_on_boundaries(struct rxn *rx) {
+  for (struct t_func *tv = rx->prob_t; tv != NULL; tv = tv->next) {
+    if (rate_change_iteration(tv->time) - tv->time >
+        EPS_C * (1.0 + fabs(tv->time)))
+      return 0;
+  }
+  return 1;
+}
+
+/***************************************************************************
+init_rate_changes:
+  In: world: simulation state, with reactions initialized
+  Out: 0 on success, 1 on failure. Every reaction whose rate changes all
+       fall on iteration boundaries gets an event in the rate change
+       scheduler for its first pending change. The changes of the other
+       reactions are applied by the reaction tests at each molecule's own
+       time (see update_probs), so none takes effect late or is lost.
+***************************************************************************/
+int init_rate_changes(struct volume *world) {
+  for (int i = 0; i < world->rx_hashsize; i++) {
+    for (struct rxn *rx = world->reaction_hash[i]; rx != NULL; rx = rx->next) {
+      if (rx->prob_t == NULL || !rate_changes_on_boundaries(rx))
+        continue;
+
+      struct rate_change_event *rce =
+          CHECKED_MALLOC_STRUCT_NODIE(struct rate_change_event,
+                                      "rate change event");
+      if (rce == NULL)
+        return 1;
+      rce->t = rate_change_iteration(rx->prob_t->time);
+      rce->rx = rx;
+      if (schedule_add(world->rate_change_scheduler, rce)) {
+        mcell_allocfailed_nodie("Failed to schedule rate change.");
+        return 1;
+      }
+      rx->rate_changes_scheduled = 1;
+    }
+  }
+  return 0;
+}
+
+/***************************************************************************
+init_passive_tracers:
+  In: world: simulation state, with reactions and viz output initialized
+  Out: 0 on success. With -lazy_tracers, diffusing volume species which
+       take part in no reaction, are not counted and are not visualized
+       are flagged PASSIVE_TRACER. Their molecules are only moved when
+       something needs their positions (see flush_parked_molecules).
+***************************************************************************/
+int init_passive_tracers(struct volume *world) {
+  if (!world->lazy_tracers_flag)
+    return 0;
+
+  for (int i = 0; i < world->n_species; i++) {
+    struct species *spec = world->species_list[i];
+    if (spec == world->all_mols || spec == world->all_volume_mols ||
+        spec == world->all_surface_mols)
+      continue;
+    if ((spec->flags & NOT_FREE) != 0 || spec->space_step <= 0)
+      continue;
+    if (spec->flags & (CAN_VOLVOLVOL | CAN_VOLVOL | CAN_VOLSURF | CAN_VOLWALL |
+                       CAN_VOLVOLSURF | CAN_VOLSURFSURF | COUNT_SOME_MASK |
+                       EXTERNAL_SPECIES | WELL_MIXED))
+      continue;
+
+    int passive = 1;
+    for (struct rxn *rx =
+             world->reaction_hash[spec->hashval & (world->rx_hashsize - 1)];
+         rx != NULL; rx = rx->next) {
+      if (rx->n_reactants == 1 && rx->players[0] == spec)
+        passive = 0;
+    }
+    for (struct viz_output_block *vizblk = world->viz_blocks; vizblk != NULL;
+         vizblk = vizblk->next) {
+      if (vizblk->species_viz_states != NULL &&
+          vizblk->species_viz_states[spec->species_id] != EXCLUDE_OBJ)
+        passive = 0;
+    }
+    if (passive)
+      spec->flags |= PASSIVE_TRACER;
+  }
+  return 0;
+}
+
 /***************************************************************************
 init_releases:
   In: nothing
@@ -6665,6 +7131,79 @@ void remove_molecules_name_list(struct name_list **nlist) {
   *nlist = NULL;
 }
 
+/*****************************************************************
+compare_wall_aux:
+  In: two pointers to wall_aux
+  Out: Sort order for qsort, by increasing d_prod.
+******************************************************************/
+static int compare_wall_aux(void const *a, void const *b) {
+  double d1 = ((struct wall_aux const *)a)->d_prod;
+  double d2 = ((struct wall_aux const *)b)->d_prod;
+  return (d1 < d2) ? -1 : ((d1 > d2) ? 1 : 0);
+}
+
+/*****************************************************************
+compare_wall_membership:
+  In: two pointers to wall_membership
+  Out: Sort order for qsort, by address of the wall and then by
+       subvolume index, so that the subvolumes of each wall end up
+       next to each other in increasing order.
+******************************************************************/
+static int compare_wall_membership(void const *a, void const *b) {
+  struct wall_membership const *m1 = (struct wall_membership const *)a;
+  struct wall_membership const *m2 = (struct wall_membership const *)b;
+  if (m1->this_wall != m2->this_wall)
+    return ((uintptr_t)m1->this_wall < (uintptr_t)m2->this_wall) ? -1 : 1;
+  return m1->subvol - m2->subvol;
+}
+
+/*****************************************************************
+first_wall_membership:
+  In: members: wall memberships sorted by compare_wall_membership
+      n_members: number of memberships
+      w: a wall listed in at least one subvolume
+  Out: Index of the first membership of the wall, that is, of the
+       lowest-index subvolume it is listed in.
+******************************************************************/
+static int first_wall_membership(struct wall_membership *members,
+                                 int n_members, struct wall *w) {
+  int lo = 0;
+  int hi = n_members;
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if ((uintptr_t)members[mid].this_wall < (uintptr_t)w)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+/*****************************************************************
+is_canonical_subvol:
+  In: members: wall memberships sorted by compare_wall_membership
+      n_members: number of memberships
+      w1, w2: two walls which are both listed in subvolume sv_index
+      sv_index: index of a subvolume
+  Out: 1 if sv_index is the lowest-index subvolume listing both walls,
+       0 if they already met in an earlier subvolume.
+******************************************************************/
+static int is_canonical_subvol(struct wall_membership *members,
+                               int n_members, struct wall *w1,
+                               struct wall *w2, int sv_index) {
+  int i = first_wall_membership(members, n_members, w1);
+  int j = first_wall_membership(members, n_members, w2);
+  while (members[i].subvol < sv_index && members[j].subvol < sv_index) {
+    if (members[i].subvol == members[j].subvol)
+      return 0;
+    if (members[i].subvol < members[j].subvol)
+      i++;
+    else
+      j++;
+  }
+  return 1;
+}
+
 /*****************************************************************
 check_for_overlapped_walls:
   In: rng: random number generator
@@ -6673,6 +7212,11 @@ check_for_overlapped_walls:
   Out: 0 if no errors, the world geometry is successfully checked for
        overlapped walls.
        1 if there are any overlapped walls.
+  Note: The walls of each subvolume are sorted by the projection of their
+        normal onto a random vector, so only walls with (nearly) parallel
+        normals are paired up.  Walls that span several subvolumes meet
+        in each of them; a pair is only tested in the lowest-index
+        subvolume listing both walls.
 ******************************************************************/
 int check_for_overlapped_walls(
     struct rng_state *rng, int n_subvols, struct subvolume *subvol) {
@@ -6683,34 +7227,67 @@ int check_for_overlapped_walls(
   rand_vector.y = rng_dbl(rng);
   rand_vector.z = rng_dbl(rng);
 
+  int max_walls = 0;
+  int n_members = 0;
+  for (int i = 0; i < n_subvols; i++) {
+    int n_walls = 0;
+    for (struct wall_list *wlp = subvol[i].wall_head; wlp != NULL;
+         wlp = wlp->next)
+      n_walls++;
+    if (n_walls > max_walls)
+      max_walls = n_walls;
+    n_members += n_walls;
+  }
+  if (max_walls < 2)
+    return 0;
+
+  /* Subvolumes of every wall, in increasing order per wall */
+  struct wall_membership *members = CHECKED_MALLOC_ARRAY(
+      struct wall_membership, n_members, "wall memberships");
+  n_members = 0;
+  for (int i = 0; i < n_subvols; i++) {
+    for (struct wall_list *wlp = subvol[i].wall_head; wlp != NULL;
+         wlp = wlp->next) {
+      members[n_members].this_wall = wlp->this_wall;
+      members[n_members].subvol = i;
+      n_members++;
+    }
+  }
+  qsort(members, n_members, sizeof(struct wall_membership),
+        compare_wall_membership);
+
+  struct wall_aux *walls =
+      CHECKED_MALLOC_ARRAY(struct wall_aux, max_walls, "wall_aux");
+
   for (int i = 0; i < n_subvols; i++) {
     struct subvolume *sv = &(subvol[i]);
-    struct wall_aux_list *head = NULL;
+    int n_walls = 0;
 
     for (struct wall_list *wlp = sv->wall_head; wlp != NULL; wlp = wlp->next) {
       double d_prod = dot_prod(&rand_vector, &(wlp->this_wall->normal));
       /* we want to place walls with opposite normals into
-         neighboring positions in the sorted linked list */
+         neighboring positions in the sorted array */
       if (d_prod < 0)
         d_prod = -d_prod;
 
-      struct wall_aux_list *newNode;
-      newNode = CHECKED_MALLOC_STRUCT(struct wall_aux_list, "wall_aux_list");
-      newNode->this_wall = wlp->this_wall;
-      newNode->d_prod = d_prod;
-
-      sorted_insert_wall_aux_list(&head, newNode);
+      walls[n_walls].this_wall = wlp->this_wall;
+      walls[n_walls].d_prod = d_prod;
+      n_walls++;
     }
+    if (n_walls < 2)
+      continue;
 
-    for (struct wall_aux_list *curr = head; curr != NULL; curr = curr->next) {
-      struct wall *w1 = curr->this_wall;
+    qsort(walls, n_walls, sizeof(struct wall_aux), compare_wall_aux);
 
-      struct wall_aux_list *next_curr = curr->next;
-      while ((next_curr != NULL) &&
-             (!distinguishable(curr->d_prod, next_curr->d_prod, EPS_C))) {
-        /* there may be several walls with the same (or mirror)
-           oriented normals */
-        struct wall *w2 = next_curr->this_wall;
+    for (int j = 0; j < n_walls; j++) {
+      /* there may be several walls with the same (or mirror)
+         oriented normals */
+      for (int k = j + 1; k < n_walls && !distinguishable(
+               walls[j].d_prod, walls[k].d_prod, EPS_C); k++) {
+        struct wall *w1 = walls[j].this_wall;
+        struct wall *w2 = walls[k].this_wall;
+        if (!is_canonical_subvol(members, n_members, w1, w2, i))
+          continue;
 
         if (are_walls_coplanar(w1, w2, MESH_DISTINCTIVE)) {
           if ((are_walls_coincident(w1, w2, MESH_DISTINCTIVE) ||
@@ -6722,13 +7299,11 @@ int check_for_overlapped_walls(
                 w2->parent_object->sym->name);
           }
         }
-        next_curr = next_curr->next;
       }
     }
-    /* free memory */
-    if (head != NULL)
-      delete_wall_aux_list(head);
   }
+  free(walls);
+  free(members);
 
   return 0;
 }
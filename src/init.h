@@ -67,7 +67,7 @@ int instance_obj_surf_mols(struct volume *world, struct object *objp);
 int init_wall_surf_mols(struct volume *world, struct object *objp);
 
 int init_surf_mols_by_density(struct volume *world, struct wall *w,
-                              struct sm_dat *sm_dat_head);
+                              struct sm_dat **sm_dat, int num_sm_dat);
 
 int init_surf_mols_by_number(struct volume *world, struct object *objp,
                              struct region_list *rlp);
@@ -79,6 +79,12 @@ void cube_face(struct vector3 *corner, struct vector3 **face, int i);
 
 void cube_faces(struct vector3 *corner, struct vector3 *(*face)[4]);
 
+int init_rate_changes(struct volume *world);
+
+int init_passive_tracers(struct volume *world);
+
+int init_auto_time_steps(struct volume *world);
+
 int init_releases(struct schedule_helper *releaser);
 
 int init_dynamic_geometry(struct volume *state);
@@ -31,6 +31,7 @@
 #include "count_util.h"
 #include "logging.h"
 #include "dyngeom.h"
+#include "diffuse.h"
 
 /* simple wrapper for executing the supplied function call. In case
  * of an error returns with MCELL_FAIL and prints out error_message */
@@ -56,6 +57,7 @@ int mcell_add_dynamic_geometry_file(char *dynamic_geometry_filepath,
 }
 
 int mcell_change_geometry(struct volume *state, struct poly_object_list *pobj_list) {
+  flush_parked_molecules(state, NULL, 0);
   state->all_molecules = save_all_molecules(state, state->storage_head);
 
   // Turn off progress reports to avoid spamming mostly useless info to stdout
@@ -48,6 +48,8 @@
 #include "mcell_misc.h"
 #include "mcell_reactions.h"
 #include "dyngeom.h"
+#include "startup_image.h"
+#include "well_mixed.h"
 #include "chkpt.h"
 
 //for nfsim initialization 
@@ -118,6 +120,7 @@ MCELL_STATE *mcell_create() {
       ULONG_MAX; /* Indicates that this value has not been set by user */
   state->seed_seq = 1;
   state->with_checks_flag = 1;
+  state->mesh_cache_max_bytes = DG_MESH_CACHE_DEFAULT_MB * 1024LL * 1024LL;
   state->nfsim_flag = 0; //JJT: NFsim flag
 
   time_t begin_time_of_day;
@@ -174,6 +177,9 @@ MCELL_STATUS
 mcell_init_simulation(MCELL_STATE *state) {
   CHECKED_CALL(init_reactions(state), "Error initializing reactions.");
 
+  CHECKED_CALL(init_rate_changes(state),
+               "Error while scheduling time-varying reaction rates.");
+
   CHECKED_CALL(init_species(state), "Error initializing species.");
 
   if (has_micro_rev_and_trimol_rxns(state->species_list, state->n_species,
@@ -186,21 +192,42 @@ mcell_init_simulation(MCELL_STATE *state) {
     mcell_log("Creating geometry (this may take some time)");
 
   CHECKED_CALL(init_bounding_box(state), "Error initializing bounding box.");
+  // Automatic time steps change the speed limit the partitions are sized by
+  CHECKED_CALL(init_auto_time_steps(state),
+               "Error while choosing automatic time steps.");
   CHECKED_CALL(init_partitions(state), "Error initializing partitions.");
   CHECKED_CALL(init_vertices_walls(state),
                "Error initializing vertices and walls.");
   CHECKED_CALL(init_regions(state), "Error initializing regions.");
 
-  if (state->place_waypoints_flag) {
+  // A startup image made for the same geometry replaces waypoint placement
+  // and the check for overlapped walls. Nothing else is cached in the image;
+  // the rest of the world is always initialized from the model.
+  int image_loaded = 0;
+  if (state->startup_image_file != NULL) {
+    CHECKED_CALL(read_startup_image(state, state->startup_image_file,
+                                    &image_loaded),
+                 "Error while reading startup image.");
+  }
+
+  if (state->place_waypoints_flag && !image_loaded) {
     CHECKED_CALL(place_waypoints(state), "Error while placing waypoints.");
   }
 
-  if (state->with_checks_flag) {
+  if (state->with_checks_flag && !image_loaded) {
     CHECKED_CALL(check_for_overlapped_walls(
         state->rng, state->n_subvols, state->subvol),
         "Error while checking for overlapped walls.");
   }
 
+  if (state->startup_image_file != NULL && !image_loaded) {
+    CHECKED_CALL(write_startup_image(state, state->startup_image_file),
+                 "Error while writing startup image.");
+  }
+
+  CHECKED_CALL(init_well_mixed(state),
+               "Error while setting up well-mixed species.");
+
   CHECKED_CALL(init_surf_mols(state),
                "Error while placing surface molecules on regions.");
 
@@ -298,6 +325,8 @@ mcell_redo_geom(MCELL_STATE *state) {
   }
   CHECKED_CALL(init_species_mesh_transp(state),
                "Error while initializing species-mesh transparency list.");
+  CHECKED_CALL(init_well_mixed(state),
+               "Error while setting up well-mixed species.");
 
   return MCELL_SUCCESS;
 }
@@ -382,6 +411,8 @@ mcell_init_output(MCELL_STATE *state) {
   CHECKED_CALL(init_viz_data(state), "Error while initializing viz data.");
   CHECKED_CALL(init_reaction_data(state),
                "Error while initializing reaction data.");
+  CHECKED_CALL(init_passive_tracers(state),
+               "Error while selecting passive tracer species.");
   CHECKED_CALL(init_timers(state), "Error initializing the simulation timers.");
 
   // signal successful end of simulation
@@ -23,6 +23,8 @@
 
 #include <assert.h>
 #include <math.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
@@ -39,6 +41,8 @@
 
 /* static helper functions */
 static int is_region_degenerate(struct region *reg_ptr);
+static int create_all_region(MCELL_STATE *state, struct object *obj_ptr,
+                             struct polygon_object *poly_obj_ptr);
 
 /*************************************************************************
  mcell_create_instance_object:
@@ -221,6 +225,107 @@ mcell_create_poly_object(MCELL_STATE *state, struct object *parent,
   return MCELL_SUCCESS;
 }
 
+/*************************************************************************
+ mcell_create_poly_object_from_binary:
+  Create a new polygon object from a binary mesh file.
+
+ In: state:    the simulation state
+     parent:   the object the new mesh becomes a child of
+     obj_name: name of the new mesh (without the parent's name)
+     filename: binary mesh file (see struct binary_mesh)
+     new_obj:  the created object is stored here
+ Out: 0 on success; any other integer value is a failure.
+      A mesh with the regions stored in the file is created.
+*************************************************************************/
+MCELL_STATUS
+mcell_create_poly_object_from_binary(MCELL_STATE *state, struct object *parent,
+                                     const char *obj_name,
+                                     const char *filename,
+                                     struct object **new_obj) {
+  struct binary_mesh mesh;
+  if (read_binary_mesh(filename, &mesh)) {
+    return MCELL_FAIL;
+  }
+
+  // create qualified object name
+  char *qualified_name =
+      CHECKED_SPRINTF("%s.%s", parent->sym->name, obj_name);
+
+  // Create the symbol, if it doesn't exist yet.
+  int error_code = 0;
+  struct object *obj_ptr = make_new_object(
+      state->dg_parse,
+      state->obj_sym_table,
+      qualified_name,
+      &error_code);
+  if (obj_ptr == NULL) {
+    free(qualified_name);
+    free_binary_mesh(&mesh);
+    return MCELL_FAIL;
+  }
+  obj_ptr->last_name = qualified_name;
+
+  // The polygon object takes over the vertex and element arrays
+  if (new_polygon_list_from_arrays(state, obj_ptr, mesh.n_verts,
+                                   mesh.vertices, mesh.n_walls,
+                                   mesh.elements) == NULL) {
+    mesh.vertices = NULL;
+    mesh.elements = NULL;
+    free_binary_mesh(&mesh);
+    return MCELL_FAIL;
+  }
+  mesh.vertices = NULL;
+  mesh.elements = NULL;
+
+  if (add_binary_mesh_regions(state, obj_ptr, &mesh)) {
+    free_binary_mesh(&mesh);
+    return MCELL_FAIL;
+  }
+  free_binary_mesh(&mesh);
+
+  // Do some clean-up.
+  remove_gaps_from_regions(obj_ptr);
+  if (check_degenerate_polygon_list(obj_ptr)) {
+    return MCELL_FAIL;
+  }
+
+  obj_ptr->parent = parent;
+  add_child_objects(parent, obj_ptr, obj_ptr);
+
+  *new_obj = obj_ptr;
+
+  return MCELL_SUCCESS;
+}
+
+/**************************************************************************
+ create_all_region:
+    Create the default region "ALL" of a polygon list object, which holds
+    every wall of the object.
+
+ In: state: the simulation state
+     obj_ptr: the polygon list object
+     poly_obj_ptr: its polygon object, with n_walls set
+ Out: 0 on success, 1 on failure
+**************************************************************************/
+static int create_all_region(MCELL_STATE *state, struct object *obj_ptr,
+                             struct polygon_object *poly_obj_ptr) {
+  struct region *reg_ptr = mcell_create_region(state, obj_ptr, "ALL");
+  if (reg_ptr == NULL) {
+    return 1;
+  }
+  if ((reg_ptr->element_list_head =
+           new_element_list(0, poly_obj_ptr->n_walls - 1)) == NULL) {
+    return 1;
+  }
+
+  obj_ptr->n_walls = poly_obj_ptr->n_walls;
+  obj_ptr->n_verts = poly_obj_ptr->n_verts;
+  if (normalize_elements(reg_ptr, 0)) {
+    return 1;
+  }
+  return 0;
+}
+
 /**************************************************************************
  new_polygon_list:
     Create a new polygon list object.
@@ -241,7 +346,6 @@ new_polygon_list(MCELL_STATE *state, struct object *obj_ptr, int n_vertices,
 
   struct vertex_list *vert_list = NULL;
   struct element_data *elem_data_ptr = NULL;
-  struct region *reg_ptr = NULL;
 
   struct polygon_object *poly_obj_ptr =
       allocate_polygon_object("polygon list object");
@@ -300,17 +404,7 @@ new_polygon_list(MCELL_STATE *state, struct object *obj_ptr, int n_vertices,
   }
 
   // Create object default region on polygon list object:
-  if ((reg_ptr = mcell_create_region(state, obj_ptr, "ALL")) == NULL) {
-    goto failure;
-  }
-  if ((reg_ptr->element_list_head =
-           new_element_list(0, poly_obj_ptr->n_walls - 1)) == NULL) {
-    goto failure;
-  }
-
-  obj_ptr->n_walls = poly_obj_ptr->n_walls;
-  obj_ptr->n_verts = poly_obj_ptr->n_verts;
-  if (normalize_elements(reg_ptr, 0)) {
+  if (create_all_region(state, obj_ptr, poly_obj_ptr)) {
     // mdlerror_fmt(parse_state,
     //             "Error setting up elements in default 'ALL' region in the "
     //             "polygon object '%s'.", sym->name);
@@ -334,6 +428,247 @@ failure:
   return NULL;
 }
 
+/**************************************************************************
+ new_polygon_list_from_arrays:
+    Create a new polygon list object from flat arrays of vertices and
+    triangles, such as those read from a binary mesh file.
+
+ In: state: the simulation state
+     obj_ptr: contains information about the object (name, etc)
+     n_vertices: count of vertices
+     vertices: array of vertices, owned by the polygon object afterwards
+     n_connections: count of walls
+     elements: array of walls, owned by the polygon object afterwards
+ Out: polygon object, or NULL if there was an error (in which case the
+      arrays are freed)
+**************************************************************************/
+struct polygon_object *
+new_polygon_list_from_arrays(MCELL_STATE *state, struct object *obj_ptr,
+                             int n_vertices, struct vector3 *vertices,
+                             int n_connections, struct element_data *elements) {
+
+  struct polygon_object *poly_obj_ptr =
+      allocate_polygon_object("polygon list object");
+  if (poly_obj_ptr == NULL) {
+    goto failure;
+  }
+
+  obj_ptr->object_type = POLY_OBJ;
+  obj_ptr->contents = poly_obj_ptr;
+
+  poly_obj_ptr->n_walls = n_connections;
+  poly_obj_ptr->n_verts = n_vertices;
+
+  poly_obj_ptr->side_removed = new_bit_array(poly_obj_ptr->n_walls);
+  if (poly_obj_ptr->side_removed == NULL) {
+    goto failure;
+  }
+  set_all_bits(poly_obj_ptr->side_removed, 0);
+
+  // Rescale vertices coordinates
+  for (int i = 0; i < n_vertices; i++) {
+    vertices[i].x *= state->r_length_unit;
+    vertices[i].y *= state->r_length_unit;
+    vertices[i].z *= state->r_length_unit;
+  }
+  poly_obj_ptr->vertex_array = vertices;
+  poly_obj_ptr->element = elements;
+
+  if (create_all_region(state, obj_ptr, poly_obj_ptr)) {
+    goto failure;
+  }
+
+  return poly_obj_ptr;
+
+failure:
+  free(vertices);
+  free(elements);
+  if (poly_obj_ptr) {
+    if (poly_obj_ptr->side_removed) {
+      free_bit_array(poly_obj_ptr->side_removed);
+    }
+    free(poly_obj_ptr);
+  }
+  obj_ptr->contents = NULL;
+  return NULL;
+}
+
+/**************************************************************************
+ read_binary_mesh:
+    Read a binary mesh file (see struct binary_mesh for the layout).  The
+    vertices and triangles are read straight into the arrays used by
+    polygon objects, without allocating anything per element.
+
+ In: filename: the binary mesh file
+     mesh: the mesh read is stored here
+ Out: 0 on success, 1 on failure (the error is reported)
+**************************************************************************/
+int read_binary_mesh(const char *filename, struct binary_mesh *mesh) {
+  memset(mesh, 0, sizeof(struct binary_mesh));
+
+  FILE *f = fopen(filename, "rb");
+  if (f == NULL) {
+    mcell_error_nodie("Cannot open binary mesh file '%s'.", filename);
+    return 1;
+  }
+
+  char magic[8];
+  uint32_t version, byte_order;
+  int32_t counts[3];
+  if (fread(magic, sizeof(magic), 1, f) != 1 ||
+      memcmp(magic, "MCELLMSH", sizeof(magic)) != 0 ||
+      fread(&version, sizeof(version), 1, f) != 1 ||
+      fread(&byte_order, sizeof(byte_order), 1, f) != 1 ||
+      fread(counts, sizeof(int32_t), 3, f) != 3) {
+    mcell_error_nodie("'%s' is not a binary mesh file.", filename);
+    goto failure;
+  }
+  if (version != BINARY_MESH_VERSION ||
+      byte_order != BINARY_MESH_BYTE_ORDER) {
+    mcell_error_nodie("Binary mesh file '%s' has an unsupported version or "
+                      "byte order.", filename);
+    goto failure;
+  }
+  if (counts[0] <= 0 || counts[1] <= 0 || counts[2] < 0) {
+    mcell_error_nodie("Binary mesh file '%s' is empty or corrupt.", filename);
+    goto failure;
+  }
+  mesh->n_verts = counts[0];
+  mesh->n_walls = counts[1];
+
+  // struct vector3 is three packed doubles, so the file can be read directly
+  mesh->vertices = CHECKED_MALLOC_ARRAY_NODIE(struct vector3, mesh->n_verts,
+                                              "binary mesh vertices");
+  mesh->elements = CHECKED_MALLOC_ARRAY_NODIE(struct element_data,
+                                              mesh->n_walls,
+                                              "binary mesh walls");
+  if (mesh->vertices == NULL || mesh->elements == NULL)
+    goto failure;
+  if (fread(mesh->vertices, sizeof(struct vector3), mesh->n_verts, f) !=
+          (size_t)mesh->n_verts ||
+      fread(mesh->elements, sizeof(struct element_data), mesh->n_walls, f) !=
+          (size_t)mesh->n_walls) {
+    mcell_error_nodie("Binary mesh file '%s' is truncated.", filename);
+    goto failure;
+  }
+
+  for (int i = 0; i < mesh->n_walls; i++) {
+    for (int k = 0; k < 3; k++) {
+      int idx = mesh->elements[i].vertex_index[k];
+      if (idx < 0 || idx >= mesh->n_verts) {
+        mcell_error_nodie("Binary mesh file '%s': triangle %d refers to "
+                          "vertex %d, which does not exist.",
+                          filename, i, idx);
+        goto failure;
+      }
+    }
+  }
+
+  mesh->region_names = CHECKED_MALLOC_ARRAY_NODIE(
+      char *, counts[2] + 1, "binary mesh region names");
+  mesh->region_elements = CHECKED_MALLOC_ARRAY_NODIE(
+      struct element_list *, counts[2] + 1, "binary mesh region elements");
+  if (mesh->region_names == NULL || mesh->region_elements == NULL)
+    goto failure;
+
+  for (int r = 0; r < counts[2]; r++) {
+    int32_t name_len, n_ranges;
+    if (fread(&name_len, sizeof(name_len), 1, f) != 1 || name_len <= 0)
+      goto truncated;
+    char *name = CHECKED_MALLOC_ARRAY_NODIE(char, name_len + 1,
+                                            "binary mesh region name");
+    if (name == NULL)
+      goto failure;
+    if (fread(name, 1, name_len, f) != (size_t)name_len) {
+      free(name);
+      goto truncated;
+    }
+    name[name_len] = '\0';
+    mesh->region_names[r] = name;
+    mesh->region_elements[r] = NULL;
+    mesh->n_regions++;
+
+    if (fread(&n_ranges, sizeof(n_ranges), 1, f) != 1 || n_ranges < 0)
+      goto truncated;
+    struct element_list **tail = &mesh->region_elements[r];
+    for (int i = 0; i < n_ranges; i++) {
+      int32_t range[2];
+      if (fread(range, sizeof(int32_t), 2, f) != 2)
+        goto truncated;
+      if (range[0] < 0 || range[1] < range[0] || range[1] >= mesh->n_walls) {
+        mcell_error_nodie("Binary mesh file '%s': region '%s' has an invalid "
+                          "element range.", filename, name);
+        goto failure;
+      }
+      struct element_list *elem = new_element_list(range[0], range[1]);
+      if (elem == NULL)
+        goto failure;
+      *tail = elem;
+      tail = &elem->next;
+    }
+  }
+
+  fclose(f);
+  return 0;
+
+truncated:
+  mcell_error_nodie("Binary mesh file '%s' is truncated.", filename);
+failure:
+  fclose(f);
+  free_binary_mesh(mesh);
+  return 1;
+}
+
+/**************************************************************************
+ add_binary_mesh_regions:
+    Create the regions stored in a binary mesh file on its polygon object.
+
+ In: state: the simulation state
+     obj_ptr: the polygon list object created from the mesh
+     mesh: the binary mesh; the element lists of its regions are handed
+           over to the new regions
+ Out: 0 on success, 1 on failure
+**************************************************************************/
+int add_binary_mesh_regions(MCELL_STATE *state, struct object *obj_ptr,
+                            struct binary_mesh *mesh) {
+  for (int r = 0; r < mesh->n_regions; r++) {
+    struct region *reg_ptr =
+        mcell_create_region(state, obj_ptr, mesh->region_names[r]);
+    if (reg_ptr == NULL) {
+      return 1;
+    }
+    if (mcell_set_region_elements(reg_ptr, mesh->region_elements[r], 1)) {
+      return 1;
+    }
+    mesh->region_elements[r] = NULL;
+  }
+  return 0;
+}
+
+/**************************************************************************
+ free_binary_mesh:
+    Free whatever is still held by a binary mesh.
+
+ In: mesh: the binary mesh
+ Out: the mesh is emptied
+**************************************************************************/
+void free_binary_mesh(struct binary_mesh *mesh) {
+  free(mesh->vertices);
+  free(mesh->elements);
+  for (int r = 0; r < mesh->n_regions; r++) {
+    free(mesh->region_names[r]);
+    struct element_list *elem = mesh->region_elements[r];
+    while (elem != NULL) {
+      struct element_list *next = elem->next;
+      free(elem);
+      elem = next;
+    }
+  }
+  free(mesh->region_names);
+  free(mesh->region_elements);
+  memset(mesh, 0, sizeof(struct binary_mesh));
+}
+
 /*************************************************************************
  make_new_object:
     Create a new object, adding it to the global symbol table.
@@ -604,6 +939,7 @@ struct polygon_object *allocate_polygon_object(char const *desc) {
   }
   poly_obj_ptr->n_verts = 0;
   poly_obj_ptr->parsed_vertices = NULL;
+  poly_obj_ptr->vertex_array = NULL;
   poly_obj_ptr->n_walls = 0;
   poly_obj_ptr->element = NULL;
   poly_obj_ptr->sb = NULL;
@@ -42,6 +42,30 @@ struct poly_object {
   int num_conn;
 };
 
+/* A mesh read from a binary mesh file. The file holds, in native byte order:
+ *   char magic[8]          "MCELLMSH"
+ *   uint32 version         BINARY_MESH_VERSION
+ *   uint32 byte order      BINARY_MESH_BYTE_ORDER
+ *   int32 n_verts, n_walls, n_regions
+ *   float64 vertices[n_verts][3]
+ *   int32 triangles[n_walls][3]
+ * and for each region
+ *   int32 name_length, char name[name_length]
+ *   int32 n_ranges, int32 ranges[n_ranges][2]   (first and last wall)
+ */
+#define BINARY_MESH_VERSION 1
+#define BINARY_MESH_BYTE_ORDER 0x01020304u
+
+struct binary_mesh {
+  int n_verts;
+  struct vector3 *vertices;
+  int n_walls;
+  struct element_data *elements;
+  int n_regions;
+  char **region_names;
+  struct element_list **region_elements;
+};
+
 struct poly_object_list {
   const char *obj_name;
   struct vertex_list *vertices;
@@ -67,11 +91,29 @@ MCELL_STATUS mcell_create_poly_object(MCELL_STATE *state, struct object *parent,
                                       struct poly_object *poly_obj,
                                       struct object **new_object);
 
+MCELL_STATUS mcell_create_poly_object_from_binary(MCELL_STATE *state,
+                                                  struct object *parent,
+                                                  const char *obj_name,
+                                                  const char *filename,
+                                                  struct object **new_object);
+
 struct polygon_object *
 new_polygon_list(MCELL_STATE *state, struct object *obj_ptr, int n_vertices,
                  struct vertex_list *vertices, int n_connections,
                  struct element_connection_list *connections);
 
+struct polygon_object *
+new_polygon_list_from_arrays(MCELL_STATE *state, struct object *obj_ptr,
+                             int n_vertices, struct vector3 *vertices,
+                             int n_connections, struct element_data *elements);
+
+int read_binary_mesh(const char *filename, struct binary_mesh *mesh);
+
+int add_binary_mesh_regions(MCELL_STATE *state, struct object *obj_ptr,
+                            struct binary_mesh *mesh);
+
+void free_binary_mesh(struct binary_mesh *mesh);
+
 struct object *make_new_object(
     struct dyngeom_parse_vars *dg_parse,
     struct sym_table_head *obj_sym_table,
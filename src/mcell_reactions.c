@@ -215,7 +215,9 @@ mcell_modify_multiple_rate_constants(struct volume *world, char **names, double
     i_rxn++;
   }
 
-  // Now, reschedule all necessary reactions at once
+  // Now, reschedule all necessary reactions at once. Molecules parked
+  // outside the schedulers are put back first so the loops below see them.
+  flush_parked_molecules(world, NULL, 0);
 
   // Check: are there any reactions with diffusable reactants
   if (n_reactions_ud > 0) // There is at least one
@@ -3189,6 +3191,7 @@ static struct rxn *create_sibling_reaction(struct rxn *rx) {
   reaction->n_occurred = 0;
   reaction->n_skipped = 0.0;
   reaction->prob_t = NULL;
+  reaction->rate_changes_scheduled = 0;
   reaction->pathway_head = NULL;
   reaction->info = NULL;
   reaction->product_graph_data = NULL;
@@ -20,6 +20,7 @@
  * USA.
  *
 ******************************************************************************/
+#include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 #include <float.h>
@@ -36,6 +37,7 @@
 #include "sym_table.h"
 #include "logging.h"
 #include "vol_util.h"
+#include "react.h"
 #include "react_output.h"
 #include "viz_output.h"
 #include "volume_output.h"
@@ -48,6 +50,7 @@
 #include <nfsim_c.h>
 #include "mcell_reactions.h"
 #include "mcell_react_out.h"
+#include "well_mixed.h"
 
 // static helper functions
 static long long mcell_determine_output_frequency(MCELL_STATE *state);
@@ -55,7 +58,9 @@ static long long mcell_determine_output_frequency(MCELL_STATE *state);
 /***********************************************************************
  process_volume_output:
 
-    Produce this round's volume output, if any.
+    Produce this round's volume output, if any. Molecules parked outside
+    the schedulers are put back first, so that they are all counted;
+    passive tracers only if their species is output.
 
     In:  struct volume *wrld - the world
          double not_yet - earliest time which should not yet be output
@@ -70,11 +75,30 @@ static void process_volume_output(struct volume *wrld, double not_yet) {
            wrld->volume_output_scheduler)) {
     if (vo == NULL)
       continue;
+    flush_parked_molecules(wrld, vo->molecules, vo->num_molecules);
     if (update_volume_output(wrld, vo))
       mcell_error("Failed to update volume output.");
   }
 }
 
+/***********************************************************************
+ process_viz_output:
+
+    Produce this round's visualization output, if any. Molecules parked
+    outside the schedulers are read where they are (see
+    visit_all_molecules), so writing a frame does not change the run.
+
+    In:  struct volume *wrld - the world
+    Out: none.  viz output files are written as appropriate.
+ ***********************************************************************/
+static void process_viz_output(struct volume *wrld) {
+  for (struct viz_output_block *vizblk = wrld->viz_blocks; vizblk != NULL;
+       vizblk = vizblk->next) {
+    if (vizblk->frame_data_head && update_frame_data_list(wrld, vizblk))
+      mcell_error("Unknown error while updating frame data list.");
+  }
+}
+
 /***********************************************************************
  process_reaction_output:
 
@@ -160,6 +184,41 @@ void process_geometry_changes(struct volume *state, double not_yet) {
                          "should never happen.");
 }
 
+/***********************************************************************
+ process_rate_changes:
+
+    Apply this round's changes of time-varying reaction rates, if any.
+
+ In: state: MCell state
+     not_yet: earliest time which should not yet be processed
+ Out: Nothing. The probabilities of the affected reactions are updated and
+      each reaction is rescheduled for its next change. Molecules whose
+      unimolecular lifetimes were cut short at the change wake up now and
+      pick new lifetimes.
+ ***********************************************************************/
+static void process_rate_changes(struct volume *state, double not_yet) {
+  for (struct rate_change_event *rce = (struct rate_change_event *)schedule_next(
+       state->rate_change_scheduler);
+       rce != NULL || not_yet >= state->rate_change_scheduler->now;
+       rce = (struct rate_change_event *)schedule_next(state->rate_change_scheduler)) {
+
+    if (rce == NULL)
+      continue;
+    update_probs(state, rce->rx, rce->t);
+    if (rce->rx->prob_t == NULL) {
+      free(rce);
+      continue;
+    }
+    rce->t = rate_change_iteration(rce->rx->prob_t->time);
+    if (schedule_add(state->rate_change_scheduler, rce))
+      mcell_allocfailed("Failed to schedule rate change.");
+  }
+  if (state->rate_change_scheduler->error)
+    mcell_internal_error("Scheduler reported an out-of-memory error while "
+                         "retrieving next scheduled rate change, but this "
+                         "should never happen.");
+}
+
 /***********************************************************************
  make_checkpoint:
 
@@ -210,7 +269,8 @@ static int make_checkpoint(struct volume *wrld) {
     return 0;
   }
 
-  /* Make the checkpoint */
+  /* Make the checkpoint, with parked molecules back in the schedulers */
+  flush_parked_molecules(wrld, NULL, 0);
   create_chkpt(wrld, wrld->chkpt_outfile);
   wrld->last_checkpoint_iteration = wrld->current_iterations;
 
@@ -426,11 +486,7 @@ mcell_run_iteration(MCELL_STATE *world, long long frequency,
     /* Produce output */
     process_reaction_output(world, not_yet);
     process_volume_output(world, not_yet);
-    for (struct viz_output_block *vizblk = world->viz_blocks; vizblk != NULL;
-         vizblk = vizblk->next) {
-      if (vizblk->frame_data_head && update_frame_data_list(world, vizblk))
-        mcell_error("Unknown error while updating frame data list.");
-    }
+    process_viz_output(world);
 
     /* Produce iteration report */
     if (iter_report_phase == 0 &&
@@ -500,6 +556,18 @@ mcell_run_iteration(MCELL_STATE *world, long long frequency,
   // reset this flag to zero
   *restarted_from_checkpoint = 0;
 
+  /* Apply rate changes before any molecule of this iteration reacts */
+  process_rate_changes(world, not_yet);
+
+  for (struct storage_list *local = world->storage_head; local != NULL;
+       local = local->next) {
+    wake_queued_molecules(world, local->store, not_yet);
+    if (world->aggregate_unimol_flag)
+      run_unimol_pools(world, local->store, world->current_iterations, not_yet);
+  }
+
+  run_well_mixed(world, world->current_iterations);
+
   run_concentration_clamp(world, world->current_iterations);
 
   double next_release_time;
@@ -726,6 +794,8 @@ mcell_print_final_statistics(MCELL_STATE *world) {
               world->ray_polygon_tests);
     mcell_log("Total number of ray-polygon intersections: %lld",
               world->ray_polygon_colls);
+    if (world->tune_partitions_flag)
+      report_partition_tuning(world);
     mcell_log("Total number of dynamic geometry molecule displacements: %lld",
               world->dyngeom_molec_displacements);
     print_molecule_collision_report(
@@ -753,6 +823,8 @@ mcell_print_final_statistics(MCELL_STATE *world) {
 
     mcell_log("Initialization CPU time = %f (user) and %f (system)",
               u_init_time, s_init_time);
+    mcell_log("  of which connecting walls along edges = %f (user)",
+              world->edge_init_time);
 
     getrusage(RUSAGE_SELF, &run_time);
     u_run_time = run_time.ru_utime.tv_sec +
@@ -69,6 +69,11 @@
   JJT: EXTERN defines a species whose reaction rates calculation will be delegated
   to an external application
 */
+/* WELL_MIXED is set for volume species which are held as per-subvolume counts
+   in subvolumes without walls (see well_mixed.c) */
+/* PASSIVE_TRACER is set for volume species nothing reacts with, counts or
+   visualizes; their molecules are only moved when their positions are
+   needed */
 #define ON_GRID 0x01
 #define IS_SURFACE 0x02
 #define NOT_FREE 0x03
@@ -93,6 +98,8 @@
 #define CAN_REGION_BORDER 0x100000
 #define REGION_PRESENT 0x200000
 #define EXTERNAL_SPECIES 0x400000
+#define WELL_MIXED 0x800000
+#define PASSIVE_TRACER 0x1000000
 
 /* Abstract Molecule Flags */
 
@@ -298,6 +305,16 @@ enum manifold_flag_t {
 #define MAX_TARGET_TIMESTEP 1.0e6
 #define MIN_TARGET_TIMESTEP 10.0
 
+/* How far (as a fraction of the spacing) may coarse partitions stray from an
+ * even grid and still be looked up by direct indexing? */
+#define UNIFORM_PARTITION_SLACK 0.25
+
+/* Relative costs of a ray-subvolume and a ray-polygon intersection test, and
+ * the upper bound on coarse partitions per axis, for partition tuning */
+#define TUNE_RAY_VOXEL_COST 1.0
+#define TUNE_RAY_POLYGON_COST 2.0
+#define MAX_TUNED_PER_AXIS 64
+
 /* Flags for parser to indicate which axis we are partitioning */
 enum partition_axis_t {
   X_PARTS, /* X-axis partitions */
@@ -666,6 +683,10 @@ struct rxn {
 
   struct t_func *
   prob_t; /* List of probabilities changing over time, by pathway */
+  int rate_changes_scheduled; /* 1 if all changes in prob_t fall on iteration
+                                 boundaries and are applied by the rate
+                                 change scheduler; 0 if they are applied
+                                 whenever a molecule's own time passes them */
 
   struct pathway *pathway_head; /* List of pathways built at parse-time */
   struct pathway_info *info;    /* Counts and names for each pathway */
@@ -731,13 +752,52 @@ struct t_func {
   int path;     /* Which rxn pathway is this for? */
 };
 
+/* Pending rate change of a reaction with time-varying rates */
+struct rate_change_event {
+  struct rate_change_event *next;
+  double t;       /* Iteration at which the next change is applied */
+  struct rxn *rx; /* Reaction whose prob_t holds the pending changes */
+};
+
 // Used for dynamic geometry.
 struct molecule_info {
   struct abstract_molecule *molecule;
-  struct string_buffer *reg_names;   /* Region names */
-  struct string_buffer *mesh_names;  /* Mesh names that molec is nested in */
-  struct vector3 pos;                /* Position in space */
-  short orient;                      /* Which way do we point? */
+  int reg_names_id;   /* Region names (id in the snapshot's name lists) */
+  int mesh_names_id;  /* Mesh names that molec is nested in (same) */
+  struct vector3 pos; /* Position in space */
+  short orient;       /* Which way do we point? */
+};
+
+/* Mesh and region name lists of a wall that surface molecules were saved on */
+struct wall_name_ids {
+  int mesh_names_id; /* The wall's mesh, as a list of one name */
+  int reg_names_id;  /* The wall's regions */
+};
+
+/* Distinct lists of mesh or region names used by a molecule snapshot.  Each
+ * list is stored once, as offsets into one character arena, and molecules
+ * refer to it by its index. */
+struct name_list_table {
+  char *chars;                     /* Names of all lists, NUL-terminated */
+  size_t n_chars;                  /* Used length of chars */
+  size_t max_chars;                /* Allocated length of chars */
+  size_t *name_offsets;            /* Offset in chars of every name, by list */
+  int n_names;                     /* Used length of name_offsets */
+  int max_names;                   /* Allocated length of name_offsets */
+  int *first_name;                 /* Index in name_offsets of each list's
+                                      first name, plus one past the last */
+  unsigned long *hashes;           /* Hash of each list */
+  int *next_in_bucket;             /* Next list with the same bucket */
+  struct string_buffer **views;    /* Lists as string buffers, on demand */
+  struct string_buffer **filtered; /* Cached lists minus ignored names */
+  int n_lists;                     /* How many lists are stored */
+  int max_lists;                   /* Allocated length of the list arrays */
+  int *buckets;                    /* First list in each hash bucket */
+  int n_buckets;                   /* Number of hash buckets (power of 2) */
+  struct pointer_hash wall_index;  /* Wall -> its entry in wall_ids */
+  struct wall_name_ids *wall_ids;  /* Preallocated, one entry per wall */
+  int n_wall_ids;                  /* Used length of wall_ids */
+  int max_wall_ids;                /* Allocated length of wall_ids */
 };
 
 /* periodic_image tracks the periodic box a molecule is in in the presence
@@ -902,6 +962,13 @@ struct wall {
 
   struct region_list *counting_regions; /* Counted-on regions containing this
                                            wall */
+  /* Same set as counting_regions, indexed by region->counting_index.  Walls
+   * with identical region sets share one bit array. NULL if not counted. */
+  struct bit_array *counting_region_bits;
+  /* Regions with borders (all but ALL and ALL_ELEMENTS regions) containing
+   * this wall, indexed by region->border_index.  Shared like
+   * counting_region_bits.  NULL if the wall is in no such region. */
+  struct bit_array *border_region_bits;
 };
 
 /* Linked list of walls (for subvolumes) */
@@ -946,6 +1013,32 @@ struct surface_grid {
 
   struct subvolume *subvol; /* Best match for which subvolume we're in */
   struct wall *surface;     /* The wall that we are in */
+
+  /* Neighbor tiles of each tile, filled in on demand */
+  struct tile_neighbor_cache *nbr_cache;
+
+  /* One bit per tile, cleared only once the tile is seen to be occupied, and
+   * one bit per 64 tiles, cleared once all of those are; vacancy searches
+   * skip the tiles with clear bits */
+  unsigned long long *vacancy_bits;
+  unsigned long long *vacancy_summary;
+};
+
+/* A tile on a surface grid */
+struct tile_ref {
+  struct surface_grid *grid;
+  u_int idx;
+};
+
+/* Neighbor tiles of the tiles of one surface grid, as found by
+ * find_neighbor_tiles when searching for reactants */
+struct tile_neighbor_cache {
+  unsigned long long grid_epoch; /* world->grid_epoch when this was started */
+  int *first;            /* Offset of each tile's neighbors, -1 if not found */
+  int *count;            /* Number of neighbors of each tile */
+  struct tile_ref *nbrs; /* Neighbors of all the tiles found so far */
+  int n_nbrs;
+  int max_nbrs;
 };
 
 /* 3D vector of integers */
@@ -962,6 +1055,18 @@ struct waypoint {
   struct region_list *regions; /* We are inside these regions */
   struct region_list *
   antiregions; /* We are outside of (but hit) these regions */
+  struct bit_array *region_bits;     /* regions as bits (NULL if empty) */
+  struct bit_array *antiregion_bits; /* antiregions as bits (NULL if empty) */
+  /* Counted regions with walls in this subvolume (NULL if none); the rest
+     are classified for the whole subvolume by region_bits */
+  struct bit_array *boundary_bits;
+};
+
+/* Volume molecules whose enclosed-region counts have not been updated yet */
+struct count_batch {
+  struct volume_molecule **mols; /* Molecules waiting to be counted */
+  int n_mols;                    /* How many molecules are waiting */
+  int max_mols;                  /* Allocated length of mols */
 };
 
 /* Contains local memory and scheduler for molecules, walls, wall_lists, etc. */
@@ -987,6 +1092,34 @@ struct storage {
   struct schedule_helper *timer; /* Local scheduler */
   double current_time;           /* Local time */
   double max_timestep;           /* Local maximum timestep */
+
+  /* Aggregated non-diffusing molecules with only unimolecular reactions */
+  struct unimol_pool *unimol_pools;
+
+  /* Non-diffusing molecules whose next unimolecular event (if any) lies
+   * beyond the current iteration, keyed by the time of that event */
+  struct time_heap unimol_queue;
+};
+
+/* Molecules of one species which cannot diffuse and only react
+ * unimolecularly. They are taken out of the molecule scheduler and advanced
+ * together, one iteration at a time, with an exact stochastic simulation of
+ * the whole population. Members keep IN_SCHEDULE set while in the pool. */
+struct unimol_pool {
+  struct unimol_pool *next;
+  struct species *properties;
+  struct abstract_molecule **mols; /* Members, possibly including defunct
+                                      molecules not yet reclaimed */
+  int n_mols;
+  int max_mols;
+};
+
+/* A bimolecular reaction between two well-mixed species, indexed into
+ * world->well_mixed_species */
+struct well_mixed_pair {
+  int a;
+  int b;
+  struct rxn *rx;
 };
 
 /* Linked list of storage areas. */
@@ -1008,6 +1141,8 @@ struct subvolume {
 
   short world_edge; /* Direction Bit Flags that are set for SSVs at edge of
                        world */
+  struct subvolume *neighbor[6]; /* Adjacent subvolumes indexed by direction
+                                    (X_NEG..Z_POS), NULL at edge of world */
 
   struct storage *local_storage; /* Local memory and scheduler */
 };
@@ -1103,7 +1238,13 @@ struct volume {
   // These are only used with dynamic geometry
   struct dyngeom_parse_vars *dg_parse;
   char *dynamic_geometry_filename;
-  struct molecule_info **all_molecules;
+  /* Geometry files parsed so far and the meshes kept from them */
+  struct dg_file_cache *dg_file_cache;
+  /* Cap on the bytes of vertex and wall arrays kept in dg_file_cache */
+  long long mesh_cache_max_bytes;
+  struct molecule_info *all_molecules;
+  struct abstract_molecule *all_molecule_data; /* molecule of all_molecules */
+  struct name_list_table *all_molecule_names;
   int num_all_molecules;
   struct string_buffer *names_to_ignore;
 
@@ -1116,6 +1257,37 @@ struct volume {
   double *x_partitions; /* Coarse X partition boundaries */
   double *y_partitions; /* Coarse Y partition boundaries */
   double *z_partitions; /* Coarse Z partition boundaries */
+  /* Inverse spacing of the inner coarse partitions along each axis, or 0 if
+   * they are not evenly spaced; lets find_coarse_subvol compute indices */
+  double x_part_inv_width;
+  double y_part_inv_width;
+  double z_part_inv_width;
+  /* Choose the number of automatic partitions with a cost model? */
+  int tune_partitions_flag;
+  /* Advance non-diffusing, unimolecular-only molecules per population? */
+  int aggregate_unimol_flag;
+  /* Accuracy targets for automatic per-species time steps: the largest
+   * reaction probability per step (0 = off) and the largest space step as a
+   * fraction of the typical wall size (0 = no bound) */
+  double auto_max_rxn_prob;
+  double auto_max_step_fraction;
+  /* Move molecules of passive tracer species only when needed? */
+  int lazy_tracers_flag;
+  /* Move volume molecules in wall-free subvolumes in groups per species and
+   * subvolume? */
+  int group_diffusion_flag;
+  /* Comma-separated names of species to hold as counts in wall-free
+   * subvolumes, or NULL */
+  char *well_mixed_names;
+  int n_well_mixed;
+  struct species **well_mixed_species;
+  struct rxn **well_mixed_unimol; /* Unimolecular reactions, per species */
+  struct well_mixed_pair *well_mixed_pairs;
+  int n_well_mixed_pairs;
+  /* Molecules held per subvolume and species (n_subvols x n_well_mixed), and
+   * the molecules arriving there during the current diffusion sweep */
+  int *well_mixed_counts;
+  int *well_mixed_inflow;
   int mem_part_x; /* Granularity of memory-partition binning for the X-axis */
   int mem_part_y; /* Granularity of memory-partition binning for the Y-axis */
   int mem_part_z; /* Granularity of memory-partition binning for the Z-axis */
@@ -1131,6 +1303,21 @@ struct volume {
 
   bool periodic_traditional;
 
+  int n_counting_regions;          /* How many regions have a counting_index */
+  struct region **counting_region_index; /* Counted regions by counting_index */
+  struct void_list *region_bits_head; /* Bit arrays shared by walls/waypoints */
+  /* Scratch bit arrays for regions entered/exited along a ray */
+  struct bit_array *regions_in_scratch;
+  struct bit_array *regions_out_scratch;
+  int n_border_regions;          /* How many regions have a border_index */
+  struct region **border_region_index; /* Regions by border_index */
+  /* Scratch bit arrays for the restricted regions of two walls */
+  struct bit_array *restricted_scratch_1;
+  struct bit_array *restricted_scratch_2;
+  /* If non-NULL, new volume molecules are queued here and their enclosed
+   * counts are updated together when the batch is flushed */
+  struct count_batch *deferred_counts;
+
   int n_waypoints;            /* How many waypoints (one per subvol) */
   struct waypoint *waypoints; /* Waypoints contain fully-closed region
                                  information */
@@ -1183,6 +1370,8 @@ struct volume {
   // Scheduler for dynamic geometry
   struct schedule_helper *dynamic_geometry_scheduler;
   struct schedule_helper *releaser; /* Scheduler for release events */
+  struct schedule_helper *rate_change_scheduler; /* Scheduler for changes of
+                                                    time-varying rates */
 
   struct mem_helper *storage_allocator; /* Memory for storage list */
   struct storage_list *storage_head;    /* Linked list of all local
@@ -1274,6 +1463,7 @@ struct volume {
 
   char *chkpt_infile;              /* Name of checkpoint file to read from */
   char *chkpt_outfile;             /* Name of checkpoint file to write to */
+  char *startup_image_file;        /* Name of startup image to read or write */
   u_int chkpt_byte_order_mismatch; /* Flag that defines whether mismatch in
                                       byte order exists between the saved
                                       checkpoint file and the machine reading
@@ -1288,6 +1478,13 @@ struct volume {
   long long diffusion_number; /* Total number of times molecules have had their
                                  positions updated */
   double diffusion_cumtime;  /* Total time spent diffusing by all molecules */
+  /* Incremented whenever dynamic geometry changes the walls, which makes
+   * the cached tile neighbors of all grids stale */
+  unsigned long long grid_epoch;
+  /* Neighbor tiles of molecules whose neighbors can't be cached */
+  struct tile_ref *tile_nbr_scratch;
+  int max_tile_nbr_scratch;
+
   long long ray_voxel_tests; /* How many ray-subvolume intersection tests have
                                 we performed */
   long long ray_polygon_tests; /* How many ray-polygon intersection tests have
@@ -1387,6 +1584,8 @@ struct volume {
   /* resource usage during initialization */
   struct timeval u_init_time;    /* user time */
   struct timeval s_init_time;    /* system time */
+  double edge_init_time;         /* user time spent connecting walls along
+                                    shared edges (sharpen_world) */
   time_t t_start;                /* global start time */
   byte reaction_prob_limit_flag; /* checks whether there is at least one
                                     reaction with probability greater
@@ -1770,6 +1969,9 @@ struct output_trigger_data {
 struct polygon_object {
   int n_verts;                         /* Number of vertices in polyhedron */
   struct vertex_list *parsed_vertices; /* Temporary linked list */
+  struct vector3 *vertex_array;  /* Temporary flat array of vertices, used
+                                    instead of parsed_vertices for meshes
+                                    read from binary files */
   int n_walls;                         /* Number of triangles in polyhedron */
   struct element_data *element;        /* Array specifying the vertex
                                           connectivity of each triangle */
@@ -1866,6 +2068,12 @@ struct region {
   int region_has_all_elements; /* flag that tells whether the region contains
                                   ALL_ELEMENTS (effectively comprises the whole
                                   object) */
+  int counting_index; /* Dense index among counted regions (bit position in
+                         wall and waypoint region bit arrays), -1 if the
+                         region is not counted */
+  int border_index; /* Dense index among regions with borders (bit position
+                       in wall->border_region_bits), -1 for ALL and
+                       ALL_ELEMENTS regions */
 };
 
 /* A list of surface molecules */
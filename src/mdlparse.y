@@ -28,6 +28,7 @@
   #include "mcell_release.h"
   #include "mcell_objects.h"
   #include "mcell_dyngeom.h"
+  #include "dyngeom.h"
 
   /* make sure to declare yyscan_t before including mdlparse.h */
   typedef void *yyscan_t;
@@ -166,6 +167,8 @@ struct arg_list printfargs;
 %token       BACK
 %token       BACK_CROSSINGS
 %token       BACK_HITS
+%token       BINARY_MESH
+%token <ival> CACHED_MESH
 %token       BOTTOM
 %token       BOX
 %token       BOX_TRIANGULATION_REPORT
@@ -1791,6 +1794,32 @@ polygon_list_def:
                                                           $$ = (struct object *) $<obj>6;
                                                           CHECK(mdl_finish_polygon_list(parse_state, $$));
                                                       }
+        | new_object_name POLYGON_LIST
+          start_object
+            BINARY_MESH '=' file_name                 {
+                                                        CHECKN($<obj>$ = mdl_new_binary_polygon_list(
+                                                          parse_state, $1, $6));
+                                                      }
+            list_opt_polygon_object_cmds
+            list_opt_object_cmds
+          '}'
+                                                      {
+                                                          $$ = (struct object *) $<obj>7;
+                                                          CHECK(mdl_finish_polygon_list(parse_state, $$));
+                                                      }
+        | new_object_name POLYGON_LIST
+          start_object
+            CACHED_MESH                               {
+                                                        CHECKN($<obj>$ = mdl_new_cached_polygon_list(
+                                                          parse_state, $1, $4));
+                                                      }
+            list_opt_polygon_object_cmds
+            list_opt_object_cmds
+          '}'
+                                                      {
+                                                          $$ = (struct object *) $<obj>5;
+                                                          CHECK(mdl_finish_polygon_list(parse_state, $$));
+                                                      }
 ;
 
 vertex_list_cmd: VERTEX_LIST '{' list_points '}'      { $$ = $3; }
@@ -2635,6 +2664,8 @@ int mdlparse_file(struct mdlparse_vars *parse_state, char const *name)
   }
   parse_state->line_num[cur_stack] = 1;
   parse_state->include_filename[cur_stack] = name;
+  parse_state->cached_file[cur_stack] = -1;
+  parse_state->vertex_list_count[cur_stack] = 0;
 
   /* Open file, or know the reason why */
   no_printf("Opening file %s\n", name);
@@ -2677,6 +2708,22 @@ int mdlparse_file(struct mdlparse_vars *parse_state, char const *name)
   }
   mdlrestart(infile, scanner);
 
+  /* Under dynamic geometry, look up the meshes kept from earlier parses of
+   * this file */
+  if (parse_state->vol->dg_file_cache != NULL)
+  {
+    int seen;
+    if (dg_file_cache_lookup(parse_state->vol->dg_file_cache, name,
+                             &parse_state->cached_file[cur_stack], &seen))
+    {
+      mdlerror_fmt(parse_state, "Out of memory while caching file %s", name);
+      fclose(infile);
+      mdllex_destroy(scanner);
+      -- parse_state->include_stack_ptr;
+      return 1;
+    }
+  }
+
   /* Parse this file */
   prev_file = parse_state->vol->curr_file;
   parse_state->vol->curr_file = name;
@@ -2691,6 +2738,28 @@ int mdlparse_file(struct mdlparse_vars *parse_state, char const *name)
   return failure;
 }
 
+/* mdl_cached_mesh_ahead: Called by the lexer at each VERTEX_LIST to check
+ *               whether the vertices and walls that follow were kept from
+ *               an earlier parse of the same file, in which case the lexer
+ *               skips them.
+ *
+ *   parse_state: the parser state variables
+ *   mesh_index: set to the index of the cached mesh in the file's meshes
+ *   returns 1 if the mesh is cached, 0 if it must be parsed
+ */
+int mdl_cached_mesh_ahead(struct mdlparse_vars *parse_state, int *mesh_index)
+{
+  int cur_stack = parse_state->include_stack_ptr - 1;
+  int ordinal = parse_state->vertex_list_count[cur_stack] ++;
+  int file_index = parse_state->cached_file[cur_stack];
+  if (file_index < 0)
+    return 0;
+
+  *mesh_index = dg_file_cache_find_mesh(parse_state->vol->dg_file_cache,
+                                        file_index, ordinal);
+  return (*mesh_index >= 0);
+}
+
 /* mdlerror_init: Set up and parse the top-level MDL file.
  *
  *   vol: the world to populate
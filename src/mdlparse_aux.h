@@ -139,6 +139,17 @@ struct mdlparse_vars {
   /* Stack pointer for filename/line number stack */
   u_int include_stack_ptr;
 
+  /* Index in the dynamic geometry file cache of each of the currently
+   * parsing files (-1 if not cached), and the number of VERTEX_LISTs read
+   * from each so far */
+  int cached_file[MAX_INCLUDE_DEPTH];
+  int vertex_list_count[MAX_INCLUDE_DEPTH];
+
+  /* Brace depth, and number of blocks passed, while skipping the vertices
+   * and walls of a cached mesh */
+  int cached_mesh_depth;
+  int cached_mesh_blocks;
+
   /* The world we are constructing */
   struct volume *vol;
 
@@ -207,3 +218,4 @@ void mdlerror_fmt(struct mdlparse_vars *parse_state, char const *fmt, ...)
     PRINTF_FORMAT(2);
 int mdlparse_init(struct volume *vol);
 int mdlparse_file(struct mdlparse_vars *parse_state, char const *name);
+int mdl_cached_mesh_ahead(struct mdlparse_vars *parse_state, int *mesh_index);
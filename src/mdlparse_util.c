@@ -51,6 +51,7 @@
 #include "mcell_viz.h"
 #include "mcell_release.h"
 #include "dyngeom_parse_extras.h"
+#include "dyngeom.h"
 #include "mem_util.h"
 
 extern void chkpt_signal_handler(int sn);
@@ -5459,6 +5460,19 @@ mdl_new_polygon_list(struct mdlparse_vars *parse_state, char *obj_name,
                  obj_name);
   }
 
+  // Keep the mesh for later parses of this file by geometry events
+  int cur_stack = parse_state->include_stack_ptr - 1;
+  int file_index = parse_state->cached_file[cur_stack];
+  if (file_index >= 0 &&
+      dg_file_cache_add_mesh(parse_state->vol->dg_file_cache, file_index,
+                             parse_state->vertex_list_count[cur_stack] - 1,
+                             n_vertices, vertices, n_connections,
+                             connections)) {
+    mdlerror_fmt(parse_state, "Out of memory while caching object: %s",
+                 obj_ptr->sym->name);
+    return NULL;
+  }
+
   struct polygon_object *poly_obj_ptr =
       new_polygon_list(parse_state->vol, obj_ptr, n_vertices, vertices,
                        n_connections, connections);
@@ -5473,6 +5487,156 @@ mdl_new_polygon_list(struct mdlparse_vars *parse_state, char *obj_name,
   return obj_ptr;
 }
 
+/**************************************************************************
+ mdl_new_binary_polygon_list:
+    Create a new polygon list object from a binary mesh file.  The vertices
+    and walls are read into flat arrays instead of going through the parser,
+    and the regions stored in the file are defined on the object.
+
+ In: parse_state: parser state
+     obj_name: name of this polygon list
+     file_name: binary mesh file, relative to the current MDL file
+ Out: polygon object, or NULL if there was an error
+**************************************************************************/
+struct object *
+mdl_new_binary_polygon_list(struct mdlparse_vars *parse_state, char *obj_name,
+                            char *file_name) {
+  struct object_creation obj_creation;
+  obj_creation.object_name_list = parse_state->object_name_list;
+  obj_creation.object_name_list_end = parse_state->object_name_list_end;
+  obj_creation.current_object = parse_state->current_object;
+
+  if (parse_state->vol->disable_polygon_objects) {
+    mdlerror(
+        parse_state,
+        "When using dynamic geometries, polygon objects should only be "
+        "defined/instantiated through the dynamic geometry file.");
+  }
+
+  char *mesh_path =
+      mcell_find_include_file(file_name, parse_state->vol->curr_file);
+  free(file_name);
+  if (mesh_path == NULL) {
+    mdlerror(parse_state, "Out of memory while opening binary mesh file");
+    return NULL;
+  }
+  struct binary_mesh mesh;
+  if (read_binary_mesh(mesh_path, &mesh)) {
+    mdlerror_fmt(parse_state, "Cannot read binary mesh file '%s'", mesh_path);
+    free(mesh_path);
+    return NULL;
+  }
+  free(mesh_path);
+
+  int error_code = 0;
+  struct object *obj_ptr =
+      start_object(parse_state->vol, &obj_creation, obj_name, &error_code);
+  if (error_code == 1) {
+    mdlerror_fmt(parse_state,"Object '%s' is already defined", obj_name);
+  }
+  else if (error_code == 2) {
+    mdlerror_fmt(parse_state, "Out of memory while creating object: %s",
+                 obj_name);
+  }
+
+  // The polygon object takes over the vertex and element arrays
+  struct polygon_object *poly_obj_ptr = new_polygon_list_from_arrays(
+      parse_state->vol, obj_ptr, mesh.n_verts, mesh.vertices, mesh.n_walls,
+      mesh.elements);
+  mesh.vertices = NULL;
+  mesh.elements = NULL;
+  if (poly_obj_ptr == NULL ||
+      add_binary_mesh_regions(parse_state->vol, obj_ptr, &mesh)) {
+    mdlerror_fmt(parse_state, "Error setting up the regions of the binary "
+                 "mesh object '%s'", obj_ptr->sym->name);
+    free_binary_mesh(&mesh);
+    return NULL;
+  }
+  free_binary_mesh(&mesh);
+
+  parse_state->object_name_list = obj_creation.object_name_list;
+  parse_state->object_name_list_end = obj_creation.object_name_list_end;
+  parse_state->current_object = obj_ptr;
+
+  parse_state->allow_patches = 0;
+  parse_state->current_polygon = poly_obj_ptr;
+
+  return obj_ptr;
+}
+
+/**************************************************************************
+ mdl_new_cached_polygon_list:
+    Create a new polygon list object from a mesh kept from an earlier parse
+    of the current file, whose vertices and walls the lexer skipped.
+
+ In: parse_state: parser state
+     obj_name: name of this polygon list
+     mesh_index: index of the mesh among those cached for the current file
+ Out: polygon object, or NULL if there was an error
+**************************************************************************/
+struct object *
+mdl_new_cached_polygon_list(struct mdlparse_vars *parse_state, char *obj_name,
+                            int mesh_index) {
+  struct object_creation obj_creation;
+  obj_creation.object_name_list = parse_state->object_name_list;
+  obj_creation.object_name_list_end = parse_state->object_name_list_end;
+  obj_creation.current_object = parse_state->current_object;
+
+  if (parse_state->vol->disable_polygon_objects) {
+    mdlerror(
+        parse_state,
+        "When using dynamic geometries, polygon objects should only be "
+        "defined/instantiated through the dynamic geometry file.");
+  }
+
+  struct dg_file_cache *cache = parse_state->vol->dg_file_cache;
+  int file_index = parse_state->cached_file[parse_state->include_stack_ptr - 1];
+  struct dg_cached_mesh *mesh = &cache->files[file_index].meshes[mesh_index];
+
+  int error_code = 0;
+  struct object *obj_ptr =
+      start_object(parse_state->vol, &obj_creation, obj_name, &error_code);
+  if (error_code == 1) {
+    mdlerror_fmt(parse_state,"Object '%s' is already defined", obj_name);
+  }
+  else if (error_code == 2) {
+    mdlerror_fmt(parse_state, "Out of memory while creating object: %s",
+                 obj_name);
+  }
+
+  // The polygon object takes over copies of the cached arrays
+  struct vector3 *vertices = CHECKED_MALLOC_ARRAY(
+      struct vector3, mesh->n_verts, "polygon list object vertices");
+  struct element_data *elements = CHECKED_MALLOC_ARRAY(
+      struct element_data, mesh->n_walls, "polygon list object walls");
+  if (vertices == NULL || elements == NULL) {
+    free(vertices);
+    free(elements);
+    return NULL;
+  }
+  memcpy(vertices, mesh->vertices, mesh->n_verts * sizeof(struct vector3));
+  memcpy(elements, mesh->elements,
+         mesh->n_walls * sizeof(struct element_data));
+
+  struct polygon_object *poly_obj_ptr = new_polygon_list_from_arrays(
+      parse_state->vol, obj_ptr, mesh->n_verts, vertices, mesh->n_walls,
+      elements);
+  if (poly_obj_ptr == NULL) {
+    mdlerror_fmt(parse_state, "Out of memory while creating object: %s",
+                 obj_ptr->sym->name);
+    return NULL;
+  }
+
+  parse_state->object_name_list = obj_creation.object_name_list;
+  parse_state->object_name_list_end = obj_creation.object_name_list_end;
+  parse_state->current_object = obj_ptr;
+
+  parse_state->allow_patches = 0;
+  parse_state->current_polygon = poly_obj_ptr;
+
+  return obj_ptr;
+}
+
 /**************************************************************************
  mdl_finish_polygon_list:
     Finalize the polygon list, cleaning up any state updates that were made
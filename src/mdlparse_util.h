@@ -505,6 +505,17 @@ mdl_new_polygon_list(struct mdlparse_vars *parse_state, char *obj_name,
                      int n_connections,
                      struct element_connection_list *connections);
 
+/* Create a new polygon list object from a binary mesh file. */
+struct object *
+mdl_new_binary_polygon_list(struct mdlparse_vars *parse_state, char *obj_name,
+                            char *file_name);
+
+/* Create a new polygon list object from a mesh kept by the dynamic geometry
+ * file cache. */
+struct object *
+mdl_new_cached_polygon_list(struct mdlparse_vars *parse_state, char *obj_name,
+                            int mesh_index);
+
 /* Finalize the polygon list, cleaning up any state updates that were made when
  * we started creating the polygon. */
 int mdl_finish_polygon_list(struct mdlparse_vars *parse_state,
@@ -152,6 +152,8 @@ struct rxn *test_many_unimol(struct rxn **rx, int n,
                              struct abstract_molecule *a,
                              struct rng_state *rng);
 
+double rate_change_iteration(double t);
+
 void update_probs(struct volume *world, struct rxn *rx, double t);
 
 /* In react_outc.c */
@@ -237,15 +239,15 @@ place_volume_product(struct volume *world, struct species *product_species, stru
 
 int determine_molecule_region_topology(
     struct volume *world, struct surface_molecule *sm_1,
-    struct surface_molecule *sm_2, struct region_list **rlp_wall_1_ptr,
-    struct region_list **rlp_wall_2_ptr, struct region_list **rlp_obj_1_ptr,
-    struct region_list **rlp_obj_2_ptr, bool is_unimol);
+    struct surface_molecule *sm_2, struct bit_array **rlp_wall_1_ptr,
+    struct bit_array **rlp_wall_2_ptr, struct bit_array **rlp_obj_1_ptr,
+    struct bit_array **rlp_obj_2_ptr, bool is_unimol);
 
 bool product_tile_can_be_reached(struct wall *target,
-                                 struct region_list *rlp_head_wall_1,
-                                 struct region_list *rlp_head_wall_2,
-                                 struct region_list *rlp_head_obj_1,
-                                 struct region_list *rlp_head_obj_2,
+                                 struct bit_array *rlp_head_wall_1,
+                                 struct bit_array *rlp_head_wall_2,
+                                 struct bit_array *rlp_head_obj_1,
+                                 struct bit_array *rlp_head_obj_2,
                                  int sm_bitmask, bool is_unimol);
 
 //NFSim specific functions
@@ -402,15 +402,42 @@ struct rxn *test_many_unimol(struct rxn **rx, int n,
 }
 
 /*************************************************************************
-check_probs:
+rate_change_iteration:
+  In: t: time of a rate change read from a rate file, in iterations
+  Out: The iteration at whose start the change is applied. Changes which
+       fall inside an iteration take effect at the following iteration
+       boundary; times within round-off of a boundary snap to it.
+*************************************************************************/
+double rate_change_iteration(double t) {
+  return ceil(t - EPS_C * (1.0 + fabs(t)));
+}
+
+/*************************************************************************
+rate_change_due:
+  In: rx: a reaction with time-varying rates
+      time: time of one of its rate changes
+      t: the current time
+  Out: 1 if the change applies at t, 0 otherwise. Scheduled changes lie on
+       iteration boundaries and apply from their boundary on; the others
+       apply as soon as t has passed them.
+*************************************************************************/
+static int rate_change_due(struct rxn *rx, double time, double t) {
+  if (rx->rate_changes_scheduled)
+    return rate_change_iteration(time) <= t;
+  return time < t;
+}
+
+/*************************************************************************
+update_probs:
   In: A reaction struct
       The current time
-  Out: No return value.  Probabilities are updated if necessary.
-       Memory isn't reclaimed.
-  Note: This isn't meant for really heavy-duty use (multiple pathways
-        with rapidly changing rates)--if you want that, the code should
-        probably be rewritten to accumulate probability changes from the
-        list as it goes (and the list should be sorted by pathway, too).
+  Out: No return value.  All pending rate changes which apply at t are
+       folded into the probabilities.  Memory isn't reclaimed.
+  Note: If rx->rate_changes_scheduled, this is called from the rate change
+        scheduler at iteration boundaries, and the reaction tests never look
+        at prob_t.  Otherwise the reaction tests call it with the time of
+        the molecule at hand, so that changes inside an iteration take
+        effect on time.
   Note: We're still displaying geometries here, rather than orientations.
         Perhaps that should be fixed.
 *************************************************************************/
@@ -421,7 +448,8 @@ void update_probs(struct volume *world, struct rxn *rx, double t) {
   int did_something = 0;
   double new_prob = 0;
 
-  for (tv = rx->prob_t; tv != NULL && tv->time < t; tv = tv->next) {
+  for (tv = rx->prob_t; tv != NULL && rate_change_due(rx, tv->time, t);
+       tv = tv->next) {
     j = tv->path;
     if (j == 0)
       dprob = tv->value - rx->cum_probs[0];
@@ -445,7 +473,7 @@ void update_probs(struct volume *world, struct rxn *rx, double t) {
 
       if (world->chkpt_seq_num > 1) {
         if (tv->next != NULL) {
-          if (tv->next->time < t)
+          if (rate_change_due(rx, tv->next->time, t))
             continue; /* do not print messages */
         }
       }
@@ -401,10 +401,10 @@ static int outcome_products_random(struct volume *world, struct wall *w,
   bool const is_orientable = (w != NULL) || (sm_reactant != NULL);
 
   /* list of the restricted regions for the reactants by wall */
-  struct region_list *rlp_head_wall_1 = NULL, *rlp_head_wall_2 = NULL;
+  struct bit_array *rlp_head_wall_1 = NULL, *rlp_head_wall_2 = NULL;
 
   /* list of the restricted regions for the reactants by object */
-  struct region_list *rlp_head_obj_1 = NULL, *rlp_head_obj_2 = NULL;
+  struct bit_array *rlp_head_obj_1 = NULL, *rlp_head_obj_2 = NULL;
 
   int sm_bitmask = determine_molecule_region_topology(
       world, sm_1, sm_2, &rlp_head_wall_1, &rlp_head_wall_2, &rlp_head_obj_1,
@@ -1045,10 +1045,14 @@ static int outcome_products_random(struct volume *world, struct wall *w,
   /* recover memory */
   delete_tile_neighbor_list(tile_nbr_head);
   delete_tile_neighbor_list(tile_vacant_nbr_head);
-  delete_region_list(rlp_head_wall_1);
-  delete_region_list(rlp_head_wall_2);
-  delete_region_list(rlp_head_obj_1);
-  delete_region_list(rlp_head_obj_2);
+  if (rlp_head_wall_1 != NULL)
+    free_bit_array(rlp_head_wall_1);
+  if (rlp_head_wall_2 != NULL)
+    free_bit_array(rlp_head_wall_2);
+  if (rlp_head_obj_1 != NULL)
+    free_bit_array(rlp_head_obj_1);
+  if (rlp_head_obj_2 != NULL)
+    free_bit_array(rlp_head_obj_2);
 
   return cross_wall ? RX_FLIP : RX_A_OK;
 }
@@ -1544,26 +1548,26 @@ int reaction_wizardry(struct volume *world, struct magic_list *incantation,
  *
  * in: surface molecule 1 (located on wall 1)
  *     surface molecule 2 (located on wall 2)
- *     pointer to array with restrictive regions which contain wall 1
- *     pointer to array with restrictive regions which contain wall 2
- *     pointer to array with restrictive regions which don't contain wall 1
- *     pointer to array with restrictive regions which don't contain wall 2
+ *     pointer to bit array with restrictive regions which contain wall 1
+ *     pointer to bit array with restrictive regions which contain wall 2
+ *     pointer to bit array with restrictive regions which don't contain wall 1
+ *     pointer to bit array with restrictive regions which don't contain wall 2
  *
- * out: the 4 arrays with pointers to restrictive regions will be filled
- *      and returned
+ * out: the 4 bit arrays (indexed by region->border_index) will be filled
+ *      and returned; the caller releases them with free_bit_array
  *
  ***********************************************************************/
 int determine_molecule_region_topology(
     struct volume *world, struct surface_molecule *sm_1,
-    struct surface_molecule *sm_2, struct region_list **rlp_wall_1_ptr,
-    struct region_list **rlp_wall_2_ptr, struct region_list **rlp_obj_1_ptr,
-    struct region_list **rlp_obj_2_ptr, bool is_unimol) {
+    struct surface_molecule *sm_2, struct bit_array **rlp_wall_1_ptr,
+    struct bit_array **rlp_wall_2_ptr, struct bit_array **rlp_obj_1_ptr,
+    struct bit_array **rlp_obj_2_ptr, bool is_unimol) {
   int sm_bitmask = 0;
   struct wall *w_1, *w_2;
-  struct region_list *rlp_head_wall_1 = NULL;
-  struct region_list *rlp_head_wall_2 = NULL;
-  struct region_list *rlp_head_obj_1 = NULL;
-  struct region_list *rlp_head_obj_2 = NULL;
+  struct bit_array *rlp_head_wall_1 = NULL;
+  struct bit_array *rlp_head_wall_2 = NULL;
+  struct bit_array *rlp_head_obj_1 = NULL;
+  struct bit_array *rlp_head_obj_2 = NULL;
 
   /* bimolecular reactions */
   if ((sm_1 != NULL) && (sm_2 != NULL)) {
@@ -1677,73 +1681,73 @@ int determine_molecule_region_topology(
  * wall 2 is the wall containing reactant 2.
  *
  * in: wall to test for product placement
- *     pointer to array with regions that contain wall 1
- *     pointer to array with regions that contain wall 2
- *     pointer to array with regions that do not contain wall 1
- *     pointer to array with regions that do not contain wall 2
+ *     bit array with regions that contain wall 1
+ *     bit array with regions that contain wall 2
+ *     bit array with regions that do not contain wall 1
+ *     bit array with regions that do not contain wall 2
  *
  * out: returns true or false depending if wall target can be
  *      used for product placement.
  *
  ***********************************************************************/
 bool product_tile_can_be_reached(struct wall *target,
-                                 struct region_list *rlp_head_wall_1,
-                                 struct region_list *rlp_head_wall_2,
-                                 struct region_list *rlp_head_obj_1,
-                                 struct region_list *rlp_head_obj_2,
+                                 struct bit_array *rlp_head_wall_1,
+                                 struct bit_array *rlp_head_wall_2,
+                                 struct bit_array *rlp_head_obj_1,
+                                 struct bit_array *rlp_head_obj_2,
                                  int sm_bitmask, bool is_unimol) {
   bool status = true;
 
   if (sm_bitmask & ALL_INSIDE) {
     if (is_unimol) {
-      if (!wall_belongs_to_all_regions_in_region_list(target,
+      if (!wall_belongs_to_all_regions(target,
                                                       rlp_head_wall_1)) {
         status = false;
       }
     } else {
       /* bimol reaction */
-      if (!wall_belongs_to_all_regions_in_region_list(target,
+      if (!wall_belongs_to_all_regions(target,
                                                       rlp_head_wall_1) ||
-          !wall_belongs_to_all_regions_in_region_list(target,
+          !wall_belongs_to_all_regions(target,
                                                       rlp_head_wall_2)) {
         status = false;
       }
     }
   } else if (sm_bitmask & ALL_OUTSIDE) {
     if (is_unimol) {
-      if (wall_belongs_to_any_region_in_region_list(target, rlp_head_obj_1)) {
+      if (wall_belongs_to_any_region(target, rlp_head_obj_1)) {
         status = false;
       }
     } else {
-      if (wall_belongs_to_any_region_in_region_list(target, rlp_head_obj_1) ||
-          wall_belongs_to_any_region_in_region_list(target, rlp_head_obj_2)) {
+      if (wall_belongs_to_any_region(target, rlp_head_obj_1) ||
+          wall_belongs_to_any_region(target, rlp_head_obj_2)) {
         status = false;
       }
     }
   } else if (sm_bitmask & SURF1_IN_SURF2_OUT) {
-    if (!wall_belongs_to_all_regions_in_region_list(target, rlp_head_wall_1) ||
-        wall_belongs_to_any_region_in_region_list(target, rlp_head_obj_2)) {
+    if (!wall_belongs_to_all_regions(target, rlp_head_wall_1) ||
+        wall_belongs_to_any_region(target, rlp_head_obj_2)) {
       status = false;
     }
   } else if (sm_bitmask & SURF1_OUT_SURF2_IN) {
-    if (wall_belongs_to_any_region_in_region_list(target, rlp_head_obj_1) ||
-        !wall_belongs_to_all_regions_in_region_list(target, rlp_head_wall_2)) {
+    if (wall_belongs_to_any_region(target, rlp_head_obj_1) ||
+        !wall_belongs_to_all_regions(target, rlp_head_wall_2)) {
       status = false;
     }
   } else if (sm_bitmask & SURF1_IN) {
-    if (!wall_belongs_to_all_regions_in_region_list(target, rlp_head_wall_1)) {
+    if (!wall_belongs_to_all_regions(target, rlp_head_wall_1)) {
       status = false;
     }
   } else if (sm_bitmask & SURF1_OUT) {
-    if (wall_belongs_to_any_region_in_region_list(target, rlp_head_obj_1)) {
+    if (wall_belongs_to_any_region(target, rlp_head_obj_1)) {
       status = false;
     }
   } else if (sm_bitmask & SURF2_IN) {
-    if (!wall_belongs_to_all_regions_in_region_list(target, rlp_head_wall_2)) {
+    if (!wall_belongs_to_all_regions(target, rlp_head_wall_2)) {
       status = false;
     }
   } else if (sm_bitmask & SURF2_OUT) {
-    if (wall_belongs_to_any_region_in_region_list(target, rlp_head_obj_2)) {
+    if (wall_belongs_to_any_region(target, rlp_head_obj_2)) {
       status = false;
     }
   }
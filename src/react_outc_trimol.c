@@ -44,6 +44,25 @@ static int outcome_products_trimol_reaction_random(
     struct abstract_molecule *reacB, struct abstract_molecule *reacC,
     short orientA, short orientB, short orientC);
 
+/*************************************************************************
+free_restricted_regions:
+   In: the restricted region bit arrays of the three reactants by wall
+       the restricted region bit arrays of the three reactants by object
+   Out: No return value.  The bit arrays that were allocated are freed.
+************************************************************************/
+static void free_restricted_regions(struct bit_array *wall_1,
+                                    struct bit_array *wall_2,
+                                    struct bit_array *wall_3,
+                                    struct bit_array *obj_1,
+                                    struct bit_array *obj_2,
+                                    struct bit_array *obj_3) {
+  struct bit_array *all[] = { wall_1, wall_2, wall_3, obj_1, obj_2, obj_3 };
+  for (int i = 0; i < 6; i++) {
+    if (all[i] != NULL)
+      free_bit_array(all[i]);
+  }
+}
+
 /*************************************************************************
 outcome_products_trimol_reaction_random:
    In: first wall in the reaction
@@ -235,12 +254,12 @@ static int outcome_products_trimol_reaction_random(
      outside it's restrictive region.  */
   int only_grid_3_outside = 0;
 
-  /* list of the restricted regions for the reactants by wall */
-  struct region_list *rlp_head_wall_1 = NULL, *rlp_head_wall_2 = NULL,
-                     *rlp_head_wall_3 = NULL;
-  /* list of the restricted regions for the reactants by object */
-  struct region_list *rlp_head_obj_1 = NULL, *rlp_head_obj_2 = NULL,
-                     *rlp_head_obj_3 = NULL;
+  /* the restricted regions for the reactants by wall */
+  struct bit_array *rlp_head_wall_1 = NULL, *rlp_head_wall_2 = NULL,
+                   *rlp_head_wall_3 = NULL;
+  /* the restricted regions for the reactants by object */
+  struct bit_array *rlp_head_obj_1 = NULL, *rlp_head_obj_2 = NULL,
+                   *rlp_head_obj_3 = NULL;
 
   struct vector2 rxn_uv_pos; /* position of the reaction */
   int rxn_uv_idx = -1;       /* tile index of the reaction place */
@@ -715,6 +734,9 @@ static int outcome_products_trimol_reaction_random(
           delete_tile_neighbor_list(tile_nbr_head);
         if (tile_vacant_nbr_head != NULL)
           delete_tile_neighbor_list(tile_vacant_nbr_head);
+        free_restricted_regions(rlp_head_wall_1, rlp_head_wall_2,
+                                rlp_head_wall_3, rlp_head_obj_1,
+                                rlp_head_obj_2, rlp_head_obj_3);
         return RX_BLOCKED;
       }
     } else if (two_to_replace) {
@@ -723,6 +745,9 @@ static int outcome_products_trimol_reaction_random(
           delete_tile_neighbor_list(tile_nbr_head);
         if (tile_vacant_nbr_head != NULL)
           delete_tile_neighbor_list(tile_vacant_nbr_head);
+        free_restricted_regions(rlp_head_wall_1, rlp_head_wall_2,
+                                rlp_head_wall_3, rlp_head_obj_1,
+                                rlp_head_obj_2, rlp_head_obj_3);
         return RX_BLOCKED;
       }
     } else if (only_one_to_replace) {
@@ -731,6 +756,9 @@ static int outcome_products_trimol_reaction_random(
           delete_tile_neighbor_list(tile_nbr_head);
         if (tile_vacant_nbr_head != NULL)
           delete_tile_neighbor_list(tile_vacant_nbr_head);
+        free_restricted_regions(rlp_head_wall_1, rlp_head_wall_2,
+                                rlp_head_wall_3, rlp_head_obj_1,
+                                rlp_head_obj_2, rlp_head_obj_3);
         return RX_BLOCKED;
       }
     } else {
@@ -740,6 +768,9 @@ static int outcome_products_trimol_reaction_random(
           delete_tile_neighbor_list(tile_nbr_head);
         if (tile_vacant_nbr_head != NULL)
           delete_tile_neighbor_list(tile_vacant_nbr_head);
+        free_restricted_regions(rlp_head_wall_1, rlp_head_wall_2,
+                                rlp_head_wall_3, rlp_head_obj_1,
+                                rlp_head_obj_2, rlp_head_obj_3);
         return RX_BLOCKED;
       }
     }
@@ -1278,6 +1309,9 @@ static int outcome_products_trimol_reaction_random(
             delete_tile_neighbor_list(tile_nbr_head);
           if (tile_vacant_nbr_head != NULL)
             delete_tile_neighbor_list(tile_vacant_nbr_head);
+          free_restricted_regions(rlp_head_wall_1, rlp_head_wall_2,
+                                  rlp_head_wall_3, rlp_head_obj_1,
+                                  rlp_head_obj_2, rlp_head_obj_3);
           return RX_BLOCKED;
         }
 
@@ -1287,6 +1321,9 @@ static int outcome_products_trimol_reaction_random(
               delete_tile_neighbor_list(tile_nbr_head);
             if (tile_vacant_nbr_head != NULL)
               delete_tile_neighbor_list(tile_vacant_nbr_head);
+            free_restricted_regions(rlp_head_wall_1, rlp_head_wall_2,
+                                    rlp_head_wall_3, rlp_head_obj_1,
+                                    rlp_head_obj_2, rlp_head_obj_3);
             return RX_BLOCKED;
           }
 
@@ -1301,6 +1338,9 @@ static int outcome_products_trimol_reaction_random(
               delete_tile_neighbor_list(tile_nbr_head);
             if (tile_vacant_nbr_head != NULL)
               delete_tile_neighbor_list(tile_vacant_nbr_head);
+            free_restricted_regions(rlp_head_wall_1, rlp_head_wall_2,
+                                    rlp_head_wall_3, rlp_head_obj_1,
+                                    rlp_head_obj_2, rlp_head_obj_3);
             return RX_BLOCKED;
           }
           if (tile_idx < 0)
@@ -1312,11 +1352,11 @@ static int outcome_products_trimol_reaction_random(
             /* if this tile is not inside the restricted boundary
                - try again */
             int cond_1 = 0, cond_2 = 0, cond_3 = 0;
-            cond_1 = (!wall_belongs_to_all_regions_in_region_list(
+            cond_1 = (!wall_belongs_to_all_regions(
                            tile_grid->surface, rlp_head_wall_1));
-            cond_2 = (!wall_belongs_to_all_regions_in_region_list(
+            cond_2 = (!wall_belongs_to_all_regions(
                            tile_grid->surface, rlp_head_wall_2));
-            cond_3 = (!wall_belongs_to_all_regions_in_region_list(
+            cond_3 = (!wall_belongs_to_all_regions(
                            tile_grid->surface, rlp_head_wall_3));
 
             if (cond_1 || cond_2 || cond_3) {
@@ -1326,11 +1366,11 @@ static int outcome_products_trimol_reaction_random(
             }
           } else if (all_outside_restricted_boundary) {
             int cond_1 = 0, cond_2 = 0, cond_3 = 0;
-            cond_1 = wall_belongs_to_any_region_in_region_list(
+            cond_1 = wall_belongs_to_any_region(
                 tile_grid->surface, rlp_head_obj_1);
-            cond_2 = wall_belongs_to_any_region_in_region_list(
+            cond_2 = wall_belongs_to_any_region(
                 tile_grid->surface, rlp_head_obj_2);
-            cond_3 = wall_belongs_to_any_region_in_region_list(
+            cond_3 = wall_belongs_to_any_region(
                 tile_grid->surface, rlp_head_obj_3);
 
             if (cond_1 || cond_2 || cond_3) {
@@ -1340,11 +1380,11 @@ static int outcome_products_trimol_reaction_random(
             }
           } else if (sm_1_inside_sm_2_inside_grid_3_outside) {
             int cond_1 = 0, cond_2 = 0, cond_3 = 0;
-            cond_1 = !(wall_belongs_to_all_regions_in_region_list(
+            cond_1 = !(wall_belongs_to_all_regions(
                           tile_grid->surface, rlp_head_wall_1));
-            cond_2 = !(wall_belongs_to_all_regions_in_region_list(
+            cond_2 = !(wall_belongs_to_all_regions(
                           tile_grid->surface, rlp_head_wall_2));
-            cond_3 = wall_belongs_to_any_region_in_region_list(
+            cond_3 = wall_belongs_to_any_region(
                 tile_grid->surface, rlp_head_obj_3);
 
             if (cond_1 || cond_2 || cond_3) {
@@ -1354,11 +1394,11 @@ static int outcome_products_trimol_reaction_random(
             }
           } else if (sm_1_inside_sm_2_outside_grid_3_inside) {
             int cond_1 = 0, cond_2 = 0, cond_3 = 0;
-            cond_1 = !(wall_belongs_to_all_regions_in_region_list(
+            cond_1 = !(wall_belongs_to_all_regions(
                           tile_grid->surface, rlp_head_wall_1));
-            cond_2 = wall_belongs_to_any_region_in_region_list(
+            cond_2 = wall_belongs_to_any_region(
                 tile_grid->surface, rlp_head_obj_2);
-            cond_3 = !(wall_belongs_to_all_regions_in_region_list(
+            cond_3 = !(wall_belongs_to_all_regions(
                           tile_grid->surface, rlp_head_wall_3));
 
             if (cond_1 || cond_2 || cond_3) {
@@ -1368,11 +1408,11 @@ static int outcome_products_trimol_reaction_random(
             }
           } else if (sm_1_inside_sm_2_outside_grid_3_outside) {
             int cond_1 = 0, cond_2 = 0, cond_3 = 0;
-            cond_1 = !(wall_belongs_to_all_regions_in_region_list(
+            cond_1 = !(wall_belongs_to_all_regions(
                           tile_grid->surface, rlp_head_wall_1));
-            cond_2 = wall_belongs_to_any_region_in_region_list(
+            cond_2 = wall_belongs_to_any_region(
                 tile_grid->surface, rlp_head_obj_2);
-            cond_3 = wall_belongs_to_any_region_in_region_list(
+            cond_3 = wall_belongs_to_any_region(
                 tile_grid->surface, rlp_head_obj_3);
 
             if (cond_1 || cond_2 || cond_3) {
@@ -1382,11 +1422,11 @@ static int outcome_products_trimol_reaction_random(
             }
           } else if (sm_1_outside_sm_2_inside_grid_3_outside) {
             int cond_1 = 0, cond_2 = 0, cond_3 = 0;
-            cond_1 = wall_belongs_to_any_region_in_region_list(
+            cond_1 = wall_belongs_to_any_region(
                 tile_grid->surface, rlp_head_obj_1);
-            cond_2 = !(wall_belongs_to_all_regions_in_region_list(
+            cond_2 = !(wall_belongs_to_all_regions(
                           tile_grid->surface, rlp_head_wall_2));
-            cond_3 = wall_belongs_to_any_region_in_region_list(
+            cond_3 = wall_belongs_to_any_region(
                 tile_grid->surface, rlp_head_obj_3);
 
             if (cond_1 || cond_2 || cond_3) {
@@ -1396,11 +1436,11 @@ static int outcome_products_trimol_reaction_random(
             }
           } else if (sm_1_outside_sm_2_inside_grid_3_inside) {
             int cond_1 = 0, cond_2 = 0, cond_3 = 0;
-            cond_1 = wall_belongs_to_any_region_in_region_list(
+            cond_1 = wall_belongs_to_any_region(
                 tile_grid->surface, rlp_head_obj_1);
-            cond_2 = !(wall_belongs_to_all_regions_in_region_list(
+            cond_2 = !(wall_belongs_to_all_regions(
                           tile_grid->surface, rlp_head_wall_2));
-            cond_3 = !(wall_belongs_to_all_regions_in_region_list(
+            cond_3 = !(wall_belongs_to_all_regions(
                           tile_grid->surface, rlp_head_wall_3));
 
             if (cond_1 || cond_2 || cond_3) {
@@ -1410,11 +1450,11 @@ static int outcome_products_trimol_reaction_random(
             }
           } else if (sm_1_outside_sm_2_outside_grid_3_inside) {
             int cond_1 = 0, cond_2 = 0, cond_3 = 0;
-            cond_1 = wall_belongs_to_any_region_in_region_list(
+            cond_1 = wall_belongs_to_any_region(
                 tile_grid->surface, rlp_head_obj_1);
-            cond_2 = wall_belongs_to_any_region_in_region_list(
+            cond_2 = wall_belongs_to_any_region(
                 tile_grid->surface, rlp_head_obj_2);
-            cond_3 = !(wall_belongs_to_all_regions_in_region_list(
+            cond_3 = !(wall_belongs_to_all_regions(
                           tile_grid->surface, rlp_head_wall_3));
 
             if (cond_1 || cond_2 || cond_3) {
@@ -1424,9 +1464,9 @@ static int outcome_products_trimol_reaction_random(
             }
           } else if (only_sm_1_sm_2_inside) {
             int cond_1 = 0, cond_2 = 0;
-            cond_1 = !(wall_belongs_to_all_regions_in_region_list(
+            cond_1 = !(wall_belongs_to_all_regions(
                           tile_grid->surface, rlp_head_wall_1));
-            cond_2 = !(wall_belongs_to_all_regions_in_region_list(
+            cond_2 = !(wall_belongs_to_all_regions(
                           tile_grid->surface, rlp_head_wall_2));
 
             if (cond_1 || cond_2) {
@@ -1436,9 +1476,9 @@ static int outcome_products_trimol_reaction_random(
             }
           } else if (only_sm_1_inside_sm_2_outside) {
             int cond_1 = 0, cond_2 = 0;
-            cond_1 = !(wall_belongs_to_all_regions_in_region_list(
+            cond_1 = !(wall_belongs_to_all_regions(
                           tile_grid->surface, rlp_head_wall_1));
-            cond_2 = wall_belongs_to_any_region_in_region_list(
+            cond_2 = wall_belongs_to_any_region(
                 tile_grid->surface, rlp_head_obj_2);
 
             if (cond_1 || cond_2) {
@@ -1448,9 +1488,9 @@ static int outcome_products_trimol_reaction_random(
             }
           } else if (only_sm_1_outside_sm_2_inside) {
             int cond_1 = 0, cond_2 = 0;
-            cond_1 = wall_belongs_to_any_region_in_region_list(
+            cond_1 = wall_belongs_to_any_region(
                 tile_grid->surface, rlp_head_obj_1);
-            cond_2 = !(wall_belongs_to_all_regions_in_region_list(
+            cond_2 = !(wall_belongs_to_all_regions(
                           tile_grid->surface, rlp_head_wall_2));
 
             if (cond_1 || cond_2) {
@@ -1460,9 +1500,9 @@ static int outcome_products_trimol_reaction_random(
             }
           } else if (only_sm_1_sm_2_outside) {
             int cond_1 = 0, cond_2 = 0;
-            cond_1 = wall_belongs_to_any_region_in_region_list(
+            cond_1 = wall_belongs_to_any_region(
                 tile_grid->surface, rlp_head_obj_1);
-            cond_2 = wall_belongs_to_any_region_in_region_list(
+            cond_2 = wall_belongs_to_any_region(
                 tile_grid->surface, rlp_head_obj_2);
 
             if (cond_1 || cond_2) {
@@ -1472,9 +1512,9 @@ static int outcome_products_trimol_reaction_random(
             }
           } else if (only_sm_1_grid_3_inside) {
             int cond_1 = 0, cond_2 = 0;
-            cond_1 = !(wall_belongs_to_all_regions_in_region_list(
+            cond_1 = !(wall_belongs_to_all_regions(
                           tile_grid->surface, rlp_head_wall_1));
-            cond_2 = !(wall_belongs_to_all_regions_in_region_list(
+            cond_2 = !(wall_belongs_to_all_regions(
                           tile_grid->surface, rlp_head_wall_3));
 
             if (cond_1 || cond_2) {
@@ -1484,9 +1524,9 @@ static int outcome_products_trimol_reaction_random(
             }
           } else if (only_sm_1_inside_grid_3_outside) {
             int cond_1 = 0, cond_2 = 0;
-            cond_1 = !(wall_belongs_to_all_regions_in_region_list(
+            cond_1 = !(wall_belongs_to_all_regions(
                           tile_grid->surface, rlp_head_wall_1));
-            cond_2 = wall_belongs_to_any_region_in_region_list(
+            cond_2 = wall_belongs_to_any_region(
                 tile_grid->surface, rlp_head_obj_3);
 
             if (cond_1 || cond_2) {
@@ -1496,9 +1536,9 @@ static int outcome_products_trimol_reaction_random(
             }
           } else if (only_sm_1_outside_grid_3_inside) {
             int cond_1 = 0, cond_2 = 0;
-            cond_1 = wall_belongs_to_any_region_in_region_list(
+            cond_1 = wall_belongs_to_any_region(
                 tile_grid->surface, rlp_head_obj_1);
-            cond_2 = !(wall_belongs_to_all_regions_in_region_list(
+            cond_2 = !(wall_belongs_to_all_regions(
                           tile_grid->surface, rlp_head_wall_3));
 
             if (cond_1 || cond_2) {
@@ -1508,9 +1548,9 @@ static int outcome_products_trimol_reaction_random(
             }
           } else if (only_sm_1_grid_3_outside) {
             int cond_1 = 0, cond_2 = 0;
-            cond_1 = wall_belongs_to_any_region_in_region_list(
+            cond_1 = wall_belongs_to_any_region(
                 tile_grid->surface, rlp_head_obj_1);
-            cond_2 = wall_belongs_to_any_region_in_region_list(
+            cond_2 = wall_belongs_to_any_region(
                 tile_grid->surface, rlp_head_obj_3);
 
             if (cond_1 || cond_2) {
@@ -1520,9 +1560,9 @@ static int outcome_products_trimol_reaction_random(
             }
           } else if (only_sm_2_grid_3_inside) {
             int cond_1 = 0, cond_2 = 0;
-            cond_1 = !(wall_belongs_to_all_regions_in_region_list(
+            cond_1 = !(wall_belongs_to_all_regions(
                           tile_grid->surface, rlp_head_wall_2));
-            cond_2 = !(wall_belongs_to_all_regions_in_region_list(
+            cond_2 = !(wall_belongs_to_all_regions(
                           tile_grid->surface, rlp_head_wall_3));
 
             if (cond_1 || cond_2) {
@@ -1532,9 +1572,9 @@ static int outcome_products_trimol_reaction_random(
             }
           } else if (only_sm_2_inside_grid_3_outside) {
             int cond_1 = 0, cond_2 = 0;
-            cond_1 = !(wall_belongs_to_all_regions_in_region_list(
+            cond_1 = !(wall_belongs_to_all_regions(
                           tile_grid->surface, rlp_head_wall_2));
-            cond_2 = wall_belongs_to_any_region_in_region_list(
+            cond_2 = wall_belongs_to_any_region(
                 tile_grid->surface, rlp_head_obj_3);
 
             if (cond_1 || cond_2) {
@@ -1544,9 +1584,9 @@ static int outcome_products_trimol_reaction_random(
             }
           } else if (only_sm_2_outside_grid_3_inside) {
             int cond_1 = 0, cond_2 = 0;
-            cond_1 = wall_belongs_to_any_region_in_region_list(
+            cond_1 = wall_belongs_to_any_region(
                 tile_grid->surface, rlp_head_obj_2);
-            cond_2 = !(wall_belongs_to_all_regions_in_region_list(
+            cond_2 = !(wall_belongs_to_all_regions(
                           tile_grid->surface, rlp_head_wall_3));
 
             if (cond_1 || cond_2) {
@@ -1556,9 +1596,9 @@ static int outcome_products_trimol_reaction_random(
             }
           } else if (only_sm_2_grid_3_outside) {
             int cond_1 = 0, cond_2 = 0;
-            cond_1 = wall_belongs_to_any_region_in_region_list(
+            cond_1 = wall_belongs_to_any_region(
                 tile_grid->surface, rlp_head_obj_2);
-            cond_2 = wall_belongs_to_any_region_in_region_list(
+            cond_2 = wall_belongs_to_any_region(
                 tile_grid->surface, rlp_head_obj_3);
 
             if (cond_1 || cond_2) {
@@ -1567,42 +1607,42 @@ static int outcome_products_trimol_reaction_random(
               continue;
             }
           } else if (only_sm_1_inside) {
-            if (!wall_belongs_to_all_regions_in_region_list(tile_grid->surface,
+            if (!wall_belongs_to_all_regions(tile_grid->surface,
                                                             rlp_head_wall_1)) {
               uncheck_vacant_tile(tile_vacant_nbr_head, rnd_num);
               num_attempts++;
               continue;
             }
           } else if (only_sm_1_outside) {
-            if (wall_belongs_to_any_region_in_region_list(tile_grid->surface,
+            if (wall_belongs_to_any_region(tile_grid->surface,
                                                           rlp_head_obj_1)) {
               uncheck_vacant_tile(tile_vacant_nbr_head, rnd_num);
               num_attempts++;
               continue;
             }
           } else if (only_sm_2_inside) {
-            if (!wall_belongs_to_all_regions_in_region_list(tile_grid->surface,
+            if (!wall_belongs_to_all_regions(tile_grid->surface,
                                                             rlp_head_wall_2)) {
               uncheck_vacant_tile(tile_vacant_nbr_head, rnd_num);
               num_attempts++;
               continue;
             }
           } else if (only_sm_2_outside) {
-            if (wall_belongs_to_any_region_in_region_list(tile_grid->surface,
+            if (wall_belongs_to_any_region(tile_grid->surface,
                                                           rlp_head_obj_2)) {
               uncheck_vacant_tile(tile_vacant_nbr_head, rnd_num);
               num_attempts++;
               continue;
             }
           } else if (only_grid_3_inside) {
-            if (!wall_belongs_to_all_regions_in_region_list(tile_grid->surface,
+            if (!wall_belongs_to_all_regions(tile_grid->surface,
                                                             rlp_head_wall_3)) {
               uncheck_vacant_tile(tile_vacant_nbr_head, rnd_num);
               num_attempts++;
               continue;
             }
           } else if (only_grid_3_outside) {
-            if (wall_belongs_to_any_region_in_region_list(tile_grid->surface,
+            if (wall_belongs_to_any_region(tile_grid->surface,
                                                           rlp_head_obj_3)) {
               uncheck_vacant_tile(tile_vacant_nbr_head, rnd_num);
               num_attempts++;
@@ -1738,6 +1778,8 @@ static int outcome_products_trimol_reaction_random(
     delete_tile_neighbor_list(tile_nbr_head);
   if (tile_vacant_nbr_head != NULL)
     delete_tile_neighbor_list(tile_vacant_nbr_head);
+  free_restricted_regions(rlp_head_wall_1, rlp_head_wall_2, rlp_head_wall_3,
+                          rlp_head_obj_1, rlp_head_obj_2, rlp_head_obj_3);
 
   return cross_wall ? RX_FLIP : RX_A_OK;
 }
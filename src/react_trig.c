@@ -1006,7 +1006,10 @@ int find_surface_mol_reactions_with_surf_classes(
  * compute_lifetime
  *
  * Determine time of next unimolecular reaction; may need to check before the
- * next rate change for time dependent rates.
+ * next rate change for time dependent rates. A lifetime which would run past
+ * the next change (for scheduled changes, the iteration where the rate change
+ * scheduler applies it) is cut short there, so the molecule picks a new
+ * lifetime with the new rates.
  *
  * In: state: system state
  *     am: pointer to abstract molecule to be tested for unimolecular reaction
@@ -1020,7 +1023,8 @@ void compute_lifetime(struct volume *state,
 
     am->t2 = timeof_unimolecular(r, am, state->rng);
     if (r->prob_t != NULL) {
-      tt = r->prob_t->time;
+      tt = r->rate_changes_scheduled ? rate_change_iteration(r->prob_t->time)
+                                     : r->prob_t->time;
     }
 
     if (am->t + am->t2 > tt) {
@@ -1111,7 +1115,7 @@ struct rxn *pick_unimolecular_reaction(struct volume *state,
   struct rxn *r = trigger_unimolecular(state->reaction_hash, state->rx_hashsize,
                                        am->properties->hashval, am);
 
-  if ((r != NULL) && (r->prob_t != NULL)) {
+  if ((r != NULL) && (r->prob_t != NULL) && !r->rate_changes_scheduled) {
     update_probs(state, r, (am->t + am->t2) * (1.0 + EPS_C));
   }
 
@@ -1123,7 +1127,8 @@ struct rxn *pick_unimolecular_reaction(struct volume *state,
             state->all_volume_mols, state->all_surface_mols, am, NULL,
             matching_rxns);
     for (int jj = 0; jj < num_matching_rxns; jj++) {
-      if ((matching_rxns[jj] != NULL) && (matching_rxns[jj]->prob_t != NULL)) {
+      if ((matching_rxns[jj] != NULL) && (matching_rxns[jj]->prob_t != NULL) &&
+          !matching_rxns[jj]->rate_changes_scheduled) {
         update_probs(
             state, matching_rxns[jj], (am->t + am->t2) * (1.0 + EPS_C));
       }
@@ -649,3 +649,123 @@ void delete_scheduler(struct schedule_helper *sh) {
     free(sh);
   }
 }
+
+/*************************************************************************
+heap_sift_down:
+  In: heap that we are using
+      index of an entry which may be later than its children
+  Out: No return value.  The entry is moved down until the heap property
+       holds again.
+*************************************************************************/
+
+static void heap_sift_down(struct time_heap *h, int i) {
+  struct heap_entry e = h->entries[i];
+  for (;;) {
+    int child = 2 * i + 1;
+    if (child >= h->count)
+      break;
+    if (child + 1 < h->count && h->entries[child + 1].t < h->entries[child].t)
+      child++;
+    if (!(h->entries[child].t < e.t))
+      break;
+    h->entries[i] = h->entries[child];
+    i = child;
+  }
+  h->entries[i] = e;
+}
+
+/*************************************************************************
+heap_insert:
+  In: heap that we are using
+      item to add
+      time at which the item is due
+  Out: 0 on success, 1 on memory allocation error.  The item is added to the
+       heap.
+*************************************************************************/
+
+int heap_insert(struct time_heap *h, void *data, double t) {
+  if (h->count == h->max_count) {
+    int new_max = (h->max_count == 0) ? 64 : 2 * h->max_count;
+    struct heap_entry *new_entries = (struct heap_entry *)realloc(
+        h->entries, new_max * sizeof(struct heap_entry));
+    if (new_entries == NULL)
+      return 1;
+    h->entries = new_entries;
+    h->max_count = new_max;
+  }
+
+  int i = h->count++;
+  while (i > 0) {
+    int parent = (i - 1) / 2;
+    if (!(t < h->entries[parent].t))
+      break;
+    h->entries[i] = h->entries[parent];
+    i = parent;
+  }
+  h->entries[i].t = t;
+  h->entries[i].data = data;
+  return 0;
+}
+
+/*************************************************************************
+heap_pop_before:
+  In: heap that we are using
+      time limit
+      pointer to store the time of the item (may be NULL)
+  Out: The earliest item if it is due before t_limit, NULL otherwise.  The
+       item returned is removed from the heap.
+*************************************************************************/
+
+void *heap_pop_before(struct time_heap *h, double t_limit, double *t) {
+  if (h->count == 0 || !(h->entries[0].t < t_limit))
+    return NULL;
+
+  void *data = h->entries[0].data;
+  if (t != NULL)
+    *t = h->entries[0].t;
+  h->entries[0] = h->entries[--h->count];
+  if (h->count > 0)
+    heap_sift_down(h, 0);
+  return data;
+}
+
+/*************************************************************************
+heap_cleanup:
+  In: heap that we are using
+      function that returns 1 if an item is defunct, 0 otherwise
+      function that disposes of a defunct item
+  Out: Number of defunct items removed from the heap and disposed of.
+*************************************************************************/
+
+int heap_cleanup(struct time_heap *h, int (*is_defunct)(void *data),
+                 void (*dispose)(void *data)) {
+  int n_kept = 0;
+  for (int i = 0; i < h->count; i++) {
+    if ((*is_defunct)(h->entries[i].data))
+      (*dispose)(h->entries[i].data);
+    else
+      h->entries[n_kept++] = h->entries[i];
+  }
+
+  int n_removed = h->count - n_kept;
+  h->count = n_kept;
+  if (n_removed > 0) {
+    for (int i = h->count / 2 - 1; i >= 0; i--)
+      heap_sift_down(h, i);
+  }
+  return n_removed;
+}
+
+/*************************************************************************
+delete_heap:
+  In: heap that we are using
+  Out: No return value.  The heap's storage is freed and the heap is left
+       empty.
+*************************************************************************/
+
+void delete_heap(struct time_heap *h) {
+  free(h->entries);
+  h->entries = NULL;
+  h->count = 0;
+  h->max_count = 0;
+}
@@ -83,3 +83,27 @@ schedule_cleanup(struct schedule_helper *sh,
                  int (*is_defunct)(struct abstract_element *e));
 
 void delete_scheduler(struct schedule_helper *sh);
+
+/* Entry of a time_heap; the time is stored next to the item so that sifting
+ * never touches the items themselves */
+struct heap_entry {
+  double t;
+  void *data;
+};
+
+/* Binary min-heap of items ordered by time, for items scheduled far apart
+ * in time that should not be visited until they are due */
+struct time_heap {
+  struct heap_entry *entries;
+  int count;
+  int max_count;
+};
+
+int heap_insert(struct time_heap *h, void *data, double t);
+
+void *heap_pop_before(struct time_heap *h, double t_limit, double *t);
+
+int heap_cleanup(struct time_heap *h, int (*is_defunct)(void *data),
+                 void (*dispose)(void *data));
+
+void delete_heap(struct time_heap *h);
@@ -0,0 +1,339 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2006-2017 by
+ * The Salk Institute for Biological Studies and
+ * Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ *
+******************************************************************************/
+
+/**************************************************************************\
+** File: startup_image.c
+**
+** Purpose: Writes and reads MCell startup images. A startup image holds the
+**          results of the geometry initialization steps which only depend on
+**          the model (waypoint placement and the check for overlapped
+**          walls), so that runs of the same model with different seeds can
+**          skip them.
+**
+*/
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "mcell_structs.h"
+#include "logging.h"
+#include "mem_util.h"
+#include "count_util.h"
+#include "version_info.h"
+#include "startup_image.h"
+
+/* Startup image format version */
+#define STARTUP_IMAGE_API 1
+
+/* Marker used to detect images written with a different byte order */
+#define STARTUP_IMAGE_BYTE_ORDER 0x01020304u
+
+static const char STARTUP_IMAGE_MAGIC[8] = "MCELLSI";
+
+/* Contents flags */
+#define IMAGE_HAS_WAYPOINTS 1
+#define IMAGE_WALLS_CHECKED 2
+
+/* 64-bit FNV-1a over a block of memory */
+static unsigned long long hash_bytes(unsigned long long hash, const void *data,
+                                     size_t len) {
+  const unsigned char *c = (const unsigned char *)data;
+  for (size_t i = 0; i < len; i++) {
+    hash ^= c[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+/***************************************************************************
+compute_geometry_signature:
+  In:  world: simulation state, with partitions, walls and regions initialized
+  Out: A hash of the partitions, of the walls in every subvolume and the
+       counted regions each wall belongs to, and of the names of the counted
+       regions. Two worlds with the same signature have the same waypoints.
+***************************************************************************/
+unsigned long long compute_geometry_signature(struct volume *world) {
+  unsigned long long hash = 14695981039346656037ULL;
+
+  hash = hash_bytes(hash, &world->nx_parts, sizeof(world->nx_parts));
+  hash = hash_bytes(hash, &world->ny_parts, sizeof(world->ny_parts));
+  hash = hash_bytes(hash, &world->nz_parts, sizeof(world->nz_parts));
+  hash = hash_bytes(hash, world->x_partitions,
+                    world->nx_parts * sizeof(double));
+  hash = hash_bytes(hash, world->y_partitions,
+                    world->ny_parts * sizeof(double));
+  hash = hash_bytes(hash, world->z_partitions,
+                    world->nz_parts * sizeof(double));
+
+  for (int i = 0; i < world->n_subvols; i++) {
+    for (struct wall_list *wl = world->subvol[i].wall_head; wl != NULL;
+         wl = wl->next) {
+      struct wall *w = wl->this_wall;
+      for (int k = 0; k < 3; k++)
+        hash = hash_bytes(hash, w->vert[k], sizeof(struct vector3));
+
+      /* The region list is sorted by address, so combine its members in an
+       * order-independent way */
+      unsigned long long regions = 0;
+      for (struct region_list *rl = w->counting_regions; rl != NULL;
+           rl = rl->next) {
+        regions += hash_bytes(14695981039346656037ULL,
+                              &rl->reg->counting_index, sizeof(int));
+      }
+      hash = hash_bytes(hash, &regions, sizeof(regions));
+    }
+    hash = hash_bytes(hash, &i, sizeof(i));
+  }
+
+  for (int i = 0; i < world->n_counting_regions; i++) {
+    const char *name = world->counting_region_index[i]->sym->name;
+    hash = hash_bytes(hash, name, strlen(name) + 1);
+  }
+
+  return hash;
+}
+
+/***************************************************************************
+write_region_indices:
+  In:  fs: file to write to
+       rl: a list of counted regions
+  Out: 0 on success, 1 on write failure. The number of regions and their
+       counting indices are written.
+***************************************************************************/
+static int write_region_indices(FILE *fs, struct region_list *rl) {
+  int n_regions = 0;
+  for (struct region_list *r = rl; r != NULL; r = r->next)
+    n_regions++;
+  if (fwrite(&n_regions, sizeof(n_regions), 1, fs) != 1)
+    return 1;
+  for (; rl != NULL; rl = rl->next) {
+    if (fwrite(&rl->reg->counting_index, sizeof(int), 1, fs) != 1)
+      return 1;
+  }
+  return 0;
+}
+
+/***************************************************************************
+read_region_indices:
+  In:  world: simulation state
+       fs: file to read from
+       regl: memory helper for the list entries
+       rlp: the list of regions read is stored here
+  Out: 0 on success, 1 if the file is truncated or names a region that does
+       not exist.
+***************************************************************************/
+static int read_region_indices(struct volume *world, FILE *fs,
+                               struct mem_helper *regl,
+                               struct region_list **rlp) {
+  int n_regions;
+  if (fread(&n_regions, sizeof(n_regions), 1, fs) != 1 || n_regions < 0)
+    return 1;
+
+  /* Keep the order in which the regions were written */
+  struct region_list **tail = rlp;
+  *rlp = NULL;
+  for (int i = 0; i < n_regions; i++) {
+    int idx;
+    if (fread(&idx, sizeof(idx), 1, fs) != 1 || idx < 0 ||
+        idx >= world->n_counting_regions)
+      return 1;
+    struct region_list *rl =
+        (struct region_list *)CHECKED_MEM_GET(regl, "region list entry");
+    rl->reg = world->counting_region_index[idx];
+    rl->next = NULL;
+    *tail = rl;
+    tail = &rl->next;
+  }
+  return 0;
+}
+
+/***************************************************************************
+read_startup_image:
+  In:  world: simulation state, with partitions, walls and regions initialized
+       filename: name of the startup image
+       loaded: set to 1 if the image was used, 0 otherwise
+  Out: 0 on success, 1 if a matching image could not be read completely.
+       A missing image, or one written by a different MCell version or for a
+       different geometry, is ignored and *loaded is set to 0. Otherwise the
+       waypoints are restored from the image.
+***************************************************************************/
+int read_startup_image(struct volume *world, char const *filename,
+                       int *loaded) {
+  *loaded = 0;
+  FILE *fs = fopen(filename, "rb");
+  if (fs == NULL)
+    return 0;
+
+  char magic[sizeof(STARTUP_IMAGE_MAGIC)];
+  unsigned int api, byte_order;
+  int version_len;
+  if (fread(magic, sizeof(magic), 1, fs) != 1 ||
+      memcmp(magic, STARTUP_IMAGE_MAGIC, sizeof(magic)) != 0 ||
+      fread(&api, sizeof(api), 1, fs) != 1 || api != STARTUP_IMAGE_API ||
+      fread(&byte_order, sizeof(byte_order), 1, fs) != 1 ||
+      byte_order != STARTUP_IMAGE_BYTE_ORDER ||
+      fread(&version_len, sizeof(version_len), 1, fs) != 1 ||
+      version_len != (int)strlen(mcell_version)) {
+    mcell_warn("Ignoring startup image '%s' written in a different format.",
+               filename);
+    fclose(fs);
+    return 0;
+  }
+
+  char *version = CHECKED_MALLOC_ARRAY(char, version_len + 1, "version");
+  if (fread(version, 1, version_len, fs) != (size_t)version_len) {
+    free(version);
+    fclose(fs);
+    return 0;
+  }
+  version[version_len] = '\0';
+  int same_version = (strcmp(version, mcell_version) == 0);
+  free(version);
+  if (!same_version) {
+    mcell_warn("Ignoring startup image '%s' written by a different version "
+               "of MCell.", filename);
+    fclose(fs);
+    return 0;
+  }
+
+  unsigned long long signature;
+  int flags, n_waypoints;
+  if (fread(&signature, sizeof(signature), 1, fs) != 1 ||
+      fread(&flags, sizeof(flags), 1, fs) != 1 ||
+      fread(&n_waypoints, sizeof(n_waypoints), 1, fs) != 1) {
+    fclose(fs);
+    return 0;
+  }
+  if (signature != compute_geometry_signature(world)) {
+    mcell_warn("Ignoring startup image '%s' made for a different geometry.",
+               filename);
+    fclose(fs);
+    return 0;
+  }
+  if ((world->with_checks_flag && !(flags & IMAGE_WALLS_CHECKED)) ||
+      (world->place_waypoints_flag && !(flags & IMAGE_HAS_WAYPOINTS)) ||
+      (world->place_waypoints_flag && n_waypoints != world->n_subvols)) {
+    fclose(fs);
+    return 0;
+  }
+
+  if (world->place_waypoints_flag) {
+    if (world->waypoints != NULL)
+      free(world->waypoints);
+    world->n_waypoints = n_waypoints;
+    world->waypoints =
+        CHECKED_MALLOC_ARRAY(struct waypoint, n_waypoints, "waypoints");
+    memset(world->waypoints, 0, n_waypoints * sizeof(struct waypoint));
+
+    for (int i = 0; i < n_waypoints; i++) {
+      struct waypoint *wp = &world->waypoints[i];
+      struct mem_helper *regl = world->subvol[i].local_storage->regl;
+      if (fread(&wp->loc, sizeof(struct vector3), 1, fs) != 1 ||
+          read_region_indices(world, fs, regl, &wp->regions) ||
+          read_region_indices(world, fs, regl, &wp->antiregions)) {
+        mcell_error("Startup image '%s' is truncated or corrupt.", filename);
+        fclose(fs);
+        return 1;
+      }
+    }
+
+    if (set_waypoint_region_bits(world)) {
+      fclose(fs);
+      return 1;
+    }
+  }
+
+  fclose(fs);
+  *loaded = 1;
+  return 0;
+}
+
+/***************************************************************************
+write_startup_image:
+  In:  world: simulation state, after the waypoints were placed and the walls
+         were checked
+       filename: name of the startup image
+  Out: 0 on success, 1 on failure. The MCell version, the geometry signature
+       and the waypoints are written to the image. The image is written to a
+       temporary file first and renamed over filename, so that runs sharing
+       the image never read a partially written one.
+***************************************************************************/
+int write_startup_image(struct volume *world, char const *filename) {
+  char *tmp_filename = CHECKED_SPRINTF("%s.tmp.%d", filename, getpid());
+  FILE *fs = fopen(tmp_filename, "wb");
+  if (fs == NULL) {
+    mcell_error("Cannot write startup image '%s'.", tmp_filename);
+    free(tmp_filename);
+    return 1;
+  }
+
+  unsigned int api = STARTUP_IMAGE_API;
+  unsigned int byte_order = STARTUP_IMAGE_BYTE_ORDER;
+  int version_len = (int)strlen(mcell_version);
+  unsigned long long signature = compute_geometry_signature(world);
+  int flags = 0;
+  if (world->place_waypoints_flag)
+    flags |= IMAGE_HAS_WAYPOINTS;
+  if (world->with_checks_flag)
+    flags |= IMAGE_WALLS_CHECKED;
+  int n_waypoints = world->place_waypoints_flag ? world->n_waypoints : 0;
+
+  int failed =
+      fwrite(STARTUP_IMAGE_MAGIC, sizeof(STARTUP_IMAGE_MAGIC), 1, fs) != 1 ||
+      fwrite(&api, sizeof(api), 1, fs) != 1 ||
+      fwrite(&byte_order, sizeof(byte_order), 1, fs) != 1 ||
+      fwrite(&version_len, sizeof(version_len), 1, fs) != 1 ||
+      fwrite(mcell_version, 1, version_len, fs) != (size_t)version_len ||
+      fwrite(&signature, sizeof(signature), 1, fs) != 1 ||
+      fwrite(&flags, sizeof(flags), 1, fs) != 1 ||
+      fwrite(&n_waypoints, sizeof(n_waypoints), 1, fs) != 1;
+
+  for (int i = 0; !failed && i < n_waypoints; i++) {
+    struct waypoint *wp = &world->waypoints[i];
+    failed = fwrite(&wp->loc, sizeof(struct vector3), 1, fs) != 1 ||
+             write_region_indices(fs, wp->regions) ||
+             write_region_indices(fs, wp->antiregions);
+  }
+
+  if (fclose(fs) != 0)
+    failed = 1;
+  if (failed) {
+    mcell_error("Error while writing startup image '%s'.", tmp_filename);
+    remove(tmp_filename);
+    free(tmp_filename);
+    return 1;
+  }
+  if (rename(tmp_filename, filename) != 0) {
+    mcell_perror_nodie(errno, "Cannot rename '%s' to '%s'", tmp_filename, filename);
+    remove(tmp_filename);
+    free(tmp_filename);
+    return 1;
+  }
+  free(tmp_filename);
+  return 0;
+}
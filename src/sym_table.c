@@ -325,6 +325,7 @@ struct rxn *new_reaction(void) {
   rxnp->n_occurred = 0;
   rxnp->n_skipped = 0;
   rxnp->prob_t = NULL;
+  rxnp->rate_changes_scheduled = 0;
   rxnp->pathway_head = NULL;
   rxnp->info = NULL;
   return rxnp;
@@ -368,6 +369,8 @@ struct region *new_region(void) {
   rp->volume = 0.0;
   rp->boundaries = NULL;
   rp->region_has_all_elements = 0;
+  rp->counting_index = -1;
+  rp->border_index = -1;
   return rp;
 }
 
@@ -39,6 +39,26 @@
 #include "util.h"
 #include "mcell_structs.h"
 
+/* Hardware population count and trailing-zero count for bit arrays */
+#if defined(__GNUC__) || defined(__clang__)
+#define POPCOUNT(x) __builtin_popcount(x)
+#define CTZ(x) __builtin_ctz(x)
+#else
+static int POPCOUNT(unsigned int x) {
+  x = x - ((x >> 1) & 0x55555555u);
+  x = (x & 0x33333333u) + ((x >> 2) & 0x33333333u);
+  return (int)((((x + (x >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+}
+static int CTZ(unsigned int x) {
+  int n = 0;
+  while ((x & 1u) == 0) {
+    x >>= 1;
+    n++;
+  }
+  return n;
+}
+#endif
+
 /*******************************************************************
 new_bit_array: mallocs an array of the desired number of bits
 
@@ -151,59 +171,29 @@ set_bit_range: set many bits to a value in a bit array
     Nothing
 *******************************************************************/
 void set_bit_range(struct bit_array *ba, int idx1, int idx2, int value) {
-  int *data = &(ba->nints);
-  data++; /* At start of bit array memory */
+  unsigned int *data = (unsigned int *)(&(ba->nints) + 1);
 
   int ofs1 = idx1 & (8 * sizeof(int) - 1);
   int ofs2 = idx2 & (8 * sizeof(int) - 1);
   idx1 = idx1 / (8 * sizeof(int));
   idx2 = idx2 / (8 * sizeof(int));
 
-  unsigned int mask, cmask;
-  if (idx1 == idx2) {
-    mask = 0;
-    for (int i = ofs1; i <= ofs2; i++) {
-      mask |= (1u << i);
-    }
-    cmask = ~mask;
+  /* masks covering bits [ofs1, 31] and [0, ofs2] of the end words */
+  unsigned int mask1 = ~0u << ofs1;
+  unsigned int mask2 = ~0u >> (8 * sizeof(int) - 1 - ofs2);
 
-    if (value) {
-      data[idx1] = (data[idx1] & cmask) | mask;
-    } else {
-      data[idx1] = data[idx1] & cmask;
-    }
-  } else {
-    if (value) {
-      value = ~0;
-    } else {
-      value = 0;
-    }
-    for (int i = idx1 + 1; i < idx2; i++) {
-      data[i] = value;
-    }
-
-    mask = 0;
-    for (unsigned int i = ofs1; i < 8 * sizeof(int); i++) {
-      mask |= (1u << i);
-    }
-    cmask = ~mask;
-    if (value) {
-      data[idx1] = (data[idx1] & cmask) | mask;
-    } else {
-      data[idx1] = data[idx1] & cmask;
-    }
+  if (idx1 == idx2) {
+    mask1 &= mask2;
+    data[idx1] = value ? (data[idx1] | mask1) : (data[idx1] & ~mask1);
+    return;
+  }
 
-    mask = 0;
-    for (int i = 0; i <= ofs2; i++) {
-      mask |= (1u << i);
-    }
-    cmask = ~mask;
-    if (value) {
-      data[idx2] = (data[idx2] & cmask) | mask;
-    } else {
-      data[idx2] = data[idx2] & cmask;
-    }
+  unsigned int fill = value ? ~0u : 0u;
+  for (int i = idx1 + 1; i < idx2; i++) {
+    data[i] = fill;
   }
+  data[idx1] = value ? (data[idx1] | mask1) : (data[idx1] & ~mask1);
+  data[idx2] = value ? (data[idx2] | mask2) : (data[idx2] & ~mask2);
 }
 
 /*******************************************************************
@@ -304,44 +294,117 @@ count_bits: count how many bits are set in a bit array
     int containing number of nonzero bits
 **********************************************************************/
 int count_bits(struct bit_array *ba) {
-  static const int cb_table[256] = {
-    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 1, 2, 2, 3, 2, 3, 3, 4,
-    2, 3, 3, 4, 3, 4, 4, 5, 1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
-    2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 1, 2, 2, 3, 2, 3, 3, 4,
-    2, 3, 3, 4, 3, 4, 4, 5, 2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
-    2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 3, 4, 4, 5, 4, 5, 5, 6,
-    4, 5, 5, 6, 5, 6, 6, 7, 1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
-    2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 2, 3, 3, 4, 3, 4, 4, 5,
-    3, 4, 4, 5, 4, 5, 5, 6, 3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
-    2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 3, 4, 4, 5, 4, 5, 5, 6,
-    4, 5, 5, 6, 5, 6, 6, 7, 3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
-    4, 5, 5, 6, 5, 6, 6, 7, 5, 6, 6, 7, 6, 7, 7, 8
-  };
-
-  int *dd = &(ba->nints);
-  dd++;
-  unsigned char *d = (unsigned char *)dd;
-
-  int n = (ba->nints - 1) * sizeof(int);
+  unsigned int *data = (unsigned int *)(&(ba->nints) + 1);
+  if (ba->nints == 0)
+    return 0;
+
   int cnt = 0;
+  for (int i = 0; i < ba->nints - 1; i++) {
+    cnt += POPCOUNT(data[i]);
+  }
+
+  /* ignore the unused tail of the last word */
+  int n = ba->nbits - (ba->nints - 1) * 8 * sizeof(int);
+  unsigned int last = data[ba->nints - 1];
+  if (n < (int)(8 * sizeof(int)))
+    last &= ~(~0u << n);
+  return cnt + POPCOUNT(last);
+}
+
+/**********************************************************************
+bit_array_intersects: check whether two bit arrays share a set bit
+
+ In:
+    ba: pointer to a bit_array struct
+    bb: pointer to another bit_array struct of the same size
+
+ Out:
+    1 if some bit is set in both arrays, 0 otherwise
+**********************************************************************/
+int bit_array_intersects(struct bit_array *ba, struct bit_array *bb) {
+  unsigned int *da = (unsigned int *)(&(ba->nints) + 1);
+  unsigned int *db = (unsigned int *)(&(bb->nints) + 1);
+
+  int n = (ba->nints < bb->nints) ? ba->nints : bb->nints;
   for (int i = 0; i < n; i++) {
-    cnt += cb_table[(*d++)];
+    if (da[i] & db[i])
+      return 1;
   }
+  return 0;
+}
+
+/**********************************************************************
+bit_array_contains: check whether one bit array is a superset of another
 
-  n = ba->nbits - n * 8;
-  if (n == 0)
-    return cnt;
+ In:
+    ba: pointer to a bit_array struct
+    bb: pointer to another bit_array struct of the same size
+
+ Out:
+    1 if every bit set in bb is also set in ba, 0 otherwise
+**********************************************************************/
+int bit_array_contains(struct bit_array *ba, struct bit_array *bb) {
+  unsigned int *da = (unsigned int *)(&(ba->nints) + 1);
+  unsigned int *db = (unsigned int *)(&(bb->nints) + 1);
 
-  int j = dd[ba->nints - 1];
-  while (n >= 8) {
-    cnt += cb_table[j & 0xFF];
-    n -= 8;
-    j >>= 8;
+  int n = (ba->nints < bb->nints) ? ba->nints : bb->nints;
+  for (int i = 0; i < n; i++) {
+    if (db[i] & ~da[i])
+      return 0;
   }
-  if (n > 0) {
-    cnt += cb_table[j & 0xFF] - cb_table[(j & 0xFF) >> n];
+  for (int i = n; i < bb->nints; i++) {
+    if (db[i])
+      return 0;
   }
-  return cnt;
+  return 1;
+}
+
+/**********************************************************************
+bit_array_equal: compare two bit arrays
+
+ In:
+    ba: pointer to a bit_array struct
+    bb: pointer to another bit_array struct
+
+ Out:
+    1 if both arrays have the same size and the same bits set, 0 otherwise
+**********************************************************************/
+int bit_array_equal(struct bit_array *ba, struct bit_array *bb) {
+  if (ba->nbits != bb->nbits)
+    return 0;
+
+  return memcmp(&(ba->nints) + 1, &(bb->nints) + 1,
+                sizeof(int) * ba->nints) == 0;
+}
+
+/**********************************************************************
+next_set_bit: find the next set bit in a bit array
+
+ In:
+    ba: pointer to a bit_array struct
+    idx: index of the first bit to examine
+
+ Out:
+    index of the first set bit at or after idx, or -1 if there is none.
+    Whole zero words are skipped, so iterating over a sparse array with
+    for (i = next_set_bit(ba, 0); i >= 0; i = next_set_bit(ba, i + 1))
+    only touches the set bits.
+**********************************************************************/
+int next_set_bit(struct bit_array *ba, int idx) {
+  unsigned int *data = (unsigned int *)(&(ba->nints) + 1);
+  if (idx >= ba->nbits)
+    return -1;
+
+  int word = idx / (8 * sizeof(int));
+  unsigned int bits = data[word] & (~0u << (idx & (8 * sizeof(int) - 1)));
+  while (bits == 0) {
+    if (++word >= ba->nints)
+      return -1;
+    bits = data[word];
+  }
+
+  idx = word * 8 * sizeof(int) + CTZ(bits);
+  return (idx < ba->nbits) ? idx : -1;
 }
 
 /**********************************************************************
@@ -1101,6 +1164,57 @@ int poisson_dist(double lambda, double p) {
   return -1;
 }
 
+/*************************************************************************
+binomial_dist:
+  In: number of trials
+      probability of success of each trial
+      random number distributed uniformly between 0 and 1
+  Out: integer sampled from the binomial distribution.
+  Note: Like poisson_dist, this works its way outwards from the peak of the
+        PDF rather than sampling the CDF.
+*************************************************************************/
+int binomial_dist(int n, double prob, double p) {
+  if (n <= 0 || prob <= 0)
+    return 0;
+  if (prob >= 1)
+    return n;
+
+  int i = (int)((n + 1) * prob); /* Highest probability bin */
+  if (i > n)
+    i = n;
+  double q = 1.0 - prob;
+  double pctr = exp(lgamma(n + 1) - lgamma(i + 1) - lgamma(n - i + 1) +
+                    i * log(prob) + (n - i) * log(q));
+
+  if (p < pctr)
+    return i;
+
+  int lo = i, hi = i;
+  double plo = pctr, phi = pctr;
+  double ratio = prob / q;
+
+  p -= pctr;
+  while (lo > 0 || hi < n) {
+    if (lo > 0) {
+      plo *= lo / ((n - lo + 1) * ratio); /* Recursive formula for lo - 1 */
+      lo--;
+      if (p < plo)
+        return lo;
+      p -= plo;
+    }
+    if (hi < n) {
+      phi *= (n - hi) * ratio / (hi + 1); /* Recursive formula for hi + 1 */
+      hi++;
+      if (p < phi)
+        return hi;
+      p -= phi;
+    }
+  }
+
+  /* Only reached through roundoff in the tails */
+  return i;
+}
+
 /*************************************************************************
 byte_swap:
   In: array of bytes to be swapped
@@ -63,6 +63,10 @@ void set_bit_range(struct bit_array *ba, int idx1, int idx2, int value);
 void set_all_bits(struct bit_array *ba, int value);
 void bit_operation(struct bit_array *ba, struct bit_array *bb, char op);
 int count_bits(struct bit_array *ba);
+int bit_array_intersects(struct bit_array *ba, struct bit_array *bb);
+int bit_array_contains(struct bit_array *ba, struct bit_array *bb);
+int bit_array_equal(struct bit_array *ba, struct bit_array *bb);
+int next_set_bit(struct bit_array *ba, int idx);
 void free_bit_array(struct bit_array *ba);
 
 int bisect(double *list, int n, double val);
@@ -104,6 +108,8 @@ double erfcinv(double v);
 
 int poisson_dist(double lambda, double p);
 
+int binomial_dist(int n, double prob, double p);
+
 void byte_swap(void *data, int size);
 
 int feral_strlenn(char *feral, int n);
@@ -50,6 +50,8 @@
 #include "strfunc.h"
 #include "util.h"
 #include "vol_util.h"
+#include "diffuse.h"
+#include "well_mixed.h"
 #include "sym_table.h"
 
 /***  Temporary Viz Options compared to world->viz_options ***/
@@ -115,26 +117,110 @@ static long long frame_iteration(struct volume *world, double iterval,
   }
 }
 
+/*************************************************************************
+visit_all_molecules:
+    Calls visit for every molecule: the ones in the schedulers, the ones
+    parked in unimolecular pools and queues, and the ones held as
+    well-mixed counts, which stand in the snapshot "held".  Nothing is
+    moved and no random numbers are drawn, so writing output does not
+    change the course of the simulation.
+
+        In:  visit - function to call for each molecule
+             data - passed on to visit
+             held - snapshot of the well-mixed molecules (or NULL)
+             n_held - number of molecules in the snapshot
+        Out: none
+**************************************************************************/
+static void visit_all_molecules(struct volume *world,
+                                void (*visit)(struct abstract_molecule *,
+                                              void *),
+                                void *data, struct volume_molecule *held,
+                                int n_held) {
+  for (struct storage_list *slp = world->storage_head; slp != NULL;
+       slp = slp->next) {
+    for (struct schedule_helper *shp = slp->store->timer; shp != NULL;
+         shp = shp->next_scale) {
+      for (int i = -1; i < shp->buf_len; i++) {
+        for (struct abstract_element *aep =
+                 (i < 0) ? shp->current : shp->circ_buf_head[i];
+             aep != NULL; aep = aep->next) {
+          struct abstract_molecule *amp = (struct abstract_molecule *)aep;
+          if (amp->properties != NULL)
+            visit(amp, data);
+        }
+      }
+    }
+    visit_parked_molecules(slp->store, visit, data);
+  }
+
+  for (int i = 0; i < n_held; i++)
+    visit((struct abstract_molecule *)&held[i], data);
+}
+
+/* Where sort_molecules_by_species puts each molecule */
+struct species_sort {
+  struct viz_output_block *vizblk;
+  struct abstract_molecule ***viz_molp;
+  u_int *counts;
+  int include_volume;
+  int include_grid;
+};
+
+/*************************************************************************
+sort_molecule:
+    Adds one molecule to the array of its species.
+
+        In:  struct abstract_molecule *amp - the molecule
+             void *data - the struct species_sort being filled
+        Out: none
+**************************************************************************/
+static void sort_molecule(struct abstract_molecule *amp, void *data) {
+  struct species_sort *sort = (struct species_sort *)data;
+  u_int spec_id = amp->properties->species_id;
+  if (sort->vizblk->species_viz_states[spec_id] == EXCLUDE_OBJ)
+    return;
+
+  if (!sort->include_grid && (amp->flags & TYPE_MASK) != TYPE_VOL)
+    return;
+
+  if (!sort->include_volume && (amp->flags & TYPE_MASK) == TYPE_VOL)
+    return;
+
+  if (sort->counts[spec_id] < amp->properties->population)
+    sort->viz_molp[spec_id][sort->counts[spec_id]++] = amp;
+  else {
+    mcell_warn("Molecule count disagreement!\n"
+               "  Species %s  population = %d  count = %d",
+               amp->properties->sym->name, amp->properties->population,
+               sort->counts[spec_id]);
+  }
+}
+
 /*************************************************************************
 sort_molecules_by_species:
     Scans over all molecules, sorting them into arrays by species.
 
         In:  struct abstract_molecule ****viz_molpp
              u_int  **viz_mol_countp
+             struct volume_molecule **heldp - snapshot of the well-mixed
+                    molecules, which the arrays may point into
              int include_volume - should the lists include vol mols?
              int include_grid - should the lists include surface mols?
         Out: 0 on success, 1 on error; viz_molpp and viz_mol_countp arrays are
-             allocated and filled with sorted data.
+             allocated and filled with sorted data.  *heldp must be freed
+             together with them.
 **************************************************************************/
 static int sort_molecules_by_species(struct volume *world,
                                      struct viz_output_block *vizblk,
                                      struct abstract_molecule ****viz_molpp,
-                                     u_int **viz_mol_countp, int include_volume,
-                                     int include_grid) {
-  struct storage_list *slp;
+                                     u_int **viz_mol_countp,
+                                     struct volume_molecule **heldp,
+                                     int include_volume, int include_grid) {
   u_int *counts;
   int species_index;
 
+  *heldp = NULL;
+
   /* XXX: May leave memory allocated on failure */
   if ((*viz_molpp = (struct abstract_molecule ***)allocate_ptr_array(
            world->n_species)) == NULL)
@@ -173,45 +259,11 @@ static int sort_molecules_by_species(struct volume *world,
   }
 
   /* Sort molecules by species id */
-  for (slp = world->storage_head; slp != NULL; slp = slp->next) {
-    struct storage *sp = slp->store;
-    struct schedule_helper *shp;
-    struct abstract_molecule *amp;
-    int sched_slot_index;
-    for (shp = sp->timer; shp != NULL; shp = shp->next_scale) {
-      for (sched_slot_index = -1; sched_slot_index < shp->buf_len;
-           ++sched_slot_index) {
-        for (amp = (struct abstract_molecule *)((sched_slot_index < 0)
-                                                    ? shp->current
-                                                    : shp->circ_buf_head
-                                                          [sched_slot_index]);
-             amp != NULL; amp = amp->next) {
-          u_int spec_id;
-          if (amp->properties == NULL)
-            continue;
-
-          spec_id = amp->properties->species_id;
-          if (vizblk->species_viz_states[spec_id] == EXCLUDE_OBJ)
-            continue;
-
-          if (!include_grid && (amp->flags & TYPE_MASK) != TYPE_VOL)
-            continue;
-
-          if (!include_volume && (amp->flags & TYPE_MASK) == TYPE_VOL)
-            continue;
-
-          if (counts[spec_id] < amp->properties->population)
-            (*viz_molpp)[spec_id][counts[spec_id]++] = amp;
-          else {
-            mcell_warn("Molecule count disagreement!\n"
-                       "  Species %s  population = %d  count = %d",
-                       amp->properties->sym->name, amp->properties->population,
-                       counts[spec_id]);
-          }
-        }
-      }
-    }
-  }
+  int n_held;
+  *heldp = snapshot_well_mixed(world, &n_held);
+  struct species_sort sort = { vizblk, *viz_molpp, counts, include_volume,
+                               include_grid };
+  visit_all_molecules(world, sort_molecule, &sort, *heldp, n_held);
 
   return 0;
 }
@@ -334,6 +386,65 @@ static int count_time_values(struct volume *world,
   return time_values;
 }
 
+/* Where write_ascii_molecule writes */
+struct ascii_output {
+  struct volume *world;
+  struct viz_output_block *vizblk;
+  FILE *custom_file;
+};
+
+/************************************************************************
+write_ascii_molecule:
+In: amp: a molecule
+    data: the struct ascii_output to write to
+Out: No return value.  The position of the molecule is written, unless its
+     species is excluded from output.
+*************************************************************************/
+static void write_ascii_molecule(struct abstract_molecule *amp, void *data) {
+  struct ascii_output *out = (struct ascii_output *)data;
+  struct volume *world = out->world;
+  struct volume_molecule *mp;
+  struct surface_molecule *gmp;
+  short orient = 0;
+  struct vector3 where, norm;
+
+  int id = out->vizblk->species_viz_states[amp->properties->species_id];
+  if (id == EXCLUDE_OBJ)
+    return;
+
+  if ((amp->properties->flags & NOT_FREE) == 0) {
+    mp = (struct volume_molecule *)amp;
+    where.x = mp->pos.x;
+    where.y = mp->pos.y;
+    where.z = mp->pos.z;
+    norm.x = 0;
+    norm.y = 0;
+    norm.z = 0;
+  } else if ((amp->properties->flags & ON_GRID) != 0) {
+    gmp = (struct surface_molecule *)amp;
+    uv2xyz(&(gmp->s_pos), gmp->grid->surface, &where);
+    orient = gmp->orient;
+    norm.x = orient * gmp->grid->surface->normal.x;
+    norm.y = orient * gmp->grid->surface->normal.y;
+    norm.z = orient * gmp->grid->surface->normal.z;
+  } else
+    return;
+
+  where.x *= world->length_unit;
+  where.y *= world->length_unit;
+  where.z *= world->length_unit;
+  if (id == INCLUDE_OBJ) {
+    /* write name of molecule */
+    fprintf(out->custom_file, "%s %lu %.9g %.9g %.9g %.9g %.9g %.9g\n",
+            amp->properties->sym->name, amp->id, where.x, where.y, where.z,
+            norm.x, norm.y, norm.z);
+  } else {
+    /* write state value of molecule */
+    fprintf(out->custom_file, "%d %lu %.9g %.9g %.9g %.9g %.9g %.9g\n", id,
+            amp->id, where.x, where.y, where.z, norm.x, norm.y, norm.z);
+  }
+}
+
 /************************************************************************
 output_ascii_molecules:
 In: vizblk: VIZ_OUTPUT block for this frame list
@@ -346,19 +457,10 @@ static int output_ascii_molecules(struct volume *world,
                                   struct frame_data_list *fdlp) {
   FILE *custom_file;
   char *cf_name;
-  struct storage_list *slp;
-  struct schedule_helper *shp;
-  struct abstract_element *aep;
-  struct abstract_molecule *amp;
-  struct volume_molecule *mp;
-  struct surface_molecule *gmp;
-  short orient = 0;
 
-  int ndigits, i;
+  int ndigits;
   long long lli;
 
-  struct vector3 where, norm;
-
   no_printf("Output in ASCII mode (molecules only)...\n");
 
   if ((fdlp->type == ALL_MOL_DATA) || (fdlp->type == MOL_POS)) {
@@ -386,59 +488,11 @@ static int output_ascii_molecules(struct volume *world,
     free(cf_name);
     cf_name = NULL;
 
-    for (slp = world->storage_head; slp != NULL; slp = slp->next) {
-      for (shp = slp->store->timer; shp != NULL; shp = shp->next_scale) {
-        for (i = -1; i < shp->buf_len; i++) {
-          for (aep = (i < 0) ? shp->current : shp->circ_buf_head[i];
-               aep != NULL; aep = aep->next) {
-            amp = (struct abstract_molecule *)aep;
-            if (amp->properties == NULL)
-              continue;
-
-            int id = vizblk->species_viz_states[amp->properties->species_id];
-            if (id == EXCLUDE_OBJ)
-              continue;
-
-            if ((amp->properties->flags & NOT_FREE) == 0) {
-              mp = (struct volume_molecule *)amp;
-              where.x = mp->pos.x;
-              where.y = mp->pos.y;
-              where.z = mp->pos.z;
-              norm.x = 0;
-              norm.y = 0;
-              norm.z = 0;
-            } else if ((amp->properties->flags & ON_GRID) != 0) {
-              gmp = (struct surface_molecule *)amp;
-              uv2xyz(&(gmp->s_pos), gmp->grid->surface, &where);
-              orient = gmp->orient;
-              norm.x = orient * gmp->grid->surface->normal.x;
-              norm.y = orient * gmp->grid->surface->normal.y;
-              norm.z = orient * gmp->grid->surface->normal.z;
-            } else
-              continue;
-
-            where.x *= world->length_unit;
-            where.y *= world->length_unit;
-            where.z *= world->length_unit;
-            /*
-                        fprintf(custom_file,"%d %15.8e %15.8e %15.8e
-               %2d\n",id,where.x,where.y,where.z,orient);
-            */
-            if (id == INCLUDE_OBJ) {
-              /* write name of molecule */
-              fprintf(custom_file, "%s %lu %.9g %.9g %.9g %.9g %.9g %.9g\n",
-                      amp->properties->sym->name, amp->id, where.x, where.y,
-                      where.z, norm.x, norm.y, norm.z);
-            } else {
-              /* write state value of molecule */
-              fprintf(custom_file, "%d %lu %.9g %.9g %.9g %.9g %.9g %.9g\n", id,
-                      amp->id, where.x, where.y, where.z, norm.x, norm.y,
-                      norm.z);
-            }
-          }
-        }
-      }
-    }
+    int n_held;
+    struct volume_molecule *held = snapshot_well_mixed(world, &n_held);
+    struct ascii_output out = { world, vizblk, custom_file };
+    visit_all_molecules(world, write_ascii_molecule, &out, held, n_held);
+    free(held);
     fclose(custom_file);
   }
 
@@ -1454,8 +1508,9 @@ static int output_cellblender_molecules(struct volume *world,
     /* Get a list of molecules sorted by species. */
     u_int *viz_mol_count = NULL;
     struct abstract_molecule ***viz_molp = NULL;
+    struct volume_molecule *held = NULL;
     if (sort_molecules_by_species(
-        world, vizblk, &viz_molp, &viz_mol_count, 1, 1)) {
+        world, vizblk, &viz_molp, &viz_mol_count, &held, 1, 1)) {
       fclose(custom_file);
       custom_file = NULL;
       return 1;
@@ -2368,6 +2423,8 @@ static int output_cellblender_molecules(struct volume *world,
     viz_molp = NULL;
     free(viz_mol_count);
     viz_mol_count = NULL;
+    free(held);
+    held = NULL;
 
   } // if ((fdlp->type == ALL_MOL_DATA) || (fdlp->type == MOL_POS)) {
 
@@ -88,6 +88,69 @@ int inside_subvolume(struct vector3 *point, struct subvolume *subvol,
           (point->z <= z_fineparts[subvol->urb.z]));
 }
 
+/*************************************************************************
+find_coarse_partition:
+  In: array of coarse partition boundaries, sorted low to high
+      number of partition boundaries
+      inverse spacing of the inner boundaries, or 0 if they are not evenly
+        spaced
+      coordinate to look up
+  Out: index of the coarse partition holding the coordinate.  This is the
+       same index bisect returns, clamped to the valid partitions.
+  Note: For evenly spaced partitions the index is computed directly and only
+        corrected for roundoff; otherwise the array is bisected.
+*************************************************************************/
+int find_coarse_partition(double *partitions, int n_parts, double inv_width,
+                          double val) {
+  if (inv_width == 0.0) {
+    int i = bisect(partitions, n_parts, val);
+    return (i > n_parts - 2) ? n_parts - 2 : i;
+  }
+
+  /* partitions[0] and partitions[n_parts-1] are the outer bounds of the
+   * world, so the even spacing starts at partitions[1] */
+  int i;
+  double f = (val - partitions[1]) * inv_width;
+  if (!(f >= 0.0))
+    i = 0;
+  else if (f >= n_parts - 3)
+    i = n_parts - 2;
+  else
+    i = 1 + (int)f;
+
+  while (i > 0 && partitions[i] > val)
+    i--;
+  while (i < n_parts - 2 && partitions[i + 1] <= val)
+    i++;
+  return i;
+}
+
+/*************************************************************************
+partition_inv_width:
+  In: array of coarse partition boundaries, sorted low to high
+      number of partition boundaries
+  Out: the inverse spacing of the inner partition boundaries if they are
+       evenly spaced, 0 otherwise
+*************************************************************************/
+static double partition_inv_width(double *partitions, int n_parts) {
+  /* Need at least two inner boundaries to have a spacing */
+  if (n_parts < 4)
+    return 0.0;
+
+  double width = (partitions[n_parts - 2] - partitions[1]) / (n_parts - 3);
+  if (!(width > 0.0))
+    return 0.0;
+
+  /* Automatic partitions are snapped to fine partitions, so allow a little
+   * slack; find_coarse_partition fixes up the computed index anyway */
+  for (int i = 2; i < n_parts - 2; i++) {
+    double expected = partitions[1] + (i - 1) * width;
+    if (fabs(partitions[i] - expected) > UNIFORM_PARTITION_SLACK * width)
+      return 0.0;
+  }
+  return 1.0 / width;
+}
+
 /*************************************************************************
 find_coarse_subvolume:
   In: pointer to vector3
@@ -95,9 +158,12 @@ find_coarse_subvolume:
 *************************************************************************/
 struct subvolume *find_coarse_subvol(struct volume *state,
                                      struct vector3 *loc) {
-  int i = bisect(state->x_partitions, state->nx_parts, loc->x);
-  int j = bisect(state->y_partitions, state->ny_parts, loc->y);
-  int k = bisect(state->z_partitions, state->nz_parts, loc->z);
+  int i = find_coarse_partition(state->x_partitions, state->nx_parts,
+                                state->x_part_inv_width, loc->x);
+  int j = find_coarse_partition(state->y_partitions, state->ny_parts,
+                                state->y_part_inv_width, loc->y);
+  int k = find_coarse_partition(state->z_partitions, state->nz_parts,
+                                state->z_part_inv_width, loc->z);
   return &(state->subvol
                [k + (state->nz_parts - 1) * (j + (state->ny_parts - 1) * i)]);
 }
@@ -105,43 +171,18 @@ struct subvolume *find_coarse_subvol(struct volume *state,
 /*************************************************************************
 traverse_subvol:
   In: pointer to our current subvolume
-      pointer to a vector3 of where we want to be
-      which direction we're traveling to get there
-  Out: subvolume that's closest to where we want to be in our direction
+      which direction we're traveling
+  Out: the adjacent subvolume in that direction, or NULL at the edge of the
+       world
   Note: BSP trees traverse is not yet implemented
 *************************************************************************/
-struct subvolume *traverse_subvol(struct subvolume *here,
-                                  int which, int ny_parts, int nz_parts) {
-  switch (which) {
-  case X_NEG:
-    if (here->world_edge & X_NEG_BIT)
-      return NULL;
-    return here - (nz_parts - 1) * (ny_parts - 1);
-  case X_POS:
-    if (here->world_edge & X_POS_BIT)
-      return NULL;
-    return here + (nz_parts - 1) * (ny_parts - 1);
-  case Y_NEG:
-    if (here->world_edge & Y_NEG_BIT)
-      return NULL;
-    return here - (nz_parts - 1);
-  case Y_POS:
-    if (here->world_edge & Y_POS_BIT)
-      return NULL;
-    return here + (nz_parts - 1);
-  case Z_NEG:
-    if (here->world_edge & Z_NEG_BIT)
-      return NULL;
-    return here - 1;
-  case Z_POS:
-    if (here->world_edge & Z_POS_BIT)
-      return NULL;
-    return here + 1;
-  default:
+struct subvolume *traverse_subvol(struct subvolume *here, int which) {
+  if (which < X_NEG || which > Z_POS) {
     mcell_internal_error(
         "Invalid direction specified in traverse_subvol (dir=%d).", which);
     return NULL;
-  } /* end switch */
+  }
+  return here->neighbor[which];
 }
 
 /*************************************************************************
@@ -222,8 +263,7 @@ next_subvol:
 *************************************************************************/
 struct subvolume *next_subvol(struct vector3 *here, struct vector3 *move,
                               struct subvolume *sv, double *x_fineparts,
-                              double *y_fineparts, double *z_fineparts,
-                              int ny_parts, int nz_parts) {
+                              double *y_fineparts, double *z_fineparts) {
   double dx, dy, dz, tx, ty, tz, t;
   int which;
 
@@ -345,7 +385,7 @@ struct subvolume *next_subvol(struct vector3 *here, struct vector3 *move,
     move->y *= t;
     move->z *= t;
 
-    return traverse_subvol(sv, which, ny_parts, nz_parts);
+    return traverse_subvol(sv, which);
   }
 }
 
@@ -791,9 +831,12 @@ struct volume_molecule *insert_volume_molecule(
   if ((new_vm->properties->flags & COUNT_SOME_MASK) != 0)
     new_vm->flags |= COUNT_ME;
   if (new_vm->properties->flags & (COUNT_CONTENTS | COUNT_ENCLOSED)) {
-    count_region_from_scratch(state, (struct abstract_molecule *)new_vm, NULL,
-                              1, &(new_vm->pos), NULL, new_vm->t,
-                              new_vm->periodic_box);
+    if (state->deferred_counts != NULL)
+      count_batch_add(state->deferred_counts, new_vm);
+    else
+      count_region_from_scratch(state, (struct abstract_molecule *)new_vm,
+                                NULL, 1, &(new_vm->pos), NULL, new_vm->t,
+                                new_vm->periodic_box);
   }
 
   if (schedule_add(sv->local_storage->timer, new_vm))
@@ -865,76 +908,52 @@ struct volume_molecule *migrate_volume_molecule(struct volume_molecule *vm,
   return new_vm;
 }
 
+/*************************************************************************
+region_encloses_point:
+  In: a region
+      the waypoint for the current subvolume
+      bits of regions entered from the waypoint to the release loc.
+      bits of regions exited from the waypoint to the release loc.
+  Out: 1 if the release loc is inside the region, 0 if not.
+*************************************************************************/
+static int region_encloses_point(struct region *r, struct waypoint *wp,
+                                 struct bit_array *in_regions,
+                                 struct bit_array *out_regions) {
+  int idx = r->counting_index;
+  if (idx < 0)
+    return 0;
+
+  if (wp->region_bits != NULL && get_bit(wp->region_bits, idx))
+    return !get_bit(out_regions, idx);
+  return get_bit(in_regions, idx);
+}
+
 /*************************************************************************
 eval_rel_region_3d:
   In: an expression tree containing regions to release on
       the waypoint for the current subvolume
-      a list of regions entered from the waypoint to the release loc.
-      a list of regions exited from the waypoint to the release loc.
+      bits of regions entered from the waypoint to the release loc.
+      bits of regions exited from the waypoint to the release loc.
   Out: 1 if the location chosen satisfies the expression, 0 if not.
 *************************************************************************/
 int eval_rel_region_3d(struct release_evaluator *expr, struct waypoint *wp,
-                       struct region_list *in_regions,
-                       struct region_list *out_regions) {
-  struct region *r;
-  struct region_list *rl;
+                       struct bit_array *in_regions,
+                       struct bit_array *out_regions) {
   int satisfies_l, satisfies_r;
 
-  satisfies_l = 0;
-  if (expr->op & REXP_LEFT_REGION) {
-    r = (struct region *)expr->left;
-    for (rl = wp->regions; rl != NULL; rl = rl->next) {
-      if (rl->reg == r) {
-        satisfies_l = 1;
-        break;
-      }
-    }
-    if (satisfies_l) {
-      for (rl = out_regions; rl != NULL; rl = rl->next) {
-        if (rl->reg == r) {
-          satisfies_l = 0;
-          break;
-        }
-      }
-    } else {
-      for (rl = in_regions; rl != NULL; rl = rl->next) {
-        if (rl->reg == r) {
-          satisfies_l = 1;
-          break;
-        }
-      }
-    }
-  } else
+  if (expr->op & REXP_LEFT_REGION)
+    satisfies_l = region_encloses_point((struct region *)expr->left, wp,
+                                        in_regions, out_regions);
+  else
     satisfies_l = eval_rel_region_3d((struct release_evaluator *)expr->left, wp, in_regions, out_regions);
 
   if (expr->op & REXP_NO_OP)
     return satisfies_l;
 
-  satisfies_r = 0;
-  if (expr->op & REXP_RIGHT_REGION) {
-    r = (struct region *)expr->right;
-    for (rl = wp->regions; rl != NULL; rl = rl->next) {
-      if (rl->reg == r) {
-        satisfies_r = 1;
-        break;
-      }
-    }
-    if (satisfies_r) {
-      for (rl = out_regions; rl != NULL; rl = rl->next) {
-        if (rl->reg == r) {
-          satisfies_r = 0;
-          break;
-        }
-      }
-    } else {
-      for (rl = in_regions; rl != NULL; rl = rl->next) {
-        if (rl->reg == r) {
-          satisfies_r = 1;
-          break;
-        }
-      }
-    }
-  } else
+  if (expr->op & REXP_RIGHT_REGION)
+    satisfies_r = region_encloses_point((struct region *)expr->right, wp,
+                                        in_regions, out_regions);
+  else
     satisfies_r = eval_rel_region_3d((struct release_evaluator *)expr->right, wp, in_regions, out_regions);
 
   if (expr->op & REXP_UNION)
@@ -947,6 +966,36 @@ int eval_rel_region_3d(struct release_evaluator *expr, struct waypoint *wp,
   return 0;
 }
 
+/*************************************************************************
+expression_crosses_boundary:
+  In: an expression tree containing regions to release on
+      bits of the counted regions with walls in a subvolume (may be NULL)
+  Out: 1 if any region of the expression may have walls in the subvolume,
+       0 if every region classifies the whole subvolume the same way as
+       its waypoint.
+*************************************************************************/
+static int expression_crosses_boundary(struct release_evaluator *expr,
+                                       struct bit_array *boundary_bits) {
+  if (boundary_bits == NULL)
+    return 0;
+
+  for (int side = 0; side < 2; side++) {
+    void *operand = side ? expr->right : expr->left;
+    if (side && (expr->op & REXP_NO_OP))
+      break;
+
+    if (expr->op & (side ? REXP_RIGHT_REGION : REXP_LEFT_REGION)) {
+      int idx = ((struct region *)operand)->counting_index;
+      if (idx < 0 || get_bit(boundary_bits, idx))
+        return 1;
+    } else if (expression_crosses_boundary(
+                   (struct release_evaluator *)operand, boundary_bits)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
 /*************************************************************************
 vacuum_inside_regions:
   In: pointer to a release site object
@@ -962,8 +1011,8 @@ static int vacuum_inside_regions(struct volume *state,
                                  struct volume_molecule *vm, int n) {
   struct volume_molecule *mp;
   struct release_region_data *rrd;
-  struct region_list *extra_in, *extra_out;
-  struct region_list *rl, *rl2;
+  struct bit_array *extra_in = state->regions_in_scratch;
+  struct bit_array *extra_out = state->regions_out_scratch;
   struct waypoint *wp;
   struct subvolume *sv = NULL;
   struct mem_helper *mh;
@@ -1002,9 +1051,32 @@ static int vacuum_inside_regions(struct volume *state,
                 &sv->mol_by_species, vm->properties, vm->properties->hashval);
 
         if (psl != NULL) {
+          /* If none of the regions has walls here, the subvolume is either
+           * entirely inside or entirely outside */
+          int whole_sv = -1;
+          wp = &(state->waypoints[this_sv]);
+          if (!expression_crosses_boundary(rrd->expression,
+                                           wp->boundary_bits)) {
+            set_all_bits(extra_in, 0);
+            set_all_bits(extra_out, 0);
+            whole_sv =
+                eval_rel_region_3d(rrd->expression, wp, extra_in, extra_out);
+            if (!whole_sv)
+              continue;
+          }
+
           for (mp = psl->head; mp != NULL; mp = mp->next_v) {
-            extra_in = extra_out = NULL;
-            wp = &(state->waypoints[this_sv]);
+            if (whole_sv >= 0) {
+              vl = (struct void_list *)CHECKED_MEM_GET(mh, "temporary list");
+              vl->data = mp;
+              vl->next = vl_head;
+              vl_head = vl;
+              vl_num++;
+              continue;
+            }
+
+            set_all_bits(extra_in, 0);
+            set_all_bits(extra_out, 0);
             origin = &(wp->loc);
             delta.x = mp->pos.x - origin->x;
             delta.y = mp->pos.y - origin->y;
@@ -1017,36 +1089,11 @@ static int vacuum_inside_regions(struct volume *state,
               if (hitcode != COLLIDE_MISS) {
                 state->ray_polygon_colls++;
 
-                for (rl = wl->this_wall->counting_regions; rl != NULL;
-                     rl = rl->next) {
-                  if (hitcode == COLLIDE_FRONT || hitcode == COLLIDE_BACK) {
-                    rl2 = (struct region_list *)CHECKED_MEM_GET(
-                        sv->local_storage->regl, "region list");
-                    rl2->reg = rl->reg;
-
-                    if (hitcode == COLLIDE_FRONT) {
-                      rl2->next = extra_in;
-                      extra_in = rl2;
-                    } else /*hitcode == COLLIDE_BACK*/
-                    {
-                      rl2->next = extra_out;
-                      extra_out = rl2;
-                    }
-                  }
-                }
-              }
-            }
-
-            for (rl = extra_in; rl != NULL; rl = rl->next) {
-              if (rl->reg == NULL)
-                continue;
-              for (rl2 = extra_out; rl2 != NULL; rl2 = rl2->next) {
-                if (rl2->reg == NULL)
-                  continue;
-                if (rl->reg == rl2->reg) {
-                  rl->reg = NULL;
-                  rl2->reg = NULL;
-                  break;
+                if ((hitcode == COLLIDE_FRONT || hitcode == COLLIDE_BACK) &&
+                    wl->this_wall->counting_region_bits != NULL) {
+                  add_crossed_regions(extra_in, extra_out,
+                                      wl->this_wall->counting_region_bits,
+                                      hitcode);
                 }
               }
             }
@@ -1058,11 +1105,6 @@ static int vacuum_inside_regions(struct volume *state,
               vl_head = vl;
               vl_num++;
             }
-
-            if (extra_in != NULL)
-              mem_put_list(sv->local_storage->regl, extra_in);
-            if (extra_out != NULL)
-              mem_put_list(sv->local_storage->regl, extra_out);
           }
         }
       }
@@ -1101,13 +1143,12 @@ static int is_point_inside_region(struct volume *state,
                                   struct vector3 const *pos,
                                   struct release_evaluator *expression,
                                   struct subvolume *sv) {
-  struct region_list *extra_in = NULL, *extra_out = NULL, *cur_region;
+  struct bit_array *extra_in = state->regions_in_scratch;
+  struct bit_array *extra_out = state->regions_out_scratch;
   struct waypoint *wp;
   struct vector3 delta;
   struct vector3 *origin;
   struct wall_list *wl;
-  int bad_location = 0;
-  int result;
 
   /* If no subvolume hint was given, or the hint is incorrect, find the right
    * subvolume
@@ -1119,6 +1160,13 @@ static int is_point_inside_region(struct volume *state,
 
   /* Find waypoint, compute trajectory from waypoint */
   wp = &(state->waypoints[sv - state->subvol]);
+
+  /* No walls of these regions here: the waypoint classifies the point */
+  set_all_bits(extra_in, 0);
+  set_all_bits(extra_out, 0);
+  if (!expression_crosses_boundary(expression, wp->boundary_bits))
+    return eval_rel_region_3d(expression, wp, extra_in, extra_out);
+
   origin = &(wp->loc);
   delta.x = pos->x - origin->x;
   delta.y = pos->y - origin->y;
@@ -1136,63 +1184,50 @@ static int is_point_inside_region(struct volume *state,
 
       if ((hit_time > -EPS_C && hit_time < EPS_C) ||
           (hit_time > 1.0 - EPS_C && hit_time < 1.0 + EPS_C)) {
-        bad_location = 1;
-        break;
-      }
-
-      for (cur_region = wl->this_wall->counting_regions; cur_region != NULL;
-           cur_region = cur_region->next) {
-        struct region_list *crossed_region =
-            (struct region_list *)CHECKED_MEM_GET(sv->local_storage->regl,
-                                                  "region list");
-        crossed_region->reg = cur_region->reg;
-
-        if (hit_check == COLLIDE_FRONT) {
-          crossed_region->next = extra_in;
-          extra_in = crossed_region;
-        } else if (hit_check == COLLIDE_BACK) {
-          crossed_region->next = extra_out;
-          extra_out = crossed_region;
-        } else {
-          bad_location = 1;
-          break;
-        }
+        return 0;
       }
-    }
-  }
 
-  if (bad_location) {
-    if (extra_in != NULL)
-      mem_put_list(sv->local_storage->regl, extra_in);
-    if (extra_out != NULL)
-      mem_put_list(sv->local_storage->regl, extra_out);
-    return 0;
-  }
-
-  for (cur_region = extra_in; cur_region != NULL;
-       cur_region = cur_region->next) {
-    struct region_list *out_region = NULL;
-    if (cur_region->reg == NULL)
-      continue;
-    for (out_region = extra_out; out_region != NULL;
-         out_region = out_region->next) {
-      if (out_region->reg == NULL)
+      if (wl->this_wall->counting_region_bits == NULL)
         continue;
-      if (cur_region->reg == out_region->reg) {
-        cur_region->reg = NULL;
-        out_region->reg = NULL;
-        break;
-      }
+      if (hit_check != COLLIDE_FRONT && hit_check != COLLIDE_BACK)
+        return 0;
+
+      add_crossed_regions(extra_in, extra_out,
+                          wl->this_wall->counting_region_bits, hit_check);
     }
   }
 
-  result = eval_rel_region_3d(expression, wp, extra_in, extra_out);
+  return eval_rel_region_3d(expression, wp, extra_in, extra_out);
+}
 
-  if (extra_in != NULL)
-    mem_put_list(sv->local_storage->regl, extra_in);
-  if (extra_out != NULL)
-    mem_put_list(sv->local_storage->regl, extra_out);
-  return result;
+/*************************************************************************
+begin_deferred_counts:
+  In: state: MCell simulation state
+      batch: empty batch to collect newly placed molecules in
+  Out: No return value.  Until end_deferred_counts is called, volume
+       molecules inserted into the world are queued in batch instead of
+       being counted one at a time.
+*************************************************************************/
+static void begin_deferred_counts(struct volume *state,
+                                  struct count_batch *batch) {
+  batch->mols = NULL;
+  batch->n_mols = 0;
+  batch->max_mols = 0;
+  state->deferred_counts = batch;
+}
+
+/*************************************************************************
+end_deferred_counts:
+  In: state: MCell simulation state
+      batch: batch passed to begin_deferred_counts
+  Out: No return value.  The queued molecules are counted together and the
+       batch is freed.
+*************************************************************************/
+static void end_deferred_counts(struct volume *state,
+                                struct count_batch *batch) {
+  state->deferred_counts = NULL;
+  count_batch_flush(state, batch);
+  count_batch_destroy(batch);
 }
 
 /*************************************************************************
@@ -1225,6 +1260,8 @@ static int release_inside_regions(struct volume *state,
 
   struct volume_molecule *new_vm = NULL;
   struct subvolume *sv = NULL;
+  struct count_batch batch;
+  begin_deferred_counts(state, &batch);
   while (n > 0) {
     vm->pos.x = rrd->llf.x + (rrd->urb.x - rrd->llf.x) * rng_dbl(state->rng);
     vm->pos.y = rrd->llf.y + (rrd->urb.y - rrd->llf.y) * rng_dbl(state->rng);
@@ -1242,12 +1279,15 @@ static int release_inside_regions(struct volume *state,
     vm->periodic_box->y = rso->periodic_box->y;
     vm->periodic_box->z = rso->periodic_box->z;
     new_vm = insert_volume_molecule(state, vm, new_vm);
-    if (new_vm == NULL)
+    if (new_vm == NULL) {
+      end_deferred_counts(state, &batch);
       return 1;
+    }
 
     n--;
   }
 
+  end_deferred_counts(state, &batch);
   return 0;
 }
 
@@ -1408,14 +1448,19 @@ int release_molecules(struct volume *state, struct release_event_queue *req) {
       vm.pos.z = location[0][2];
 
       struct volume_molecule *vm_guess = NULL;
+      struct count_batch batch;
+      begin_deferred_counts(state, &batch);
       for (int i = 0; i < number; i++) {
         vm_guess = insert_volume_molecule(state, &vm, vm_guess);
-        if (vm_guess == NULL)
+        if (vm_guess == NULL) {
+          end_deferred_counts(state, &batch);
           return 1;
+        }
         vm.periodic_box->x = rso->periodic_box->x;
         vm.periodic_box->y = rso->periodic_box->y;
         vm.periodic_box->z = rso->periodic_box->z;
       }
+      end_deferred_counts(state, &batch);
       if (state->notify->release_events == NOTIFY_FULL) {
         mcell_log("Released %d %s from \"%s\" at iteration %lld.", number,
                   rso->mol_type->sym->name, rso->name, state->current_iterations);
@@ -1472,6 +1517,8 @@ int release_ellipsoid_or_rectcuboid(struct volume *state,
                              rso->release_shape == SHAPE_ELLIPTIC ||
                              rso->release_shape == SHAPE_SPHERICAL_SHELL);
 
+  struct count_batch batch;
+  begin_deferred_counts(state, &batch);
   for (int i = 0; i < number; i++) {
     do /* Pick values in unit square, toss if not in unit circle */
     {
@@ -1511,9 +1558,12 @@ int release_ellipsoid_or_rectcuboid(struct volume *state,
     vm->periodic_box->y = rso->periodic_box->y;
     vm->periodic_box->z = rso->periodic_box->z;
     guess = insert_volume_molecule(state, vm, guess); 
-    if (guess == NULL)
+    if (guess == NULL) {
+      end_deferred_counts(state, &batch);
       return 1;
+    }
   }
+  end_deferred_counts(state, &batch);
   if (state->notify->release_events == NOTIFY_FULL) {
     mcell_log("Released %d %s from \"%s\" at iteration %lld.", number,
               rso->mol_type->sym->name, rso->name, state->current_iterations);
@@ -1539,6 +1589,8 @@ int release_by_list(struct volume *state, struct release_event_queue *req,
   struct release_site_obj *rso = req->release_site;
   struct release_single_molecule *rsm = rso->mol_list;
 
+  struct count_batch batch;
+  begin_deferred_counts(state, &batch);
   for (; rsm != NULL; rsm = rsm->next) {
     double location[1][4];
     location[0][0] = rsm->loc.x + rso->location->x;
@@ -1566,8 +1618,10 @@ int release_by_list(struct volume *state, struct release_event_queue *req,
       if (vm->get_space_step(vm) > 0.0)
         ap->flags |= ACT_DIFFUSE;
       vm_guess = insert_volume_molecule(state, vm, vm_guess);
-      if (vm_guess == NULL)
+      if (vm_guess == NULL) {
+        end_deferred_counts(state, &batch);
         return 1;
+      }
       vm_guess->periodic_box->x = rso->periodic_box->x;
       vm_guess->periodic_box->y = rso->periodic_box->y;
       vm_guess->periodic_box->z = rso->periodic_box->z;
@@ -1605,6 +1659,7 @@ int release_by_list(struct volume *state, struct release_event_queue *req,
       }
     }
   }
+  end_deferred_counts(state, &batch);
   if (state->notify->release_events == NOTIFY_FULL) {
     mcell_log("Released %d molecules from list \"%s\" at iteration %lld.", i,
               rso->name, state->current_iterations);
@@ -1815,6 +1870,13 @@ int set_partitions(struct volume *state) {
     set_user_partitions(state, dfx, dfy, dfz);
   }
 
+  state->x_part_inv_width =
+      partition_inv_width(state->x_partitions, state->nx_parts);
+  state->y_part_inv_width =
+      partition_inv_width(state->y_partitions, state->ny_parts);
+  state->z_part_inv_width =
+      partition_inv_width(state->z_partitions, state->nz_parts);
+
   /* And finally we tell the user what happened */
   if (state->notify->partition_location == NOTIFY_FULL) {
     mcell_log_raw("X partitions: ");
@@ -1877,6 +1939,95 @@ double increase_fine_partition_size(struct volume *state, double *fineparts,
   return df;
 }
 
+/*************************************************************************
+tuned_partition_count:
+  In: simulation state, with the bounding box, walls and species set
+      lower and upper corner of the evenly subdivided region
+      longest extent of that region
+  Out: the number of coarse partitions per axis that minimizes the expected
+       cost of a diffusion step, or 0 if there is nothing to tune for.
+  Note: A molecule taking a step crosses about (step / spacing) partitions
+        per axis, and tests the walls of its subvolume, which are taken to be
+        spread evenly over the subvolumes.  Finer partitions trade more
+        ray-subvolume tests for fewer ray-polygon tests.
+*************************************************************************/
+static int tuned_partition_count(struct volume *state,
+                                 struct vector3 *part_min,
+                                 struct vector3 *part_max, double f_max) {
+  if (!(state->speed_limit > 0.0) || state->n_walls == 0)
+    return 0;
+
+  /* speed_limit is six times the mean displacement along one axis */
+  double step = state->speed_limit / 6.0;
+  double smallest_spacing = 2 * state->rx_radius_3d;
+  double len[3] = { part_max->x - part_min->x, part_max->y - part_min->y,
+                    part_max->z - part_min->z };
+
+  int best_n = 0;
+  double best_cost = GIGANTIC;
+  for (int n = MIN_COARSE_PER_AXIS; n <= MAX_TUNED_PER_AXIS; n += 2) {
+    double crossings = 0.0, cells = 1.0;
+    for (int a = 0; a < 3; a++) {
+      /* Same number of inner partitions set_auto_partitions will use */
+      int in = (int)floor((n - 2) * len[a] / f_max + 0.5);
+      if (in < 2)
+        in = 2;
+      if (len[a] / (in - 1) < smallest_spacing)
+        in = 1 + (int)floor(len[a] / smallest_spacing);
+      if (in < 2)
+        in = 2;
+      crossings += step * (in - 1) / len[a];
+      cells *= in - 1;
+    }
+    double cost = TUNE_RAY_VOXEL_COST * crossings +
+                  TUNE_RAY_POLYGON_COST * state->n_walls / cells;
+    if (cost < best_cost) {
+      best_cost = cost;
+      best_n = n;
+    }
+  }
+  return best_n;
+}
+
+/*************************************************************************
+report_partition_tuning:
+  In: simulation state, after the run
+  Out: none.  The counted ray-subvolume and ray-polygon tests are used to
+       suggest partitions for the next run of the model, written in MDL so
+       they can be pasted into it.
+  Note: Scaling the partition spacing by s changes the subvolume tests by
+        1/s and the polygon tests by s^3, so the cost V/s + P*s^3 is lowest
+        at s = (V / 3P)^(1/4).
+*************************************************************************/
+void report_partition_tuning(struct volume *state) {
+  if (state->ray_voxel_tests == 0 || state->ray_polygon_tests == 0)
+    return;
+
+  double v = TUNE_RAY_VOXEL_COST * (double)state->ray_voxel_tests;
+  double p = TUNE_RAY_POLYGON_COST * (double)state->ray_polygon_tests;
+  double scale = pow(v / (3.0 * p), 0.25);
+
+  mcell_log("Suggested partitions for the next run (spacing scaled by %.3g):",
+            scale);
+  const char *axis_name[3] = { "X", "Y", "Z" };
+  double *partitions[3] = { state->x_partitions, state->y_partitions,
+                            state->z_partitions };
+  int n_parts[3] = { state->nx_parts, state->ny_parts, state->nz_parts };
+  for (int a = 0; a < 3; a++) {
+    /* Only the inner partitions were chosen; the outer two bound the world */
+    if (n_parts[a] < 4)
+      continue;
+    double lo = partitions[a][1];
+    double hi = partitions[a][n_parts[a] - 2];
+    double spacing = scale * (hi - lo) / (n_parts[a] - 3);
+    if (spacing < 2 * state->rx_radius_3d)
+      spacing = 2 * state->rx_radius_3d;
+    mcell_log("  PARTITION_%s = [[%.6g TO %.6g STEP %.6g]]", axis_name[a],
+              lo * state->length_unit, hi * state->length_unit,
+              spacing * state->length_unit);
+  }
+}
+
 void set_auto_partitions(struct volume *state, double steps_min,
                          double steps_max, struct vector3 *part_min,
                          struct vector3 *part_max, double f_max,
@@ -1899,6 +2050,15 @@ void set_auto_partitions(struct volume *state, double steps_min,
     state->ny_parts = state->nz_parts = state->nx_parts;
   }
 
+  if (state->tune_partitions_flag) {
+    int n = tuned_partition_count(state, part_min, part_max, f_max);
+    if (n > 0) {
+      state->nx_parts = state->ny_parts = state->nz_parts = n;
+      if (state->notify->progress_report != NOTIFY_NONE)
+        mcell_log("Tuned automatic partitions: %d per axis.", n);
+    }
+  }
+
   /* Allocate memory for our automatically created partitions */
   state->x_partitions =
       CHECKED_MALLOC_ARRAY(double, state->nx_parts, "x partitions");
@@ -2677,5 +2837,11 @@ void remove_surfmol_from_list(
       prev = sm_list;
     }
   }
+
+  /* Let vacancy searches know if the molecule's tile is free now */
+  if (sm != NULL && sm->grid != NULL &&
+      sm_head == &sm->grid->sm_list[sm->grid_index] &&
+      (*sm_head == NULL || (*sm_head)->sm == NULL))
+    mark_tile_vacant(sm->grid, sm->grid_index);
   return;
 }
@@ -31,13 +31,14 @@ int inside_subvolume(struct vector3 *point, struct subvolume *subvol,
 
 struct subvolume *find_coarse_subvol(struct volume *world, struct vector3 *loc);
 
-struct subvolume *traverse_subvol(struct subvolume *here,
-                                  int which, int ny_parts, int nz_parts);
+int find_coarse_partition(double *partitions, int n_parts, double inv_width,
+                          double val);
+
+struct subvolume *traverse_subvol(struct subvolume *here, int which);
 
 struct subvolume *next_subvol(struct vector3 *here, struct vector3 *move,
                               struct subvolume *sv, double *x_fineparts,
-                              double *y_fineparts, double *z_fineparts,
-                              int ny_parts, int nz_parts);
+                              double *y_fineparts, double *z_fineparts);
 
 struct subvolume *find_subvolume(struct volume *world, struct vector3 *loc,
                                  struct subvolume *guess);
@@ -77,8 +78,8 @@ struct volume_molecule *migrate_volume_molecule(struct volume_molecule *vm,
                                                 struct subvolume *new_sv);
 
 int eval_rel_region_3d(struct release_evaluator *expr, struct waypoint *wp,
-                       struct region_list *in_regions,
-                       struct region_list *out_regions);
+                       struct bit_array *in_regions,
+                       struct bit_array *out_regions);
 
 int release_molecules(struct volume *world, struct release_event_queue *req);
 
@@ -98,6 +99,8 @@ double increase_fine_partition_size(struct volume *state, double *fineparts,
 void set_fineparts(double min, double max, double *partitions,
                    double *fineparts, int n_parts, int in, int start);
 
+void report_partition_tuning(struct volume *state);
+
 void set_auto_partitions(struct volume *state, double steps_min,
                          double steps_max, struct vector3 *part_min,
                          struct vector3 *part_max, double f_max,
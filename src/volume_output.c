@@ -243,14 +243,12 @@ static int produce_mol_counts(struct volume *wrld, FILE *out_file,
 
         /* Advance to next x-partition */
         cur_partition =
-            traverse_subvol(cur_partition, X_POS, wrld->ny_parts,
-                            wrld->nz_parts);
+            traverse_subvol(cur_partition, X_POS);
       }
 
       /* Advance to next y-partition */
       cur_partition_y =
-          traverse_subvol(cur_partition_y, Y_POS, wrld->ny_parts,
-                          wrld->nz_parts);
+          traverse_subvol(cur_partition_y, Y_POS);
     }
 
     /* If the slab crosses a Z boundary, keep on truckin' */
@@ -259,8 +257,7 @@ static int produce_mol_counts(struct volume *wrld, FILE *out_file,
        * spill!
        */
       cur_partition_z =
-          traverse_subvol(cur_partition_z, Z_POS, wrld->ny_parts,
-                          wrld->nz_parts);
+          traverse_subvol(cur_partition_z, Z_POS);
 
       if (cur_partition_z != NULL) {
         z_lim_part = wrld->z_fineparts[cur_partition_z->urb.z];
@@ -63,212 +63,64 @@ static inline double abs_max_2vec(struct vector3 *v1, struct vector3 *v2) {
                max3d(fabs(v2->x), fabs(v2->y), fabs(v2->z)));
 }
 
-// create_new_poly_edge creates a new poly_edge and attaches it to the
-// past pointer to linked list of poly_edges
-static struct poly_edge* create_new_poly_edge(struct poly_edge* list);
-
 // have_common_region checks if wall1 and wall2 located on the (same) object
 // are part of a common region or not
 static bool have_common_region(struct object *obj, int wall1, int wall2);
 
 
 /**************************************************************************\
- ** Edge hash table section--finds common edges in polygons              **
+ ** Edge sorting section--finds common edges in polygons                 **
 \**************************************************************************/
 
 /***************************************************************************
-edge_equals:
-  In: pointers to two poly_edge structs
-  Out: Returns 1 if the edges are the same, 0 otherwise.
-  Note: Orientation invariant, so an edge between vertex 1 and 2
-        is the same as an edge between vertex 2 and 1.
+compare_points:
+  In: two points
+  Out: -1, 0 or 1 as the first point sorts before, with or after the second
+       in lexicographic (x, y, z) order.
 ***************************************************************************/
-
-int edge_equals(struct poly_edge *e1, struct poly_edge *e2) {
-  if ((!distinguishable(e1->v1x, e2->v1x, EPS_C)) &&
-      (!distinguishable(e1->v1y, e2->v1y, EPS_C)) &&
-      (!distinguishable(e1->v1z, e2->v1z, EPS_C)) &&
-      (!distinguishable(e1->v2x, e2->v2x, EPS_C)) &&
-      (!distinguishable(e1->v2y, e2->v2y, EPS_C)) &&
-      (!distinguishable(e1->v2z, e2->v2z, EPS_C))) {
-    return 1;
-  }
-  if ((!distinguishable(e1->v1x, e2->v2x, EPS_C)) &&
-      (!distinguishable(e1->v1y, e2->v2y, EPS_C)) &&
-      (!distinguishable(e1->v1z, e2->v2z, EPS_C)) &&
-      (!distinguishable(e1->v2x, e2->v1x, EPS_C)) &&
-      (!distinguishable(e1->v2y, e2->v1y, EPS_C)) &&
-      (!distinguishable(e1->v2z, e2->v1z, EPS_C))) {
-    return 1;
-  }
+static int compare_points(const struct vector3 *a, const struct vector3 *b) {
+  if (a->x != b->x)
+    return (a->x < b->x) ? -1 : 1;
+  if (a->y != b->y)
+    return (a->y < b->y) ? -1 : 1;
+  if (a->z != b->z)
+    return (a->z < b->z) ? -1 : 1;
   return 0;
 }
 
 /***************************************************************************
-edge_hash:
-  In: pe: pointer to a poly_edge struct
-      nkeys: number of keys in the hash table
-  Out: Returns a hash value between 0 and nkeys-1.
-  Note: Orientation invariant, so a hash with the two endpoints swapped
-        will be the same.
-***************************************************************************/
-
-int edge_hash(struct poly_edge *pe, int nkeys) {
-  /* Get hash of X,Y,Z set of doubles for 1st and 2nd points */
-  /* (Assume they're laid out consecutively in memory) */
-  /* FIXME: This seems like a hack. Since poly_edge is a struct there's no
-   * guarantee what the memory layout will be and the compiler may pad */
-  unsigned int hashL = jenkins_hash((ub1 *)&(pe->v1x), 3 * sizeof(double));
-  unsigned int hashR = jenkins_hash((ub1 *)&(pe->v2x), 3 * sizeof(double));
-
-  return (hashL + hashR) %
-         nkeys; /* ^ is symmetric so doesn't matter which is L and which is R */
-}
-
-/***************************************************************************
-ehtable_init:
-  In: eht: pointer to an edge_hashtable struct
-      nkeys: number of keys that the hash table uses
-  Out: Returns 0 on success, 1 on failure.
-       Hash table is initialized.
-***************************************************************************/
-
-int ehtable_init(struct edge_hashtable *eht, int nkeys) {
-  eht->nkeys = nkeys;
-  eht->stored = 0;
-  eht->distinct = 0;
-  eht->data =
-      CHECKED_MALLOC_ARRAY_NODIE(struct poly_edge, nkeys, "edge hash table");
-  if (eht->data == NULL)
-    return 1;
-
-  for (int i = 0; i < nkeys; i++) {
-    eht->data[i].next = NULL;
-    eht->data[i].n = 0;
-    eht->data[i].face[0] = eht->data[i].face[1] = -1;
-  }
-
-  return 0;
-}
-
-
-/***************************************************************************
- *
- * create_new_poly_edge creates a new poly_edge and attaches it to the
- * past pointer to linked list of poly_edges
- *
- ***************************************************************************/
-struct poly_edge* create_new_poly_edge(struct poly_edge* list) {
-
-  struct poly_edge *pei = CHECKED_MALLOC_STRUCT_NODIE(struct poly_edge, "polygon edge");
-  if (pei == NULL) {
-    return NULL;
-  }
-
-  pei->next = list->next;
-  list->next = pei;
-  pei->n = 0;
-  pei->face[0] = -1;
-  pei->face[1] = -1;
-  pei->edge[0] = -1;
-  pei->edge[1] = -1;
-  return pei;
-}
-
-/***************************************************************************
-ehtable_add:
-  In: pointer to an edge_hashtable struct
-      pointer to the poly_edge to add
-  Out: Returns 0 on success, 1 on failure.
-       Edge is added to the hash table.
+edge_equals:
+  In: pointers to two poly_edge structs
+  Out: Returns 1 if the edges are the same, 0 otherwise.
+  Note: Orientation invariant, since the end points of a poly_edge are
+        stored in sorted order.
 ***************************************************************************/
-int ehtable_add(struct edge_hashtable *eht, struct poly_edge *pe) {
-
-  int i = edge_hash(pe, eht->nkeys);
-  struct poly_edge *pep = &(eht->data[i]);
-
-  while (pep != NULL) {
-    if (pep->n == 0) /* New entry */
-    {
-      pep->n = 1;
-      pep->face[0] = pe->face[0];
-      pep->edge[0] = pe->edge[0];
-      pep->v1x = pe->v1x;
-      pep->v1y = pe->v1y;
-      pep->v1z = pe->v1z;
-      pep->v2x = pe->v2x;
-      pep->v2y = pe->v2y;
-      pep->v2z = pe->v2z;
-      eht->stored++;
-      eht->distinct++;
-      return 0;
-    }
-
-    if (edge_equals(pep, pe)) /* This edge exists already ... */
-    {
-      if (pep->face[1] == -1) /* ...and we're the 2nd one */
-      {
-        pep->face[1] = pe->face[0];
-        pep->edge[1] = pe->edge[0];
-        pep->n++;
-        eht->stored++;
-        return 0;
-      } else /* ...or we're 3rd and need more space */
-      {
-        if (pep->next != NULL) {
-          if (edge_equals(pep->next, pe)) /* Space already there */
-          {
-            pep->n++;
-            pep = pep->next;
-            continue; /* Use space on next loop */
-          }
-        }
-
-        struct poly_edge *pei = create_new_poly_edge(pep);
-        if (pei == NULL) {
-          return 1;
-        }
-        pep->n++;
-        pep = pei;
-        eht->distinct--; /* Not really distinct, just need more space */
-      }
-    } else if (pep->next != NULL) {
-      pep = pep->next;
-    } else { /* Hit end of list, so make space for use next loop. */
-      struct poly_edge *pei = create_new_poly_edge(pep);
-      if (pei == NULL) {
-        return 1;
-      }
-      pep = pei;
-    }
-  }
-
-  return 0;
+int edge_equals(struct poly_edge *e1, struct poly_edge *e2) {
+  return compare_points(&e1->v1, &e2->v1) == 0 &&
+         compare_points(&e1->v2, &e2->v2) == 0;
 }
 
 /***************************************************************************
-ehtable_kill:
-  In: eht: pointer to an edge_hashtable struct
-  Out: No return value.  Hashtable data is deallocated.
-  Note: eht itself is not freed, since it isn't created with ehtable_init.
+compare_poly_edges:
+  In: two poly_edge structs
+  Out: qsort comparison.  Equal edges end up next to each other, in the
+       order of the walls (and edges) they belong to.
 ***************************************************************************/
-void ehtable_kill(struct edge_hashtable *eht) {
-  struct poly_edge *pe;
-
-  for (int i = 0; i < eht->nkeys; i++) {
-    while (eht->data[i].next != NULL) {
-      pe = eht->data[i].next;
-      eht->data[i].next = pe->next;
-      free(pe);
-    }
-  }
-  free(eht->data);
-  eht->data = NULL;
-  eht->nkeys = 0;
+static int compare_poly_edges(const void *a, const void *b) {
+  const struct poly_edge *e1 = (const struct poly_edge *)a;
+  const struct poly_edge *e2 = (const struct poly_edge *)b;
+  int cmp = compare_points(&e1->v1, &e2->v1);
+  if (cmp == 0)
+    cmp = compare_points(&e1->v2, &e2->v2);
+  if (cmp == 0)
+    cmp = (e1->face != e2->face) ? ((e1->face < e2->face) ? -1 : 1) : 0;
+  if (cmp == 0)
+    cmp = (e1->edge != e2->edge) ? ((e1->edge < e2->edge) ? -1 : 1) : 0;
+  return cmp;
 }
 
 /**************************************************************************\
- ** Edge construction section--builds permanent edges from hash table    **
+ ** Edge construction section--builds permanent edges from sorted edges  **
 \**************************************************************************/
 
 /***************************************************************************
@@ -341,102 +193,55 @@ bool have_common_region(struct object *obj, int wall1, int wall2) {
 
 /***************************************************************************
 refine_edge_pairs:
-  In: the head of a linked list of shared edges
-      array of pointers to walls
-  Out: No return value.  The best-matching pair of edges percolates up
-       to be first in the list.  "Best-matching" means that the edge
-       is traversed in different directions by each face, and that the
+  In: p: the edges of the walls sharing one edge, in the order of the walls
+      n: how many walls share the edge
+      faces: array of pointers to walls
+  Out: No return value.  The best-matching pair of edges is swapped into
+       the first two places.  "Best-matching" means that the edge is
+       traversed in different directions by each face, and that the
        normals of the two faces are as divergent as possible.
 ***************************************************************************/
-static void refine_edge_pairs(struct poly_edge *p, struct wall **faces) {
-#define TSWAP(x, y)                                                            \
-  temp = (x);                                                                  \
-  (x) = (y);                                                                   \
-  (y) = temp
-
-  int temp;
-
+static void refine_edge_pairs(struct poly_edge *p, int n, struct wall **faces) {
   double best_align = 2;
   bool share_region = false;
-  struct poly_edge *best_p1 = p, *best_p2 = p;
-  int best_n1 = 1;
-  int best_n2 = 2;
-
-  struct poly_edge *p1 = p;
-  int n1 = 1;
-  while (p1 != NULL && p1->n >= n1) {
-    int wA, eA;
-    if (n1 == 1) {
-      wA = p1->face[0];
-      eA = p1->edge[0];
-    } else {
-      wA = p1->face[1];
-      eA = p1->edge[1];
-    }
+  int best_1 = 0;
+  int best_2 = 1;
 
-    struct poly_edge *p2;
-    int n2;
-    if (n1 == 1) {
-      n2 = n1 + 1;
-      p2 = p1;
-    } else {
-      n2 = 1;
-      p2 = p1->next;
-    }
-    while (p2 != NULL && p2->n >= n2) {
-      int wB, eB;
-      if (n2 == 1) {
-        wB = p2->face[0];
-        eB = p2->edge[0];
-      } else {
-        wB = p2->face[1];
-        eB = p2->edge[1];
-      }
+  for (int n1 = 0; n1 < n; n1++) {
+    int wA = p[n1].face;
+    int eA = p[n1].edge;
 
-      // as soon as we hit an incompatible edge we can break out of the p2 loop
-      // and continue scanning the next p1
-      if (compatible_edges(faces, wA, eA, wB, eB)) {
-        double align = faces[wA]->normal.x * faces[wB]->normal.x +
-                       faces[wA]->normal.y * faces[wB]->normal.y +
-                       faces[wA]->normal.z * faces[wB]->normal.z;
-
-        // as soon as two walls have a common region we only consider walls who
-        // share (any) region. We need to reset the best_align to make sure we
-        // don't pick any wall that don't share a region discovered previously
-        bool common_region = have_common_region(faces[wA]->parent_object, wA, wB);
-        if (common_region) {
-          if (!share_region) {
-            best_align = 2;
-          }
-          share_region = true;
-        }
+    for (int n2 = n1 + 1; n2 < n; n2++) {
+      int wB = p[n2].face;
+      int eB = p[n2].edge;
 
-        if (common_region || !share_region) {
-          if (align < best_align) {
-            best_p1 = p1;
-            best_p2 = p2;
-            best_n1 = n1;
-            best_n2 = n2;
-            best_align = align;
-          }
-        }
-      } else {
+      // as soon as we hit an incompatible edge we can break out of the n2 loop
+      // and continue scanning the next n1
+      if (!compatible_edges(faces, wA, eA, wB, eB))
         break;
-      }
 
-      if (n2 == 1)
-        n2++;
-      else {
-        p2 = p2->next;
-        n2 = 1;
+      double align = faces[wA]->normal.x * faces[wB]->normal.x +
+                     faces[wA]->normal.y * faces[wB]->normal.y +
+                     faces[wA]->normal.z * faces[wB]->normal.z;
+
+      // as soon as two walls have a common region we only consider walls who
+      // share (any) region. We need to reset the best_align to make sure we
+      // don't pick any wall that don't share a region discovered previously
+      bool common_region = have_common_region(faces[wA]->parent_object, wA, wB);
+      if (common_region) {
+        if (!share_region) {
+          best_align = 2;
+        }
+        share_region = true;
       }
-    }
 
-    if (n1 == 1)
-      n1++;
-    else {
-      p1 = p1->next;
-      n1 = 1;
+      if (common_region || !share_region) {
+        if (align < best_align) {
+          best_1 = n1;
+          best_2 = n2;
+          best_align = align;
+        }
+      }
     }
   }
 
@@ -444,12 +249,32 @@ static void refine_edge_pairs(struct poly_edge *p, struct wall **faces) {
   if (best_align > 1.0)
     return; /* No good pairs. */
 
-  TSWAP(best_p1->face[best_n1-1], p->face[0]);
-  TSWAP(best_p1->edge[best_n1-1], p->edge[0]);
-  TSWAP(best_p2->face[best_n2-1], p->face[1]);
-  TSWAP(best_p2->edge[best_n2-1], p->edge[1]);
+  struct poly_edge temp = p[best_1];
+  p[best_1] = p[0];
+  p[0] = temp;
+  temp = p[best_2];
+  p[best_2] = p[1];
+  p[1] = temp;
+}
 
-#undef TSWAP
+/***************************************************************************
+add_free_edge:
+  In: facelist: array of pointers to walls
+      pe: an edge that is not shared with another wall
+  Out: 0 on success, 1 on malloc failure.  The wall gets an edge without a
+       neighbor.
+***************************************************************************/
+static int add_free_edge(struct wall **facelist, struct poly_edge *pe) {
+  struct edge *e = (struct edge *)CHECKED_MEM_GET_NODIE(
+      facelist[pe->face]->birthplace->join, "edge");
+  if (e == NULL)
+    return 1;
+
+  e->forward = facelist[pe->face];
+  e->backward = NULL;
+  /* Don't call init_edge_transform unless both edges are set */
+  facelist[pe->face]->edges[pe->edge] = e;
+  return 0;
 }
 
 /***************************************************************************
@@ -467,88 +292,88 @@ surface_net:
         be any free edges anywhere.)  It is possible to build weird, twisty
         self-intersecting things.  The behavior of these things during a
         simulation is not guaranteed to be well-defined.
+        The edges of all walls are collected in one array and sorted, so
+        that the walls sharing an edge end up next to each other.  Shared
+        edges are then linked two walls at a time, in wall order.
 ***************************************************************************/
 int surface_net(struct wall **facelist, int nfaces) {
   struct edge *e;
   int is_closed = 1;
 
-  struct edge_hashtable eht;
-  int nkeys = (3 * nfaces) / 2;
-  if (ehtable_init(&eht, nkeys))
+  struct poly_edge *edges = CHECKED_MALLOC_ARRAY_NODIE(
+      struct poly_edge, 3 * nfaces + 1, "polygon edges");
+  if (edges == NULL)
     return 1;
 
+  int n_edges = 0;
   for (int i = 0; i < nfaces; i++) {
     if (facelist[i] == NULL)
       continue;
 
-    int k;
-    int nedge = 3;
-    for (int j = 0; j < nedge; j++) {
-
-      if (j + 1 < nedge)
-        k = j + 1;
-      else
-        k = 0;
-
-      struct poly_edge pe;
-      pe.v1x = facelist[i]->vert[j]->x;
-      pe.v1y = facelist[i]->vert[j]->y;
-      pe.v1z = facelist[i]->vert[j]->z;
-      pe.v2x = facelist[i]->vert[k]->x;
-      pe.v2y = facelist[i]->vert[k]->y;
-      pe.v2z = facelist[i]->vert[k]->z;
-      pe.face[0] = i;
-      pe.edge[0] = j;
-
-      if (ehtable_add(&eht, &pe))
-        return 1;
+    for (int j = 0; j < 3; j++) {
+      int k = (j + 1 < 3) ? j + 1 : 0;
+      struct vector3 *v1 = facelist[i]->vert[j];
+      struct vector3 *v2 = facelist[i]->vert[k];
+      struct poly_edge *pe = &edges[n_edges++];
+      if (compare_points(v1, v2) <= 0) {
+        pe->v1 = *v1;
+        pe->v2 = *v2;
+      } else {
+        pe->v1 = *v2;
+        pe->v2 = *v1;
+      }
+      pe->face = i;
+      pe->edge = j;
     }
   }
 
-  for (int i = 0; i < nkeys; i++) {
-    struct poly_edge *pep = (eht.data + i);
-    while (pep != NULL) {
-      if (pep->n > 2) {
-        refine_edge_pairs(pep, facelist);
-      }
-      if (pep->n >= 2) {
-        if (pep->face[0] != -1 && pep->face[1] != -1) {
-          if (compatible_edges(facelist, pep->face[0], pep->edge[0], pep->face[1],
-                               pep->edge[1])) {
-            facelist[pep->face[0]]->nb_walls[pep->edge[0]] = facelist[pep->face[1]];
-            facelist[pep->face[1]]->nb_walls[pep->edge[1]] = facelist[pep->face[0]];
-            e = (struct edge *)CHECKED_MEM_GET_NODIE(
-                facelist[pep->face[0]]->birthplace->join, "edge");
-            if (e == NULL)
-              return 1;
+  qsort(edges, n_edges, sizeof(struct poly_edge), compare_poly_edges);
+
+  int start = 0;
+  while (start < n_edges) {
+    int end = start + 1;
+    while (end < n_edges && edge_equals(&edges[start], &edges[end]))
+      end++;
 
-            e->forward = facelist[pep->face[0]];
-            e->backward = facelist[pep->face[1]];
-            init_edge_transform(e, pep->edge[0]);
-            facelist[pep->face[0]]->edges[pep->edge[0]] = e;
-            facelist[pep->face[1]]->edges[pep->edge[1]] = e;
+    /* Link the walls sharing this edge two at a time.  Once a pair is
+     * linked, the best pair among the remaining walls is linked next. */
+    for (int first = start; first < end; first += 2) {
+      int n = end - first;
+      struct poly_edge *pe = &edges[first];
+      if (n > 2) {
+        refine_edge_pairs(pe, n, facelist);
+      }
+      if (n >= 2) {
+        if (compatible_edges(facelist, pe[0].face, pe[0].edge, pe[1].face,
+                             pe[1].edge)) {
+          facelist[pe[0].face]->nb_walls[pe[0].edge] = facelist[pe[1].face];
+          facelist[pe[1].face]->nb_walls[pe[1].edge] = facelist[pe[0].face];
+          e = (struct edge *)CHECKED_MEM_GET_NODIE(
+              facelist[pe[0].face]->birthplace->join, "edge");
+          if (e == NULL) {
+            free(edges);
+            return 1;
           }
 
-        } else {
-          is_closed = 0;
+          e->forward = facelist[pe[0].face];
+          e->backward = facelist[pe[1].face];
+          init_edge_transform(e, pe[0].edge);
+          facelist[pe[0].face]->edges[pe[0].edge] = e;
+          facelist[pe[1].face]->edges[pe[1].edge] = e;
         }
-      } else if (pep->n == 1) {
+      } else {
         is_closed = 0;
-        e = (struct edge *)CHECKED_MEM_GET_NODIE(
-            facelist[pep->face[0]]->birthplace->join, "edge");
-        if (e == NULL)
+        if (add_free_edge(facelist, pe)) {
+          free(edges);
           return 1;
-
-        e->forward = facelist[pep->face[0]];
-        e->backward = NULL;
-        /* Don't call init_edge_transform unless both edges are set */
-        facelist[pep->face[0]]->edges[pep->edge[0]] = e;
+        }
       }
-      pep = pep->next;
     }
+
+    start = end;
   }
 
-  ehtable_kill(&eht);
+  free(edges);
   return -is_closed; /* We use 1 to indicate malloc failure so return 0/-1 */
 }
 
@@ -1438,6 +1263,8 @@ void init_tri_wall(struct object *objp, int side, struct vector3 *v0,
     w->parent_object = objp;
     w->flags = 0;
     w->counting_regions = NULL;
+    w->counting_region_bits = NULL;
+    w->border_region_bits = NULL;
 
     return;
   }
@@ -1483,6 +1310,8 @@ void init_tri_wall(struct object *objp, int side, struct vector3 *v0,
   w->parent_object = objp;
   w->flags = 0;
   w->counting_regions = NULL;
+  w->counting_region_bits = NULL;
+  w->border_region_bits = NULL;
 }
 
 /***************************************************************************
@@ -1527,26 +1356,6 @@ static void wall_bounding_box(struct wall *w, struct vector3 *llf,
     urb->z = w->vert[2]->z;
 }
 
-/***************************************************************************
-wall_to_vol:
-  In: a wall
-      the subvolume to which the wall belongs
-  Out: The updated list of walls for that subvolume that now contains the
-       wall requested.
-***************************************************************************/
-struct wall_list *wall_to_vol(struct wall *w, struct subvolume *sv) {
-  struct wall_list *wl =
-      (struct wall_list *)CHECKED_MEM_GET_NODIE(sv->local_storage->list, "wall list");
-  if (wl == NULL)
-    return NULL;
-
-  wl->this_wall = w;
-  wl->next = sv->wall_head;
-  sv->wall_head = wl;
-
-  return wl;
-}
-
 /***************************************************************************
 localize_wall:
   In: a wall
@@ -1569,15 +1378,48 @@ struct wall *localize_wall(struct wall *w, struct storage *stor) {
   return ww;
 }
 
+/***************************************************************************
+add_wall_placement:
+  In: placements: wall placements found so far
+      h: index of a subvolume
+      w: localized wall that overlaps subvolume h
+  Out: 0 on success, 1 on memory allocation failure.
+***************************************************************************/
+static int add_wall_placement(struct wall_placements *placements, int h,
+                              struct wall *w) {
+  if (placements->n_placements == placements->max_placements) {
+    int new_max = (placements->max_placements > 0)
+                      ? 2 * placements->max_placements
+                      : 1024;
+    int *new_subvol =
+        (int *)realloc(placements->subvol, new_max * sizeof(int));
+    if (new_subvol == NULL)
+      return 1;
+    placements->subvol = new_subvol;
+    struct wall **new_walls = (struct wall **)realloc(
+        placements->walls, new_max * sizeof(struct wall *));
+    if (new_walls == NULL)
+      return 1;
+    placements->walls = new_walls;
+    placements->max_placements = new_max;
+  }
+  placements->subvol[placements->n_placements] = h;
+  placements->walls[placements->n_placements] = w;
+  placements->n_placements++;
+  return 0;
+}
+
 /***************************************************************************
 distribute_wall:
   In: a wall belonging to an object
+      the wall placements found so far
   Out: A pointer to the wall as copied into appropriate local memory, or
-       NULL on memory allocation error.  Also, the wall is added to the
-       appropriate wall lists for all subvolumes it intersects; if this
-       fails due to memory allocation errors, NULL is also returned.
+       NULL on memory allocation error.  Also, a placement is recorded for
+       all subvolumes the wall intersects; if this fails due to memory
+       allocation errors, NULL is also returned.
 ***************************************************************************/
-static struct wall *distribute_wall(struct volume *world, struct wall *w) {
+static struct wall *distribute_wall(struct volume *world, struct wall *w,
+                                    struct wall_placements *placements) {
   struct wall *where_am_i;       /* Version of the wall in local memory */
   struct vector3 llf, urb, cent; /* Bounding box for wall */
   int x_max, x_min, y_max, y_min, z_max,
@@ -1639,7 +1481,7 @@ static struct wall *distribute_wall(struct volume *world, struct wall *w) {
     if (where_am_i == NULL)
       return NULL;
 
-    if (wall_to_vol(where_am_i, &(world->subvol[h])) == NULL)
+    if (add_wall_placement(placements, h, where_am_i))
       return NULL;
 
     return where_am_i;
@@ -1676,7 +1518,7 @@ static struct wall *distribute_wall(struct volume *world, struct wall *w) {
         urb.z = world->z_fineparts[world->subvol[h].urb.z] + leeway;
 
         if (wall_in_box(w->vert, &(w->normal), w->d, &llf, &urb)) {
-          if (wall_to_vol(where_am_i, &(world->subvol[h])) == NULL)
+          if (add_wall_placement(placements, h, where_am_i))
             return NULL;
         }
       }
@@ -1689,14 +1531,16 @@ static struct wall *distribute_wall(struct volume *world, struct wall *w) {
 /***************************************************************************
 distribute_object:
   In: an object
+      the wall placements found so far
   Out: 0 on success, 1 on memory allocation failure.  The object's walls
-       are copied to local memory and the wall lists in the appropriate
-       subvolumes are set to refer to that wall.  The object's own copy
-       of the wall is deallocated and it is set to point to the new version.
+       are copied to local memory and the subvolumes each wall overlaps
+       are added to placements.  The object's own copy of the wall is
+       deallocated and it is set to point to the new version.
   Note: this function is recursive and is called on any children of the
         object passed to it.
 ***************************************************************************/
-int distribute_object(struct volume *world, struct object *parent) {
+int distribute_object(struct volume *world, struct object *parent,
+                      struct wall_placements *placements) {
   struct object *o; /* Iterator for child objects */
   int i;
   long long vert_index; /* index of the vertex in the global array
@@ -1707,7 +1551,8 @@ int distribute_object(struct volume *world, struct object *parent) {
       if (parent->wall_p[i] == NULL)
         continue; /* Wall removed. */
 
-      parent->wall_p[i] = distribute_wall(world, parent->wall_p[i]);
+      parent->wall_p[i] =
+          distribute_wall(world, parent->wall_p[i], placements);
 
       if (parent->wall_p[i] == NULL)
         mcell_allocfailed("Failed to distribute wall %d on object %s.", i,
@@ -1732,11 +1577,66 @@ int distribute_object(struct volume *world, struct object *parent) {
     }
   } else if (parent->object_type == META_OBJ) {
     for (o = parent->first_child; o != NULL; o = o->next) {
-      if (distribute_object(world, o) != 0)
+      if (distribute_object(world, o, placements) != 0)
+        return 1;
+    }
+  }
+
+  return 0;
+}
+
+/***************************************************************************
+fill_subvolume_wall_lists:
+  In: world: simulation state
+      placements: all wall placements found by distribute_object
+  Out: 0 on success, 1 on memory allocation failure.  The placements are
+       grouped by subvolume with a counting sort, and the wall list of each
+       subvolume is built from consecutive nodes in its local storage.
+  Note: The lists come out in reverse placement order (most recently placed
+        wall first), as when walls were prepended one at a time.
+***************************************************************************/
+static int fill_subvolume_wall_lists(struct volume *world,
+                                     struct wall_placements *placements) {
+  int n = placements->n_placements;
+  int *first = (int *)calloc(world->n_subvols + 1, sizeof(int));
+  struct wall **sorted = (struct wall **)malloc((n + 1) * sizeof(struct wall *));
+  if (first == NULL || sorted == NULL) {
+    free(first);
+    free(sorted);
+    return 1;
+  }
+
+  /* Count placements per subvolume, then turn counts into offsets */
+  for (int p = 0; p < n; p++)
+    first[placements->subvol[p] + 1]++;
+  for (int h = 0; h < world->n_subvols; h++)
+    first[h + 1] += first[h];
+
+  /* Stable scatter, so each subvolume keeps the placement order */
+  for (int p = 0; p < n; p++)
+    sorted[first[placements->subvol[p]]++] = placements->walls[p];
+  for (int h = world->n_subvols; h > 0; h--)
+    first[h] = first[h - 1];
+  first[0] = 0;
+
+  for (int h = 0; h < world->n_subvols; h++) {
+    struct subvolume *sv = &(world->subvol[h]);
+    for (int p = first[h]; p < first[h + 1]; p++) {
+      struct wall_list *wl = (struct wall_list *)CHECKED_MEM_GET_NODIE(
+          sv->local_storage->list, "wall list");
+      if (wl == NULL) {
+        free(first);
+        free(sorted);
         return 1;
+      }
+      wl->this_wall = sorted[p];
+      wl->next = sv->wall_head;
+      sv->wall_head = wl;
     }
   }
 
+  free(first);
+  free(sorted);
   return 0;
 }
 
@@ -1745,16 +1645,28 @@ distribute_world:
   In: No arguments.
   Out: 0 on success, 1 on memory allocation failure.  Every geometric object
        is distributed to local memory and into appropriate subvolumes.
+  Note: This is done in two passes: first every wall is localized and the
+        subvolumes it overlaps are recorded, then the wall lists of all
+        subvolumes are filled at once.
 ***************************************************************************/
 int distribute_world(struct volume *world) {
   struct object *o; /* Iterator for objects in the world */
+  struct wall_placements placements = { NULL, NULL, 0, 0 };
+  int err = 0;
 
   for (o = world->root_instance; o != NULL; o = o->next) {
-    if (distribute_object(world, o) != 0)
-      return 1;
+    if (distribute_object(world, o, &placements) != 0) {
+      err = 1;
+      break;
+    }
   }
 
-  return 0;
+  if (!err)
+    err = fill_subvolume_wall_lists(world, &placements);
+
+  free(placements.subvol);
+  free(placements.walls);
+  return err;
 }
 
 /***************************************************************************
@@ -1955,6 +1867,7 @@ static int vacuum_from_regions(struct volume *world,
                                   -1, NULL, smp->grid->surface, smp->t, NULL);
       smp->properties = NULL;
       p->grid->sm_list[p->index]->sm = NULL;
+      mark_tile_vacant(p->grid, p->index);
       p->grid->n_occupied--;
       if (smp->flags & IN_SCHEDULE) {
         smp->grid->subvol->local_storage->timer->defunct_count++; /* Tally for
@@ -2094,22 +2007,23 @@ int release_onto_regions(struct volume *world, struct release_site_obj *rso,
 
           A = w->area / (w->grid->n_tiles);
 
-          for (unsigned int n_tile = 0; n_tile < w->grid->n_tiles; n_tile++) {
-            if (w->grid->sm_list[n_tile] == NULL || w->grid->sm_list[n_tile]->sm == NULL) {
-              struct reg_rel_helper_data *new_rrd =
-                  (struct reg_rel_helper_data *)CHECKED_MEM_GET_NODIE(mh, "release region helper data");
-              if (new_rrd == NULL)
-                return 1;
+          u_int last_tile = w->grid->n_tiles - 1;
+          for (int n_tile = next_vacant_tile(w->grid, 0, last_tile);
+               n_tile != -1;
+               n_tile = next_vacant_tile(w->grid, n_tile + 1, last_tile)) {
+            struct reg_rel_helper_data *new_rrd =
+                (struct reg_rel_helper_data *)CHECKED_MEM_GET_NODIE(mh, "release region helper data");
+            if (new_rrd == NULL)
+              return 1;
 
-              new_rrd->next = rrhd_head;
-              new_rrd->grid = w->grid;
-              new_rrd->index = n_tile;
-              new_rrd->my_area = A;
-              max_A += A;
+            new_rrd->next = rrhd_head;
+            new_rrd->grid = w->grid;
+            new_rrd->index = n_tile;
+            new_rrd->my_area = A;
+            max_A += A;
 
-              rrhd_head = new_rrd;
-              n_rrhd++;
-            }
+            rrhd_head = new_rrd;
+            n_rrhd++;
           }
         }
       }
@@ -2372,48 +2286,6 @@ int walls_share_full_edge(struct wall *w1, struct wall *w2) {
   return 0;
 }
 
-/***********************************************************************
-find_region_by_wall:
-  In:  wall
-  Out: an object's region list if the wall belongs to one, NULL - otherwise.
-  Note: regions called "ALL" or the ones that have ALL_ELEMENTS are not
-        included in the return "region list".  This is done intentionally
-        since the function is used to determine region border and the
-        above regions do not have region borders.
-************************************************************************/
-struct region_list *find_region_by_wall(struct wall *this_wall) {
-
-  struct region_list *rlp_head = NULL;
-  for (struct region_list *rlp = this_wall->parent_object->regions; rlp != NULL;
-    rlp = rlp->next) {
-
-    struct region *rp = rlp->reg;
-    if ((strcmp(rp->region_last_name, "ALL") == 0) ||
-        (rp->region_has_all_elements))
-      continue;
-
-    if (rp->membership == NULL)
-      mcell_internal_error("Missing region membership for '%s'.",
-                           rp->sym->name);
-
-    if (get_bit(rp->membership, this_wall->side)) {
-      struct region_list *rlps = CHECKED_MALLOC_STRUCT(struct region_list,
-        "region_list");
-      rlps->reg = rp;
-
-      if (rlp_head == NULL) {
-        rlps->next = NULL;
-        rlp_head = rlps;
-      } else {
-        rlps->next = rlp_head;
-        rlp_head = rlps;
-      }
-    }
-  }
-
-  return rlp_head;
-}
-
 /************************************************************************
 find_regions_names_by_wall:
   In:  wall:
@@ -2429,57 +2301,48 @@ struct name_list *find_regions_names_by_wall(
     struct wall *w, struct string_buffer *ignore_regs)
 {
   struct name_list *nl_head = NULL;
-  struct region_list *reg_list_ptr_head = find_region_by_wall(w);
+  if (w->border_region_bits == NULL)
+    return NULL;
 
-  struct region_list *reg_list_ptr;
-  for (reg_list_ptr = reg_list_ptr_head; reg_list_ptr != NULL;) {
-    struct region *reg_ptr = reg_list_ptr->reg;
+  for (struct region_list *rlp = w->parent_object->regions; rlp != NULL;
+       rlp = rlp->next) {
+    struct region *reg_ptr = rlp->reg;
+    if (reg_ptr->border_index < 0 ||
+        !get_bit(w->border_region_bits, reg_ptr->border_index))
+      continue;
 
     // Disregard regions which were just added during a dynamic geometry event
     if ((ignore_regs) && (is_string_present_in_string_array(
-        reg_ptr->sym->name, ignore_regs->strings, ignore_regs->n_strings))) {
-      reg_list_ptr_head = reg_list_ptr->next;
-      free(reg_list_ptr);
-      reg_list_ptr = reg_list_ptr_head;
+        reg_ptr->sym->name, ignore_regs->strings, ignore_regs->n_strings)))
       continue;
-    }
 
     struct name_list *nl = CHECKED_MALLOC_STRUCT(struct name_list, "name_list");
     nl->name = alloc_sprintf("%s", reg_ptr->sym->name);   
     nl->prev = NULL;
-
-    if (nl_head == NULL) {
-      nl->next = NULL;
-      nl_head = nl;
-    }
-    else {
-      nl->next = nl_head;
-      nl_head = nl;
-    }
-    reg_list_ptr_head = reg_list_ptr->next;
-    free(reg_list_ptr);
-    reg_list_ptr = reg_list_ptr_head;
+    nl->next = nl_head;
+    nl_head = nl;
   }
 
   return nl_head;
 }
 
 /***********************************************************************
-find_restricted_regions_by_wall:
-  In: wall
-      surface molecule
-  Out: an object's region list if the wall belongs to the region
-          that is restrictive (REFL/ABSORB) to the surface molecule
-       NULL - if no such regions found
-  Note: regions called "ALL" or the ones that have ALL_ELEMENTS are not
-        included in the return "region list".
+fill_restricted_regions_by_wall:
+  In: world: simulation state
+      this_wall: wall
+      sm: surface molecule
+      bits: bit array of world->n_border_regions bits
+  Out: the number of regions containing the wall that are restrictive
+       (REFL/ABSORB) to the surface molecule.  Their bits are set in
+       "bits"; its contents are undefined if the return value is 0.
 ************************************************************************/
-struct region_list *
-find_restricted_regions_by_wall(struct volume *world, struct wall *this_wall,
-                                struct surface_molecule *sm) {
-
-  if ((sm->properties->flags & CAN_REGION_BORDER) == 0)
-    return NULL;
+int fill_restricted_regions_by_wall(struct volume *world,
+                                    struct wall *this_wall,
+                                    struct surface_molecule *sm,
+                                    struct bit_array *bits) {
+  if ((sm->properties->flags & CAN_REGION_BORDER) == 0 ||
+      this_wall->border_region_bits == NULL)
+    return 0;
 
   struct rxn *matching_rxns[MAX_MATCHING_RXNS];
   for (int kk = 0; kk < MAX_MATCHING_RXNS; kk++) {
@@ -2500,63 +2363,70 @@ find_restricted_regions_by_wall(struct volume *world, struct wall *this_wall,
       restricted_surf_class[num_res++] = matching_rxns[kk]->players[1];
     }
   }
+  if (num_res == 0)
+    return 0;
 
-  struct region *rp;
-  struct region_list *rlp_head = NULL;
-  for (struct region_list *rlp = this_wall->parent_object->regions; rlp != NULL;
-    rlp = rlp->next) {
-    rp = rlp->reg;
-
-    if (rp->membership == NULL) {
-      mcell_internal_error("Missing region membership for '%s'.", rp->sym->name);
-    }
-
-    if (rp->surf_class == NULL) {
+  int count = 0;
+  set_all_bits(bits, 0);
+  for (int idx = next_set_bit(this_wall->border_region_bits, 0); idx >= 0;
+       idx = next_set_bit(this_wall->border_region_bits, idx + 1)) {
+    struct region *rp = world->border_region_index[idx];
+    if (rp->surf_class == NULL)
       continue;
-    }
 
-    if ((strcmp(rp->region_last_name, "ALL") == 0) ||
-        (rp->region_has_all_elements)) {
-      continue;
-    }
-
-    if (get_bit(rp->membership, this_wall->side)) {
-      /* is this region's boundary restricted for surface molecule? */
-      for (int i = 0; i < num_res; ++i) {
-        if (rp->surf_class == restricted_surf_class[i]) {
-          struct region_list *rlps = CHECKED_MALLOC_STRUCT(struct region_list,
-            "region_list");
-          rlps->reg = rp;
-          if (rlp_head == NULL) {
-            rlps->next = NULL;
-            rlp_head = rlps;
-          } else {
-            rlps->next = rlp_head;
-            rlp_head = rlps;
-          }
-          break;
-        }
+    /* is this region's boundary restricted for surface molecule? */
+    for (int i = 0; i < num_res; ++i) {
+      if (rp->surf_class == restricted_surf_class[i]) {
+        set_bit(bits, idx, 1);
+        count++;
+        break;
       }
     }
   }
-  return rlp_head;
+  return count;
+}
+
+/***********************************************************************
+find_restricted_regions_by_wall:
+  In: wall
+      surface molecule
+  Out: a newly allocated bit array (indexed by region->border_index) of
+          the regions containing the wall that are restrictive (REFL/ABSORB)
+          to the surface molecule; release it with free_bit_array
+       NULL - if no such regions found
+  Note: regions called "ALL" or the ones that have ALL_ELEMENTS are not
+        included in the returned regions.
+************************************************************************/
+struct bit_array *
+find_restricted_regions_by_wall(struct volume *world, struct wall *this_wall,
+                                struct surface_molecule *sm) {
+  if (fill_restricted_regions_by_wall(world, this_wall, sm,
+                                      world->restricted_scratch_1) == 0)
+    return NULL;
+
+  struct bit_array *bits = duplicate_bit_array(world->restricted_scratch_1);
+  if (bits == NULL)
+    mcell_allocfailed("Failed to allocate restricted region bits.");
+  return bits;
 }
 
 /***********************************************************************
 find_restricted_regions_by_object:
   In: object
       surface molecule
-  Out: an object's region list that are restrictive (REFL/ABSORB)
-       to the surface molecule
+  Out: a newly allocated bit array (indexed by region->border_index) of
+          the object's regions that are restrictive (REFL/ABSORB) to the
+          surface molecule; release it with free_bit_array
        NULL - if no such regions found
   Note: regions called "ALL" or the ones that have ALL_ELEMENTS are not
-        included in the return "region list".
+        included in the returned regions.
 ************************************************************************/
-struct region_list *
+struct bit_array *
 find_restricted_regions_by_object(struct volume *world, struct object *obj,
                                   struct surface_molecule *sm) {
   struct region *rp;
-  struct region_list *rlp, *rlps, *rlp_head = NULL;
+  struct region_list *rlp;
+  struct bit_array *bits = NULL;
   int kk, i, wall_idx = INT_MIN;
   struct rxn *matching_rxns[MAX_MATCHING_RXNS];
 
@@ -2569,10 +2439,8 @@ find_restricted_regions_by_object(struct volume *world, struct object *obj,
 
   for (rlp = obj->regions; rlp != NULL; rlp = rlp->next) {
     rp = rlp->reg;
-    if ((strcmp(rp->region_last_name, "ALL") == 0) ||
-        (rp->region_has_all_elements)) {
+    if (rp->border_index < 0)
       continue;
-    }
 
     /* find any wall that belongs to this region */
     for (i = 0; i < obj->n_walls; i++) {
@@ -2601,21 +2469,19 @@ find_restricted_regions_by_object(struct volume *world, struct object *obj,
     for (kk = 0; kk < num_matching_rxns; kk++) {
       if ((matching_rxns[kk]->n_pathways == RX_REFLEC) ||
           (matching_rxns[kk]->n_pathways == RX_ABSORB_REGION_BORDER)) {
-        rlps = CHECKED_MALLOC_STRUCT(struct region_list, "region_list");
-        rlps->reg = rp;
-
-        if (rlp_head == NULL) {
-          rlps->next = NULL;
-          rlp_head = rlps;
-        } else {
-          rlps->next = rlp_head;
-          rlp_head = rlps;
+        if (bits == NULL) {
+          bits = new_bit_array(world->n_border_regions);
+          if (bits == NULL)
+            mcell_allocfailed("Failed to allocate restricted region bits.");
+          set_all_bits(bits, 0);
         }
+        set_bit(bits, rp->border_index, 1);
+        break;
       }
     }
   }
 
-  return rlp_head;
+  return bits;
 }
 
 /***********************************************************************
@@ -2677,6 +2543,35 @@ int are_restricted_regions_for_species_on_object(struct volume *world,
   return 0;
 }
 
+/***********************************************************************
+edge_borders_any_region:
+  In: world: simulation state
+      this_wall: wall
+      regions: bit array of regions containing the wall
+      this_edge: one of the wall's edges
+  Out: 1 if the edge is on the border of one of the regions, 0 otherwise.
+************************************************************************/
+static int edge_borders_any_region(struct volume *world,
+                                   struct wall *this_wall,
+                                   struct bit_array *regions,
+                                   struct edge *this_edge) {
+  unsigned int keyhash = (unsigned int)(intptr_t)(this_edge);
+  void *key = (void *)(this_edge);
+
+  for (int idx = next_set_bit(regions, 0); idx >= 0;
+       idx = next_set_bit(regions, idx + 1)) {
+    struct region *rp = world->border_region_index[idx];
+    if (rp->boundaries == NULL)
+      mcell_internal_error("Region '%s' of the object '%s' has no boundaries.",
+                           rp->region_last_name,
+                           this_wall->parent_object->sym->name);
+
+    if (pointer_hash_lookup(rp->boundaries, key, keyhash))
+      return 1;
+  }
+  return 0;
+}
+
 /***********************************************************************
 is_wall_edge_region_border:
   In: wall
@@ -2685,42 +2580,15 @@ is_wall_edge_region_border:
   Note: we do not specify any particular region here, any region will
         suffice
 ************************************************************************/
-int is_wall_edge_region_border(struct wall *this_wall, struct edge *this_edge) {
-  struct region_list *rlp, *rlp_head;
-  struct region *rp;
-  void *key;
-  unsigned int keyhash;
-
-  int is_region_border = 0; /* flag */
-
-  rlp_head = find_region_by_wall(this_wall);
-
+int is_wall_edge_region_border(struct volume *world, struct wall *this_wall,
+                               struct edge *this_edge) {
   /* If this wall is not a part of any region (note that we do not consider
      region called ALL here) */
-  if (rlp_head == NULL)
-    return is_region_border;
-
-  for (rlp = rlp_head; rlp != NULL; rlp = rlp->next) {
-    rp = rlp->reg;
-
-    if (rp->boundaries == NULL)
-      mcell_internal_error("Region '%s' of the object '%s' has no boundaries.",
-                           rp->region_last_name,
-                           this_wall->parent_object->sym->name);
-
-    keyhash = (unsigned int)(intptr_t)(this_edge);
-    key = (void *)(this_edge);
-
-    if (pointer_hash_lookup(rp->boundaries, key, keyhash)) {
-      is_region_border = 1;
-      break;
-    }
-  }
-
-  if (rlp_head != NULL)
-    delete_void_list((struct void_list *)rlp_head);
+  if (this_wall->border_region_bits == NULL)
+    return 0;
 
-  return is_region_border;
+  return edge_borders_any_region(world, this_wall, this_wall->border_region_bits,
+                                 this_edge);
 }
 
 /***********************************************************************
@@ -2737,40 +2605,11 @@ int is_wall_edge_restricted_region_border(struct volume *world,
                                           struct wall *this_wall,
                                           struct edge *this_edge,
                                           struct surface_molecule *sm) {
-  struct region_list *rlp, *rlp_head;
-  struct region *rp;
-  void *key;
-  unsigned int keyhash;
-
-  int is_region_border = 0; /* flag */
-
-  rlp_head = find_restricted_regions_by_wall(world, this_wall, sm);
-
-  /* If this wall is not a part of any region (note that we do not consider
-     region called ALL here) */
-  if (rlp_head == NULL)
-    return is_region_border;
-
-  for (rlp = rlp_head; rlp != NULL; rlp = rlp->next) {
-    rp = rlp->reg;
-    if (rp->boundaries == NULL)
-      mcell_internal_error("Region '%s' of the object '%s' has no boundaries.",
-                           rp->region_last_name,
-                           this_wall->parent_object->sym->name);
-
-    keyhash = (unsigned int)(intptr_t)(this_edge);
-    key = (void *)(this_edge);
-
-    if (pointer_hash_lookup(rp->boundaries, key, keyhash)) {
-      is_region_border = 1;
-      break;
-    }
-  }
-
-  if (rlp_head != NULL)
-    delete_void_list((struct void_list *)rlp_head);
+  struct bit_array *bits = world->restricted_scratch_1;
+  if (fill_restricted_regions_by_wall(world, this_wall, sm, bits) == 0)
+    return 0;
 
-  return is_region_border;
+  return edge_borders_any_region(world, this_wall, bits, this_edge);
 }
 
 /*************************************************************************
@@ -2944,43 +2783,6 @@ int are_walls_coplanar(struct wall *w1, struct wall *w2, double eps) {
   return 0;
 }
 
-/**********************************************************************
-* sorted_insert_wall_aux_list:
-* In: linked list
-*     new node
-* Out: new node is added to the linked list in the sorted order
-***********************************************************************/
-void sorted_insert_wall_aux_list(struct wall_aux_list **headRef,
-                                 struct wall_aux_list *newNode) {
-  /* special case for the head end */
-  if (*headRef == NULL || (*headRef)->d_prod >= newNode->d_prod) {
-    newNode->next = *headRef;
-    *headRef = newNode;
-  } else {
-    /* Locate the node before the point of insertion */
-    struct wall_aux_list *curr = *headRef;
-    while (curr->next != NULL && curr->next->d_prod < newNode->d_prod) {
-      curr = curr->next;
-    }
-    newNode->next = curr->next;
-    curr->next = newNode;
-  }
-}
-
-/*******************************************************************
-delete_wall_aux_list:
-  In: linked list
-  Out: None.  The linked list is deleted and memory is freed.
-*******************************************************************/
-void delete_wall_aux_list(struct wall_aux_list *head) {
-  struct wall_aux_list *nnext;
-  while (head != NULL) {
-    nnext = head->next;
-    free(head);
-    head = nnext;
-  }
-}
-
 /*****************************************************************
 walls_belong_to_at_least_one_different_restricted_region:
   In: wall and surface molecule on it
@@ -2999,122 +2801,57 @@ int walls_belong_to_at_least_one_different_restricted_region(
   if ((w1 == NULL) || (w2 == NULL))
     return 0;
 
-  struct region_list *rl_1 = find_restricted_regions_by_wall(world, w1, sm1);
-  struct region_list *rl_2 = find_restricted_regions_by_wall(world, w2, sm2);
+  struct bit_array *rl_1 = world->restricted_scratch_1;
+  struct bit_array *rl_2 = world->restricted_scratch_2;
+  int n_1 = fill_restricted_regions_by_wall(world, w1, sm1, rl_1);
+  int n_2 = fill_restricted_regions_by_wall(world, w2, sm2, rl_2);
 
-  if ((rl_1 == NULL) && (rl_2 == NULL))
+  if ((n_1 == 0) && (n_2 == 0))
     return 0;
 
-  int error_code = 0;
-  if (rl_1 == NULL) {
-    /* Is wall 1 part of all restricted regions rl_2, then these restricted
-     * regions just encompass wall 1 */
-    if (wall_belongs_to_all_regions_in_region_list(w1, rl_2))
-      error_code = 0;
-    else
-      error_code = 1;
-    delete_region_list(rl_2);
-    return error_code;
-  }
-
-  if (rl_2 == NULL) {
-    /* Is wall 2 part of all restricted regions rl_1, then these restricted
-     * regions just encompass wall 2 */
-    if (wall_belongs_to_all_regions_in_region_list(w2, rl_1))
-      error_code = 0;
-    else
-      error_code = 1;
-    delete_region_list(rl_1);
-    return error_code;
-  }
-
-  for (struct region_list *rl_t1 = rl_1; rl_t1 != NULL; rl_t1 = rl_t1->next) {
-    struct region *rp_1 = rl_t1->reg;
-
-    if (!region_belongs_to_region_list(rp_1, rl_2)) {
-      error_code = 1;
-      break;
-    }
-  }
-
-  delete_region_list(rl_1);
-  delete_region_list(rl_2);
-  return error_code;
-}
-
-/**************************************************************************
-region_belongs_to_region_list:
-  In: region
-      linked list of regions
-  Out: 1 if region is present in the linked list of regions
-       0 otherwise
-***************************************************************************/
-int region_belongs_to_region_list(struct region *rp, struct region_list *head) {
-  int found = 0;
+  /* Is wall 1 part of all restricted regions rl_2, then these restricted
+   * regions just encompass wall 1 */
+  if (n_1 == 0)
+    return !wall_belongs_to_all_regions(w1, rl_2);
 
-  for (struct region_list *rlp = head; rlp != NULL; rlp = rlp->next) {
-    if (rlp->reg == rp)
-      found = 1;
-  }
+  /* Is wall 2 part of all restricted regions rl_1, then these restricted
+   * regions just encompass wall 2 */
+  if (n_2 == 0)
+    return !wall_belongs_to_all_regions(w2, rl_1);
 
-  if (!found)
-    return 0;
-
-  return 1;
+  return !bit_array_contains(rl_2, rl_1);
 }
 
 /*****************************************************************
-wall_belongs_to_all_regions_in_region_list:
+wall_belongs_to_all_regions:
   In: wall
-      region_list
-  Out: 1 if wall belongs to all regions in the region list
-       0 otherwise.
+      bit array of regions, indexed by region->border_index
+  Out: 1 if wall belongs to all regions in the bit array
+       0 otherwise, or if there are no regions.
   Note: Wall can belong to several regions simultaneously.
 ******************************************************************/
-int wall_belongs_to_all_regions_in_region_list(struct wall *this_wall,
-                                               struct region_list *rlp_head) {
-  struct region_list *rlp;
-  struct region *rp;
-
-  if (rlp_head == NULL)
+int wall_belongs_to_all_regions(struct wall *this_wall,
+                                struct bit_array *regions) {
+  if (regions == NULL || this_wall->border_region_bits == NULL)
     return 0;
 
-  for (rlp = rlp_head; rlp != NULL; rlp = rlp->next) {
-    rp = rlp->reg;
-
-    if (!get_bit(rp->membership, this_wall->side))
-      return 0;
-  }
-
-  return 1;
+  return bit_array_contains(this_wall->border_region_bits, regions);
 }
 
 /*****************************************************************
-wall_belongs_to_any_region_in_region_list:
+wall_belongs_to_any_region:
   In: wall
-      region_list
-  Out: 1 if wall belongs to any region in the region list
+      bit array of regions, indexed by region->border_index
+  Out: 1 if wall belongs to any region in the bit array
        0 otherwise.
   Note: Wall can be belong to several regions simultaneously.
-  Note: It is assumed that both wall and region list are defined for
-        the same object.
 ******************************************************************/
-int wall_belongs_to_any_region_in_region_list(struct wall *this_wall,
-                                              struct region_list *rlp_head) {
-  struct region_list *rlp;
-  struct region *rp;
-
-  if (rlp_head == NULL)
+int wall_belongs_to_any_region(struct wall *this_wall,
+                               struct bit_array *regions) {
+  if (regions == NULL || this_wall->border_region_bits == NULL)
     return 0;
 
-  for (rlp = rlp_head; rlp != NULL; rlp = rlp->next) {
-    rp = rlp->reg;
-
-    if (get_bit(rp->membership, this_wall->side))
-      return 1;
-  }
-
-  return 0;
+  return bit_array_intersects(this_wall->border_region_bits, regions);
 }
 
 /*********************************************************************
@@ -3134,3 +2871,377 @@ void find_wall_center(struct wall *w, struct vector3 *center)
   center->z = (w->vert[0]->z + w->vert[1]->z + w->vert[2]->z) / 3;
 
 }
+
+/***************************************************************************
+assign_counting_indices:
+  In: world: simulation state
+      objp: object (or meta object) whose regions should be indexed
+      index: array to store the regions in, or NULL to only count them
+  Out: No return value.  Every counted region of every polygon object below
+       objp receives the next free counting_index.
+***************************************************************************/
+static void assign_counting_indices(struct volume *world, struct object *objp,
+                                    struct region **index) {
+  switch (objp->object_type) {
+  case META_OBJ:
+    for (struct object *child = objp->first_child; child != NULL;
+         child = child->next) {
+      assign_counting_indices(world, child, index);
+    }
+    break;
+
+  case BOX_OBJ:
+  case POLY_OBJ:
+    for (struct region_list *rl = objp->regions; rl != NULL; rl = rl->next) {
+      struct region *rp = rl->reg;
+      rp->counting_index = -1;
+      if ((rp->flags & COUNT_SOME_MASK) == 0 || rp->membership == NULL)
+        continue;
+
+      if (index != NULL) {
+        rp->counting_index = world->n_counting_regions;
+        index[rp->counting_index] = rp;
+      }
+      world->n_counting_regions++;
+    }
+    break;
+
+  default:
+    break;
+  }
+}
+
+/***************************************************************************
+assign_border_indices:
+  In: world: simulation state
+      objp: object (or meta object) whose regions should be indexed
+      index: array to store the regions in, or NULL to only count them
+  Out: No return value.  Every region with a border (all but ALL and
+       ALL_ELEMENTS regions) of every polygon object below objp receives
+       the next free border_index.
+***************************************************************************/
+static void assign_border_indices(struct volume *world, struct object *objp,
+                                  struct region **index) {
+  switch (objp->object_type) {
+  case META_OBJ:
+    for (struct object *child = objp->first_child; child != NULL;
+         child = child->next) {
+      assign_border_indices(world, child, index);
+    }
+    break;
+
+  case BOX_OBJ:
+  case POLY_OBJ:
+    for (struct region_list *rl = objp->regions; rl != NULL; rl = rl->next) {
+      struct region *rp = rl->reg;
+      rp->border_index = -1;
+      if ((strcmp(rp->region_last_name, "ALL") == 0) ||
+          rp->region_has_all_elements || rp->membership == NULL)
+        continue;
+
+      if (index != NULL) {
+        rp->border_index = world->n_border_regions;
+        index[rp->border_index] = rp;
+      }
+      world->n_border_regions++;
+    }
+    break;
+
+  default:
+    break;
+  }
+}
+
+/***************************************************************************
+shared_region_bits:
+  In: world: simulation state
+      known: list of the distinct bit arrays of the current object
+      bits: the bits a wall needs
+  Out: A bit array equal to bits, taken from known or else newly allocated,
+       owned by the world and added to known.  NULL on memory allocation
+       failure.
+***************************************************************************/
+static struct bit_array *shared_region_bits(struct volume *world,
+                                            struct void_list **known,
+                                            struct bit_array *bits) {
+  for (struct void_list *vl = *known; vl != NULL; vl = vl->next) {
+    if (bit_array_equal((struct bit_array *)vl->data, bits))
+      return (struct bit_array *)vl->data;
+  }
+
+  struct bit_array *ba = duplicate_bit_array(bits);
+  struct void_list *owned = CHECKED_MALLOC_STRUCT_NODIE(struct void_list,
+                                                        "region bit array");
+  struct void_list *vl = CHECKED_MALLOC_STRUCT_NODIE(struct void_list,
+                                                     "region bits");
+  if (ba == NULL || owned == NULL || vl == NULL) {
+    free(ba);
+    free(owned);
+    free(vl);
+    return NULL;
+  }
+  owned->data = ba;
+  owned->next = world->region_bits_head;
+  world->region_bits_head = owned;
+  vl->data = ba;
+  vl->next = *known;
+  *known = vl;
+  return ba;
+}
+
+/***************************************************************************
+new_region_bits:
+  In: world: simulation state
+      rl: list of counted regions
+  Out: A newly allocated bit array with the bits of all regions in rl set,
+       or NULL on memory allocation failure.  The array is owned by the
+       world and released by destroy_counting_region_index.
+***************************************************************************/
+struct bit_array *new_region_bits(struct volume *world,
+                                  struct region_list *rl) {
+  struct bit_array *ba = new_bit_array(world->n_counting_regions);
+  struct void_list *vl = CHECKED_MALLOC_STRUCT_NODIE(struct void_list,
+                                                     "region bit array");
+  if (ba == NULL || vl == NULL) {
+    free(ba);
+    free(vl);
+    return NULL;
+  }
+  set_all_bits(ba, 0);
+  for (; rl != NULL; rl = rl->next) {
+    if (rl->reg != NULL && rl->reg->counting_index >= 0)
+      set_bit(ba, rl->reg->counting_index, 1);
+  }
+
+  vl->data = ba;
+  vl->next = world->region_bits_head;
+  world->region_bits_head = vl;
+  return ba;
+}
+
+/***************************************************************************
+set_object_region_bits:
+  In: world: simulation state
+      objp: object (or meta object) whose walls should get region bits
+      count_scratch: bit array of world->n_counting_regions bits
+      border_scratch: bit array of world->n_border_regions bits
+  Out: Zero on success, one on memory allocation failure.  Each counted
+       wall gets counting_region_bits, and each wall in a region with a
+       border gets border_region_bits; walls of one object that are in
+       exactly the same regions share a single bit array.
+***************************************************************************/
+static int set_object_region_bits(struct volume *world, struct object *objp,
+                                  struct bit_array *count_scratch,
+                                  struct bit_array *border_scratch) {
+  if (objp->object_type == META_OBJ) {
+    for (struct object *child = objp->first_child; child != NULL;
+         child = child->next) {
+      if (set_object_region_bits(world, child, count_scratch, border_scratch))
+        return 1;
+    }
+    return 0;
+  }
+  if (objp->object_type != BOX_OBJ && objp->object_type != POLY_OBJ)
+    return 0;
+
+  struct void_list *known = NULL; /* distinct bit arrays of this object */
+  struct bit_array *last_count = NULL;
+  struct bit_array *last_border = NULL;
+  int status = 0;
+  for (int n_wall = 0; n_wall < objp->n_walls; n_wall++) {
+    struct wall *w = objp->wall_p[n_wall];
+    if (w == NULL)
+      continue;
+    w->counting_region_bits = NULL;
+    w->border_region_bits = NULL;
+
+    if (w->counting_regions != NULL) {
+      set_all_bits(count_scratch, 0);
+      for (struct region_list *rl = w->counting_regions; rl != NULL;
+           rl = rl->next) {
+        set_bit(count_scratch, rl->reg->counting_index, 1);
+      }
+
+      /* neighboring walls nearly always share their regions */
+      if (last_count == NULL || !bit_array_equal(last_count, count_scratch))
+        last_count = shared_region_bits(world, &known, count_scratch);
+      if (last_count == NULL) {
+        status = 1;
+        break;
+      }
+      w->counting_region_bits = last_count;
+    }
+
+    int n_border = 0;
+    set_all_bits(border_scratch, 0);
+    for (struct region_list *rl = objp->regions; rl != NULL; rl = rl->next) {
+      if (rl->reg->border_index >= 0 && get_bit(rl->reg->membership, n_wall)) {
+        set_bit(border_scratch, rl->reg->border_index, 1);
+        n_border++;
+      }
+    }
+    if (n_border == 0)
+      continue;
+    if (last_border == NULL || !bit_array_equal(last_border, border_scratch))
+      last_border = shared_region_bits(world, &known, border_scratch);
+    if (last_border == NULL) {
+      status = 1;
+      break;
+    }
+    w->border_region_bits = last_border;
+  }
+
+  delete_void_list(known);
+  return status;
+}
+
+/***************************************************************************
+init_counting_region_index:
+  In: world: simulation state
+  Out: Zero on success, one on memory allocation failure.  Counted regions
+       and regions with borders are numbered densely and walls get bit
+       arrays of those regions, so region membership tests become single
+       bit lookups.
+  Note: must be called after wall regions are initialized.
+***************************************************************************/
+int init_counting_region_index(struct volume *world) {
+  destroy_counting_region_index(world);
+
+  /* count the regions first, then number them */
+  assign_counting_indices(world, world->root_instance, NULL);
+  world->counting_region_index = CHECKED_MALLOC_ARRAY_NODIE(
+      struct region *, world->n_counting_regions + 1, "counted regions");
+  if (world->counting_region_index == NULL)
+    return 1;
+  world->n_counting_regions = 0;
+  assign_counting_indices(world, world->root_instance,
+                          world->counting_region_index);
+
+  assign_border_indices(world, world->root_instance, NULL);
+  world->border_region_index = CHECKED_MALLOC_ARRAY_NODIE(
+      struct region *, world->n_border_regions + 1, "regions with borders");
+  if (world->border_region_index == NULL)
+    return 1;
+  world->n_border_regions = 0;
+  assign_border_indices(world, world->root_instance,
+                        world->border_region_index);
+
+  world->regions_in_scratch = new_bit_array(world->n_counting_regions);
+  world->regions_out_scratch = new_bit_array(world->n_counting_regions);
+  world->restricted_scratch_1 = new_bit_array(world->n_border_regions);
+  world->restricted_scratch_2 = new_bit_array(world->n_border_regions);
+  struct bit_array *count_scratch = new_bit_array(world->n_counting_regions);
+  struct bit_array *border_scratch = new_bit_array(world->n_border_regions);
+  int status = 1;
+  if (world->regions_in_scratch != NULL &&
+      world->regions_out_scratch != NULL &&
+      world->restricted_scratch_1 != NULL &&
+      world->restricted_scratch_2 != NULL && count_scratch != NULL &&
+      border_scratch != NULL) {
+    status = set_object_region_bits(world, world->root_instance,
+                                    count_scratch, border_scratch);
+  }
+  if (count_scratch != NULL)
+    free_bit_array(count_scratch);
+  if (border_scratch != NULL)
+    free_bit_array(border_scratch);
+  return status;
+}
+
+/***************************************************************************
+destroy_counting_region_index:
+  In: world: simulation state
+  Out: No return value.  Frees the region indices and all shared region
+       bit arrays.  Walls and waypoints must not be used with their
+       bit arrays afterwards.
+***************************************************************************/
+void destroy_counting_region_index(struct volume *world) {
+  for (struct void_list *vl = world->region_bits_head; vl != NULL;
+       vl = vl->next) {
+    free_bit_array((struct bit_array *)vl->data);
+  }
+  delete_void_list(world->region_bits_head);
+  world->region_bits_head = NULL;
+
+  free(world->counting_region_index);
+  world->counting_region_index = NULL;
+  world->n_counting_regions = 0;
+  free(world->border_region_index);
+  world->border_region_index = NULL;
+  world->n_border_regions = 0;
+
+  if (world->regions_in_scratch != NULL)
+    free_bit_array(world->regions_in_scratch);
+  if (world->regions_out_scratch != NULL)
+    free_bit_array(world->regions_out_scratch);
+  world->regions_in_scratch = NULL;
+  world->regions_out_scratch = NULL;
+  if (world->restricted_scratch_1 != NULL)
+    free_bit_array(world->restricted_scratch_1);
+  if (world->restricted_scratch_2 != NULL)
+    free_bit_array(world->restricted_scratch_2);
+  world->restricted_scratch_1 = NULL;
+  world->restricted_scratch_2 = NULL;
+}
+
+/***************************************************************************
+wall_in_counting_region:
+  In: w: wall
+      rp: region
+  Out: 1 if the wall belongs to the counted region rp, 0 otherwise.
+***************************************************************************/
+int wall_in_counting_region(struct wall *w, struct region *rp) {
+  if (w->counting_region_bits == NULL || rp->counting_index < 0)
+    return 0;
+  return get_bit(w->counting_region_bits, rp->counting_index);
+}
+
+/***************************************************************************
+add_crossed_regions:
+  In: in_bits: regions entered so far
+      out_bits: regions exited so far
+      region_bits: regions of a wall that was crossed
+      hit_code: COLLIDE_FRONT (entering) or COLLIDE_BACK (leaving)
+  Out: No return value.  in_bits and out_bits are updated with the crossing;
+       entering a region that was previously exited (and vice versa) cancels
+       the earlier crossing.
+***************************************************************************/
+void add_crossed_regions(struct bit_array *in_bits, struct bit_array *out_bits,
+                         struct bit_array *region_bits, int hit_code) {
+  struct bit_array *same, *other;
+  if (hit_code == COLLIDE_FRONT) {
+    same = in_bits;
+    other = out_bits;
+  } else {
+    same = out_bits;
+    other = in_bits;
+  }
+
+  int *ds = &(same->nints) + 1;
+  int *dother = &(other->nints) + 1;
+  int *dr = &(region_bits->nints) + 1;
+  for (int i = 0; i < region_bits->nints; i++) {
+    int cancel = dr[i] & dother[i];
+    dother[i] &= ~cancel;
+    ds[i] |= dr[i] & ~cancel;
+  }
+}
+
+/***************************************************************************
+add_crossed_region:
+  In: in_bits: regions entered so far
+      out_bits: regions exited so far
+      idx: counting_index of the region whose wall was crossed
+      hit_code: COLLIDE_FRONT (entering) or COLLIDE_BACK (leaving)
+  Out: No return value.  Single-region version of add_crossed_regions.
+***************************************************************************/
+void add_crossed_region(struct bit_array *in_bits, struct bit_array *out_bits,
+                        int idx, int hit_code) {
+  struct bit_array *same = (hit_code == COLLIDE_FRONT) ? in_bits : out_bits;
+  struct bit_array *other = (hit_code == COLLIDE_FRONT) ? out_bits : in_bits;
+
+  if (get_bit(other, idx))
+    set_bit(other, idx, 0);
+  else
+    set_bit(same, idx, 1);
+}
@@ -25,36 +25,35 @@
 
 #include "mcell_structs.h"
 
-/* Temporary data stored about an edge of a polygon */
+/* Temporary data stored about an edge of a polygon.  The end points are
+ * kept in lexicographic order, so both walls sharing an edge give the same
+ * end points whichever way they traverse it. */
 struct poly_edge {
-  struct poly_edge *next; /* Next edge in a hash table. */
-
-  double v1x; /* X coord of starting point */
-  double v1y; /* Y coord of starting point */
-  double v1z; /* Z coord of starting point */
-  double v2x; /* X coord of ending point */
-  double v2y; /* Y coord of ending point */
-  double v2z; /* Z coord of ending point */
-
-  int face[2]; /* wall indices on side of edge */
-  int edge[2]; /* which edge of wall1/2 are we? */
-  int n;     /* How many walls share this edge? */
+  struct vector3 v1; /* lesser end point */
+  struct vector3 v2; /* greater end point */
+  int face;          /* index of the wall */
+  int edge;          /* which edge of the wall are we? */
 };
 
-/* Hash table for rapid order-invariant lookup of edges. */
-struct edge_hashtable {
-  struct poly_edge *data; /* Array of polygon edges */
+/* This array element is used in walls overlap test */
+struct wall_aux {
+  struct wall *this_wall; /* wall */
+  double d_prod;          /* dot product of wall's normal and random vector */
+};
 
-  int nkeys;    /* Length of array */
-  int stored;   /* How many things do we have in the table? */
-  int distinct; /* How many of those are distinct? */
+/* Walls found to overlap subvolumes while distributing the world, grouped
+ * by subvolume once all walls have been seen */
+struct wall_placements {
+  int *subvol;         /* Index of the subvolume of each placement */
+  struct wall **walls; /* Localized wall of each placement */
+  int n_placements;    /* How many placements have been found */
+  int max_placements;  /* Allocated length of subvol and walls */
 };
 
-/* This linked list node is used in walls overlap test */
-struct wall_aux_list {
+/* Subvolume containing a wall, used in walls overlap test */
+struct wall_membership {
   struct wall *this_wall; /* wall */
-  double d_prod;          /* dot product of wall's normal and random vector */
-  struct wall_aux_list *next;
+  int subvol;             /* index of a subvolume the wall is listed in */
 };
 
 struct plane {
@@ -65,11 +64,6 @@ struct plane {
 };
 
 int edge_equals(struct poly_edge *e1, struct poly_edge *e2);
-int edge_hash(struct poly_edge *pe, int nkeys);
-
-int ehtable_init(struct edge_hashtable *eht, int nkeys);
-int ehtable_add(struct edge_hashtable *eht, struct poly_edge *pe);
-void ehtable_kill(struct edge_hashtable *eht);
 
 int surface_net(struct wall **facelist, int nfaces);
 void init_edge_transform(struct edge *e, int edgenum);
@@ -104,11 +98,10 @@ int intersect_box(struct vector3 *llf, struct vector3 *urb, struct wall *w);
 void init_tri_wall(struct object *objp, int side, struct vector3 *v0,
                    struct vector3 *v1, struct vector3 *v2);
 
-struct wall_list *wall_to_vol(struct wall *w, struct subvolume *sv);
-
 struct wall *localize_wall(struct wall *w, struct storage *stor);
 
-int distribute_object(struct volume *world, struct object *parent);
+int distribute_object(struct volume *world, struct object *parent,
+                      struct wall_placements *placements);
 
 int distribute_world(struct volume *world);
 
@@ -143,16 +136,19 @@ struct wall_list *find_nbr_walls_shared_one_vertex(struct volume *world,
 
 int walls_share_full_edge(struct wall *w1, struct wall *w2);
 
-struct region_list *find_region_by_wall(struct wall *this_wall);
-
 struct name_list *find_regions_names_by_wall(
     struct wall *w, struct string_buffer *ignore_regs);
 
-struct region_list *
+int fill_restricted_regions_by_wall(struct volume *world,
+                                    struct wall *this_wall,
+                                    struct surface_molecule *sm,
+                                    struct bit_array *bits);
+
+struct bit_array *
 find_restricted_regions_by_wall(struct volume *world, struct wall *this_wall,
                                 struct surface_molecule *sm);
 
-struct region_list *
+struct bit_array *
 find_restricted_regions_by_object(struct volume *world, struct object *obj,
                                   struct surface_molecule *sm);
 
@@ -160,7 +156,8 @@ int are_restricted_regions_for_species_on_object(struct volume *world,
                                                  struct object *obj,
                                                  struct surface_molecule *sm);
 
-int is_wall_edge_region_border(struct wall *this_wall, struct edge *this_edge);
+int is_wall_edge_region_border(struct volume *world, struct wall *this_wall,
+                               struct edge *this_edge);
 
 int is_wall_edge_restricted_region_border(struct volume *world,
                                           struct wall *this_wall,
@@ -180,21 +177,27 @@ int are_walls_coincident(struct wall *w1, struct wall *w2, double eps);
 
 int are_walls_coplanar(struct wall *w1, struct wall *w2, double eps);
 
-void sorted_insert_wall_aux_list(struct wall_aux_list **headRef,
-                                 struct wall_aux_list *newNode);
-
-void delete_wall_aux_list(struct wall_aux_list *head);
-
 int walls_belong_to_at_least_one_different_restricted_region(
     struct volume *world, struct wall *w1, struct surface_molecule *sm1,
     struct wall *w2, struct surface_molecule *sm2);
 
-int wall_belongs_to_all_regions_in_region_list(struct wall *w,
-                                               struct region_list *rlp_head);
-
-int wall_belongs_to_any_region_in_region_list(struct wall *w,
-                                              struct region_list *rlp_head);
+int wall_belongs_to_all_regions(struct wall *w, struct bit_array *regions);
 
-int region_belongs_to_region_list(struct region *rp, struct region_list *head);
+int wall_belongs_to_any_region(struct wall *w, struct bit_array *regions);
 
 void find_wall_center(struct wall *w, struct vector3 *center);
+
+int init_counting_region_index(struct volume *world);
+
+void destroy_counting_region_index(struct volume *world);
+
+struct bit_array *new_region_bits(struct volume *world,
+                                  struct region_list *rl);
+
+int wall_in_counting_region(struct wall *w, struct region *rp);
+
+void add_crossed_regions(struct bit_array *in_bits, struct bit_array *out_bits,
+                         struct bit_array *region_bits, int hit_code);
+
+void add_crossed_region(struct bit_array *in_bits, struct bit_array *out_bits,
+                        int idx, int hit_code);
@@ -0,0 +1,641 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2006-2017 by
+ * The Salk Institute for Biological Studies and
+ * Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ *
+******************************************************************************/
+
+/**************************************************************************\
+** File: well_mixed.c
+**
+** Purpose: Holds selected volume species as molecule counts in subvolumes
+**          which no wall crosses ("bulk" subvolumes). Counts hop between
+**          neighboring bulk subvolumes and react with tau-leaping, once per
+**          iteration. A molecule whose diffusion step ends in a bulk
+**          subvolume is absorbed into the counts; counts which hop into a
+**          subvolume with walls, or which take part in a reaction, become
+**          molecules again.
+**
+**          Absorbed molecules still belong to their species' population
+**          and to the regions enclosing them. Since bulk subvolumes hold no
+**          walls, a count never crosses a region boundary while it is held,
+**          so COUNT statements see the same numbers as without this mode.
+**
+*/
+
+#include "config.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "logging.h"
+#include "mcell_structs.h"
+#include "react.h"
+#include "rng.h"
+#include "vol_util.h"
+#include "well_mixed.h"
+
+/*************************************************************************
+is_bulk_subvol:
+  In: sv: a subvolume
+  Out: 1 if well-mixed species are held as counts in the subvolume, 0
+       otherwise. Subvolumes at the edge of the world extend out to
+       GIGANTIC and never hold counts.
+*************************************************************************/
+static int is_bulk_subvol(struct subvolume *sv) {
+  return sv->wall_head == NULL && sv->world_edge == 0;
+}
+
+/*************************************************************************
+well_mixed_index:
+  In: world: simulation state
+      spec: a well-mixed species
+  Out: index of the species in world->well_mixed_species
+*************************************************************************/
+static int well_mixed_index(struct volume *world, struct species *spec) {
+  for (int i = 0; i < world->n_well_mixed; i++) {
+    if (world->well_mixed_species[i] == spec)
+      return i;
+  }
+  mcell_internal_error("Species '%s' is not held as well-mixed counts.",
+                       spec->sym->name);
+  return -1;
+}
+
+/*************************************************************************
+subvol_width:
+  In: world: simulation state
+      sv: a subvolume
+      axis: 0, 1 or 2 for X, Y or Z
+  Out: width of the subvolume along the axis, in internal units
+*************************************************************************/
+static double subvol_width(struct volume *world, struct subvolume *sv,
+                           int axis) {
+  switch (axis) {
+  case 0:
+    return world->x_fineparts[sv->urb.x] - world->x_fineparts[sv->llf.x];
+  case 1:
+    return world->y_fineparts[sv->urb.y] - world->y_fineparts[sv->llf.y];
+  default:
+    return world->z_fineparts[sv->urb.z] - world->z_fineparts[sv->llf.z];
+  }
+}
+
+/*************************************************************************
+random_point_in_subvol:
+  In: world: simulation state
+      sv: a subvolume
+      pos: place to put the point
+  Out: No return value. pos is set to a uniformly random point of sv.
+*************************************************************************/
+static void random_point_in_subvol(struct volume *world, struct subvolume *sv,
+                                   struct vector3 *pos) {
+  pos->x = world->x_fineparts[sv->llf.x] +
+           rng_dbl(world->rng) * subvol_width(world, sv, 0);
+  pos->y = world->y_fineparts[sv->llf.y] +
+           rng_dbl(world->rng) * subvol_width(world, sv, 1);
+  pos->z = world->z_fineparts[sv->llf.z] +
+           rng_dbl(world->rng) * subvol_width(world, sv, 2);
+}
+
+/*************************************************************************
+place_held_molecule:
+  In: world: simulation state
+      spec: species of the molecule
+      sv: subvolume containing pos
+      pos: where to put the molecule
+      t: time at which the molecule appears
+  Out: the new molecule, scheduled in the scheduler of sv. It was counted
+       while held, so neither the population nor any region count changes.
+*************************************************************************/
+static struct volume_molecule *
+place_held_molecule(struct volume *world, struct species *spec,
+                    struct subvolume *sv, struct vector3 *pos, double t) {
+  struct periodic_image periodic_box = { 0, 0, 0 };
+  return place_volume_product(world, spec, NULL, NULL, NULL, sv, pos, 0, t,
+                              &periodic_box);
+}
+
+/*************************************************************************
+select_well_mixed_species:
+  In: world: simulation state
+  Out: 0 on success, 1 on failure. The species named in
+       world->well_mixed_names which can be held as counts are flagged
+       WELL_MIXED and gathered in world->well_mixed_species. A species is
+       left out, with a warning, if it is not a diffusing volume species,
+       takes part in trimolecular reactions, or reacts with a volume
+       species which is not held as counts.
+*************************************************************************/
+static int select_well_mixed_species(struct volume *world) {
+  char *names = strdup(world->well_mixed_names);
+  if (names == NULL) {
+    mcell_allocfailed("Failed to copy well-mixed species names.");
+    return 1;
+  }
+
+  for (char *name = strtok(names, ","); name != NULL;
+       name = strtok(NULL, ",")) {
+    struct species *spec = NULL;
+    for (int i = 0; i < world->n_species; i++) {
+      if (strcmp(world->species_list[i]->sym->name, name) == 0) {
+        spec = world->species_list[i];
+        break;
+      }
+    }
+    if (spec == NULL) {
+      mcell_error_nodie("Unknown species '%s' given to -mixed_species.", name);
+      free(names);
+      return 1;
+    }
+    if ((spec->flags & NOT_FREE) != 0 || spec->D <= 0 ||
+        (spec->flags & (EXTERNAL_SPECIES | CAN_VOLVOLVOL | CAN_VOLVOLSURF |
+                        CAN_VOLSURFSURF)) != 0) {
+      mcell_warn("Species '%s' is not a diffusing volume species free of "
+                 "trimolecular reactions and will not be held as counts.",
+                 name);
+      continue;
+    }
+    spec->flags |= WELL_MIXED;
+  }
+  free(names);
+
+  /* Leaving out one species may leave out its partners, so repeat until
+   * nothing changes. */
+  int changed = 1;
+  while (changed) {
+    changed = 0;
+    for (int i = 0; i < world->rx_hashsize; i++) {
+      for (struct rxn *rx = world->reaction_hash[i]; rx != NULL;
+           rx = rx->next) {
+        /* Counts react once per iteration, so rates must not change inside
+         * one */
+        if (rx->prob_t != NULL && !rx->rate_changes_scheduled) {
+          for (unsigned int j = 0; j < rx->n_reactants; j++) {
+            if ((rx->players[j]->flags & WELL_MIXED) == 0)
+              continue;
+            mcell_warn("Species '%s' takes part in a reaction whose rate "
+                       "changes inside an iteration and will not be held as "
+                       "counts.", rx->players[j]->sym->name);
+            rx->players[j]->flags &= ~WELL_MIXED;
+            changed = 1;
+          }
+          continue;
+        }
+        if (rx->n_reactants < 2)
+          continue;
+        int n_vol = 0;
+        int n_held = 0;
+        for (unsigned int j = 0; j < rx->n_reactants; j++) {
+          if ((rx->players[j]->flags & NOT_FREE) == 0)
+            n_vol++;
+          if (rx->players[j]->flags & WELL_MIXED)
+            n_held++;
+        }
+        if (n_held == 0 || n_vol < 2 || n_held == n_vol)
+          continue;
+        for (unsigned int j = 0; j < rx->n_reactants; j++) {
+          if ((rx->players[j]->flags & WELL_MIXED) == 0)
+            continue;
+          mcell_warn("Species '%s' reacts with molecules which are not held "
+                     "as counts and will not be held as counts either.",
+                     rx->players[j]->sym->name);
+          rx->players[j]->flags &= ~WELL_MIXED;
+          changed = 1;
+        }
+      }
+    }
+  }
+
+  world->n_well_mixed = 0;
+  for (int i = 0; i < world->n_species; i++) {
+    if (world->species_list[i]->flags & WELL_MIXED)
+      world->n_well_mixed++;
+  }
+  if (world->n_well_mixed == 0)
+    return 0;
+
+  world->well_mixed_species = CHECKED_MALLOC_ARRAY(
+      struct species *, world->n_well_mixed, "well-mixed species");
+  world->well_mixed_unimol = CHECKED_MALLOC_ARRAY(
+      struct rxn *, world->n_well_mixed, "well-mixed unimolecular reactions");
+  int n = 0;
+  for (int i = 0; i < world->n_species; i++) {
+    if (world->species_list[i]->flags & WELL_MIXED) {
+      world->well_mixed_unimol[n] = NULL;
+      world->well_mixed_species[n++] = world->species_list[i];
+    }
+  }
+
+  /* Gather the reactions among held species */
+  int max_pairs = 0;
+  for (int pass = 0; pass < 2; pass++) {
+    world->n_well_mixed_pairs = 0;
+    for (int i = 0; i < world->rx_hashsize; i++) {
+      for (struct rxn *rx = world->reaction_hash[i]; rx != NULL;
+           rx = rx->next) {
+        if ((rx->players[0]->flags & WELL_MIXED) == 0)
+          continue;
+        if (rx->n_reactants == 1) {
+          if (pass == 1)
+            world->well_mixed_unimol[well_mixed_index(
+                world, rx->players[0])] = rx;
+        } else if (rx->n_reactants == 2 &&
+                   (rx->players[1]->flags & WELL_MIXED) != 0) {
+          if (pass == 1) {
+            struct well_mixed_pair *pair =
+                &world->well_mixed_pairs[world->n_well_mixed_pairs];
+            pair->a = well_mixed_index(world, rx->players[0]);
+            pair->b = well_mixed_index(world, rx->players[1]);
+            pair->rx = rx;
+          }
+          world->n_well_mixed_pairs++;
+        }
+      }
+    }
+    if (pass == 0) {
+      max_pairs = world->n_well_mixed_pairs;
+      if (max_pairs > 0)
+        world->well_mixed_pairs = CHECKED_MALLOC_ARRAY(
+            struct well_mixed_pair, max_pairs, "well-mixed reactions");
+    }
+  }
+
+  return 0;
+}
+
+/*************************************************************************
+init_well_mixed:
+  In: world: simulation state
+  Out: 0 on success, 1 on failure. On the first call the species named by
+       -mixed_species are selected; every call (again after the geometry is
+       rebuilt) sets up empty counts for the current subvolumes.
+*************************************************************************/
+int init_well_mixed(struct volume *world) {
+  if (world->well_mixed_names == NULL)
+    return 0;
+
+  if (world->periodic_box_obj != NULL || world->nfsim_flag) {
+    mcell_warn("-mixed_species is not supported with periodic boundaries or "
+               "MCell-R and will be ignored.");
+    free(world->well_mixed_names);
+    world->well_mixed_names = NULL;
+    return 0;
+  }
+
+  if (world->well_mixed_species == NULL &&
+      select_well_mixed_species(world))
+    return 1;
+  if (world->n_well_mixed == 0)
+    return 0;
+
+  free(world->well_mixed_counts);
+  free(world->well_mixed_inflow);
+  size_t n_counts = (size_t)world->n_subvols * world->n_well_mixed;
+  world->well_mixed_counts = CHECKED_MALLOC_ARRAY(int, n_counts,
+                                                  "well-mixed counts");
+  world->well_mixed_inflow = CHECKED_MALLOC_ARRAY(int, n_counts,
+                                                  "well-mixed inflow");
+  memset(world->well_mixed_counts, 0, n_counts * sizeof(int));
+  memset(world->well_mixed_inflow, 0, n_counts * sizeof(int));
+
+  int n_bulk = 0;
+  for (int i = 0; i < world->n_subvols; i++) {
+    if (is_bulk_subvol(&world->subvol[i]))
+      n_bulk++;
+  }
+  if (world->notify->progress_report != NOTIFY_NONE)
+    mcell_log("Holding %d species as counts in %d of %d subvolumes.",
+              world->n_well_mixed, n_bulk, world->n_subvols);
+  return 0;
+}
+
+/*************************************************************************
+well_mixed_absorb:
+  In: world: simulation state
+      vm: a volume molecule which has just finished its diffusion step and
+          is not in the scheduler
+  Out: 1 if the molecule was absorbed into the counts of its subvolume and
+       freed, 0 if it stays a molecule.
+*************************************************************************/
+int well_mixed_absorb(struct volume *world, struct volume_molecule *vm) {
+  if ((vm->properties->flags & WELL_MIXED) == 0 || !is_bulk_subvol(vm->subvol))
+    return 0;
+
+  int sv_index = vm->subvol - world->subvol;
+  world->well_mixed_counts[sv_index * world->n_well_mixed +
+                           well_mixed_index(world, vm->properties)]++;
+
+  vm->subvol->mol_count--;
+  free(vm->periodic_box);
+  vm->periodic_box = NULL;
+  collect_molecule(vm);
+  return 1;
+}
+
+/*************************************************************************
+hop_well_mixed:
+  In: world: simulation state
+      t_start: start of the iteration
+  Out: No return value. Held molecules hop to the six neighbors of their
+       subvolume. Between bulk subvolumes the per-molecule hop rate is
+       D / (w_i * d_ij), where w_i is the width of the source and d_ij the
+       distance between the centers; into a subvolume with walls it is the
+       rate of crossing the shared face, sqrt(D / pi) / w_i, and the
+       molecule reappears just past that face. The numbers of molecules
+       taking each direction are drawn jointly from the count at the start
+       of the iteration (a multinomial draw, as conditional binomials), so
+       no direction is favored.
+*************************************************************************/
+static void hop_well_mixed(struct volume *world, double t_start) {
+  int n = world->n_well_mixed;
+  double d_factor = 1.0e8 * world->time_unit * world->r_length_unit *
+                    world->r_length_unit;
+
+  for (int i = 0; i < world->n_subvols; i++) {
+    struct subvolume *sv = &world->subvol[i];
+    if (!is_bulk_subvol(sv))
+      continue;
+
+    for (int s = 0; s < n; s++) {
+      int *count = &world->well_mixed_counts[i * n + s];
+      if (*count == 0)
+        continue;
+      struct species *spec = world->well_mixed_species[s];
+      double d_int = spec->D * d_factor;
+
+      double rate[6];
+      double total_rate = 0;
+      for (int dir = X_NEG; dir <= Z_POS; dir++) {
+        struct subvolume *nsv = sv->neighbor[dir];
+        int axis = dir / 2;
+        double w = subvol_width(world, sv, axis);
+        if (is_bulk_subvol(nsv))
+          rate[dir] = 2.0 * d_int / (w * (w + subvol_width(world, nsv, axis)));
+        else
+          rate[dir] = sqrt(d_int / MY_PI) / w;
+        total_rate += rate[dir];
+      }
+      if (total_rate <= 0)
+        continue;
+
+      /* Each molecule leaves with probability 1 - exp(-total_rate), through
+       * a direction chosen in proportion to its rate */
+      double p_leave = 1.0 - exp(-total_rate);
+      double p_rest = 1.0;
+      int n_rest = *count;
+      int n_hops[6];
+      for (int dir = X_NEG; dir <= Z_POS; dir++) {
+        double p_dir = p_leave * rate[dir] / total_rate;
+        n_hops[dir] = 0;
+        if (n_rest > 0 && p_rest > 0)
+          n_hops[dir] = binomial_dist(n_rest, p_dir / p_rest,
+                                      rng_dbl(world->rng));
+        n_rest -= n_hops[dir];
+        p_rest -= p_dir;
+      }
+      *count = n_rest;
+
+      for (int dir = X_NEG; dir <= Z_POS; dir++) {
+        if (n_hops[dir] == 0)
+          continue;
+        struct subvolume *nsv = sv->neighbor[dir];
+        int axis = dir / 2;
+        if (is_bulk_subvol(nsv)) {
+          world->well_mixed_inflow[(nsv - world->subvol) * n + s] +=
+              n_hops[dir];
+          continue;
+        }
+
+        /* Put the molecules just past the shared face */
+        for (int h = 0; h < n_hops[dir]; h++) {
+          struct vector3 pos;
+          random_point_in_subvol(world, sv, &pos);
+          double *coord = (axis == 0) ? &pos.x : (axis == 1) ? &pos.y : &pos.z;
+          double *parts = (axis == 0) ? world->x_fineparts
+                        : (axis == 1) ? world->y_fineparts
+                                      : world->z_fineparts;
+          int face = (axis == 0) ? ((dir & 1) ? sv->urb.x : sv->llf.x)
+                   : (axis == 1) ? ((dir & 1) ? sv->urb.y : sv->llf.y)
+                                 : ((dir & 1) ? sv->urb.z : sv->llf.z);
+          double bump = 2 * EPS_C * (1.0 + fabs(parts[face]));
+          *coord = parts[face] + ((dir & 1) ? bump : -bump);
+          place_held_molecule(world, spec, nsv, &pos,
+                              t_start + rng_dbl(world->rng));
+        }
+      }
+    }
+  }
+
+  size_t n_counts = (size_t)world->n_subvols * n;
+  for (size_t i = 0; i < n_counts; i++) {
+    world->well_mixed_counts[i] += world->well_mixed_inflow[i];
+    world->well_mixed_inflow[i] = 0;
+  }
+}
+
+/*************************************************************************
+react_well_mixed:
+  In: world: simulation state
+      t_start: start of the iteration
+  Out: No return value. The reactions of held molecules for one iteration
+       are drawn per subvolume from Poisson distributions. The reactants of
+       each reaction become molecules, the reaction runs through the
+       regular outcome code, and whatever survives or is produced is
+       absorbed again after its next diffusion step.
+*************************************************************************/
+static void react_well_mixed(struct volume *world, double t_start) {
+  int n = world->n_well_mixed;
+  double vol_factor = N_AV * 1.0e-15 * world->length_unit *
+                      world->length_unit * world->length_unit;
+
+  for (int i = 0; i < world->n_subvols; i++) {
+    struct subvolume *sv = &world->subvol[i];
+    if (!is_bulk_subvol(sv))
+      continue;
+    int *counts = &world->well_mixed_counts[i * n];
+
+    for (int s = 0; s < n; s++) {
+      struct rxn *rx = world->well_mixed_unimol[s];
+      if (rx == NULL || counts[s] == 0 || rx->max_fixed_p <= 0)
+        continue;
+      int n_fired = poisson_dist(rx->max_fixed_p * counts[s],
+                                 rng_dbl(world->rng));
+      if (n_fired > counts[s])
+        n_fired = counts[s];
+      counts[s] -= n_fired;
+      for (int f = 0; f < n_fired; f++) {
+        struct vector3 pos;
+        double t = t_start + rng_dbl(world->rng);
+        random_point_in_subvol(world, sv, &pos);
+        struct abstract_molecule *am = (struct abstract_molecule *)
+            place_held_molecule(world, rx->players[0], sv, &pos, t);
+        int path = which_unimolecular(rx, am, world->rng);
+        outcome_unimolecular(world, rx, path, am, t);
+      }
+    }
+
+    if (world->n_well_mixed_pairs == 0)
+      continue;
+    double volume = subvol_width(world, sv, 0) * subvol_width(world, sv, 1) *
+                    subvol_width(world, sv, 2) * vol_factor;
+
+    for (int p = 0; p < world->n_well_mixed_pairs; p++) {
+      struct well_mixed_pair *pair = &world->well_mixed_pairs[p];
+      struct rxn *rx = pair->rx;
+      if (counts[pair->a] == 0 || counts[pair->b] == 0 ||
+          rx->max_fixed_p <= 0 || rx->pb_factor <= 0)
+        continue;
+
+      double n_pairs;
+      int max_fired;
+      if (pair->a == pair->b) {
+        n_pairs = 0.5 * counts[pair->a] * (counts[pair->a] - 1.0);
+        max_fired = counts[pair->a] / 2;
+      } else {
+        n_pairs = (double)counts[pair->a] * counts[pair->b];
+        max_fired = (counts[pair->a] < counts[pair->b]) ? counts[pair->a]
+                                                        : counts[pair->b];
+      }
+      double rate =
+          rx->max_fixed_p / rx->pb_factor * world->time_unit / volume;
+      int n_fired = poisson_dist(rate * n_pairs, rng_dbl(world->rng));
+      if (n_fired > max_fired)
+        n_fired = max_fired;
+      counts[pair->a] -= n_fired;
+      counts[pair->b] -= n_fired;
+
+      for (int f = 0; f < n_fired; f++) {
+        struct vector3 pos;
+        double t = t_start + rng_dbl(world->rng);
+        random_point_in_subvol(world, sv, &pos);
+        struct abstract_molecule *reacA = (struct abstract_molecule *)
+            place_held_molecule(world, rx->players[0], sv, &pos, t);
+        struct abstract_molecule *reacB = (struct abstract_molecule *)
+            place_held_molecule(world, rx->players[1], sv, &pos, t);
+        int path = which_unimolecular(rx, reacA, world->rng);
+        outcome_bimolecular(world, rx, path, reacA, reacB, 0, 0, t, &pos,
+                            NULL);
+      }
+    }
+  }
+}
+
+/*************************************************************************
+run_well_mixed:
+  In: world: simulation state
+      t_start: start of the iteration about to run
+  Out: No return value. Held molecules are advanced by one iteration.
+*************************************************************************/
+void run_well_mixed(struct volume *world, double t_start) {
+  if (world->n_well_mixed == 0 || world->well_mixed_counts == NULL)
+    return;
+  hop_well_mixed(world, t_start);
+  react_well_mixed(world, t_start);
+}
+
+/*************************************************************************
+release_well_mixed:
+  In: world: simulation state
+  Out: No return value. Every held molecule becomes a molecule again at a
+       random point of its subvolume, so that checkpoints and geometry
+       changes see all of them.
+*************************************************************************/
+void release_well_mixed(struct volume *world) {
+  if (world->n_well_mixed == 0 || world->well_mixed_counts == NULL)
+    return;
+
+  int n = world->n_well_mixed;
+  for (int i = 0; i < world->n_subvols; i++) {
+    for (int s = 0; s < n; s++) {
+      int *count = &world->well_mixed_counts[i * n + s];
+      for (; *count > 0; (*count)--) {
+        struct vector3 pos;
+        random_point_in_subvol(world, &world->subvol[i], &pos);
+        place_held_molecule(world, world->well_mixed_species[s],
+                            &world->subvol[i], &pos,
+                            world->current_iterations);
+      }
+    }
+  }
+}
+
+/*************************************************************************
+snapshot_well_mixed:
+  In: world: simulation state
+      n_mols: place to put the number of molecules returned
+  Out: a newly allocated array with one volume molecule per held molecule,
+       or NULL if nothing is held. The molecules are spread through their
+       subvolumes along a fixed low-discrepancy sequence rather than at
+       random points, so that output can show them without drawing random
+       numbers or changing the counts. They are not scheduled or counted;
+       free the array when done.
+*************************************************************************/
+struct volume_molecule *snapshot_well_mixed(struct volume *world,
+                                            int *n_mols) {
+  *n_mols = 0;
+  if (world->n_well_mixed == 0 || world->well_mixed_counts == NULL)
+    return NULL;
+
+  int n = world->n_well_mixed;
+  size_t n_counts = (size_t)world->n_subvols * n;
+  int n_held = 0;
+  for (size_t i = 0; i < n_counts; i++)
+    n_held += world->well_mixed_counts[i];
+  if (n_held == 0)
+    return NULL;
+
+  struct volume_molecule *mols = CHECKED_MALLOC_ARRAY(
+      struct volume_molecule, n_held, "snapshot of well-mixed molecules");
+  memset(mols, 0, n_held * sizeof(struct volume_molecule));
+
+  /* Additive recurrence on the inverse powers of the plastic number, which
+   * fills the unit cube evenly for any number of points */
+  const double g = 1.22074408460575947536;
+  const double step[3] = { 1.0 / g, 1.0 / (g * g), 1.0 / (g * g * g) };
+
+  int m = 0;
+  for (int i = 0; i < world->n_subvols; i++) {
+    struct subvolume *sv = &world->subvol[i];
+    for (int s = 0; s < n; s++) {
+      int count = world->well_mixed_counts[i * n + s];
+      for (int k = 0; k < count; k++, m++) {
+        struct volume_molecule *vm = &mols[m];
+        double u[3];
+        for (int axis = 0; axis < 3; axis++) {
+          u[axis] = 0.5 + (k + 1) * step[axis];
+          u[axis] -= floor(u[axis]);
+        }
+        vm->pos.x = world->x_fineparts[sv->llf.x] +
+                    u[0] * subvol_width(world, sv, 0);
+        vm->pos.y = world->y_fineparts[sv->llf.y] +
+                    u[1] * subvol_width(world, sv, 1);
+        vm->pos.z = world->z_fineparts[sv->llf.z] +
+                    u[2] * subvol_width(world, sv, 2);
+        vm->properties = world->well_mixed_species[s];
+        vm->flags = TYPE_VOL | IN_VOLUME;
+        vm->t = world->current_iterations;
+        vm->subvol = sv;
+      }
+    }
+  }
+
+  *n_mols = n_held;
+  return mols;
+}
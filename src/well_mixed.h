@@ -0,0 +1,40 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2006-2017 by
+ * The Salk Institute for Biological Studies and
+ * Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ *
+******************************************************************************/
+
+#pragma once
+
+#include "mcell_structs.h"
+
+/* header file for well_mixed.c, holding selected volume species as counts in
+ * subvolumes without walls */
+
+int init_well_mixed(struct volume *world);
+
+int well_mixed_absorb(struct volume *world, struct volume_molecule *vm);
+
+void run_well_mixed(struct volume *world, double t_start);
+
+void release_well_mixed(struct volume *world);
+
+struct volume_molecule *snapshot_well_mixed(struct volume *world,
+                                            int *n_mols);